@@ -103,7 +103,7 @@ simulation_thread(void *param)
 	ccfg_fetch(cfg, "sim", "coordinates");
 	for (unsigned int i = 0; i < 3 && ccfg_iterate(cfg); i++)
 	{
-		coords[i] = strtoul(ccfg_resource(cfg), NULL, 0);
+		coords[i] = ccfg_resource_long(cfg, NULL);
 	}
 
 	/* Simulator algorithm */
@@ -0,0 +1,147 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#include <cassette/ccfg.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#define N_READERS     8
+#define N_GENERATIONS 5
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+static void *reader_thread (void *param);
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+static ccfg_slot *slot = CCFG_SLOT_PLACEHOLDER;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static const char *data =
+	"LET gen ($$ generation)\n"
+	"server generation ($ gen)\n"
+	"server mirror ($ gen)";
+
+/************************************************************************************************************/
+/* MAIN *****************************************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * In this 4th example, a single configuration is shared between several reader threads. Instead of having
+ * every thread parse its own config like in the 3rd example, the main thread loads the config, takes an
+ * immutable snapshot of it, and publishes it into a slot. Reader threads acquire the published snapshot
+ * whenever they need it and read from it with their own cursor, without any locking.
+ *
+ * Meanwhile, the main thread keeps reloading the config and publishing new snapshots. Readers that hold an
+ * older snapshot can keep on using it until they release it, and the values they read from a given snapshot
+ * are always consistent with each other.
+ */
+
+int
+main(void)
+{
+	pthread_t threads[N_READERS];
+	ccfg_snapshot *snapshot;
+	ccfg *cfg;
+
+	/* Setup */
+
+	cfg  = ccfg_create();
+	slot = ccfg_slot_create();
+
+	for (size_t i = 0; i < N_READERS; i++)
+	{
+		pthread_create(threads + i, NULL, reader_thread, NULL);
+	}
+
+	/* Reload and publish new generations while readers are running */
+
+	for (long long i = 1; i <= N_GENERATIONS; i++)
+	{
+		ccfg_clear_params(cfg);
+		ccfg_push_param(cfg, "generation", i);
+		ccfg_load_internal(cfg, data);
+
+		snapshot = ccfg_snapshot_create(cfg);
+		ccfg_slot_publish(slot, snapshot);
+		ccfg_snapshot_release(snapshot);
+	}
+
+	/* End */
+
+	for (size_t i = 0; i < N_READERS; i++)
+	{
+		pthread_join(threads[i], NULL);
+	}
+
+	ccfg_slot_destroy(slot);
+	ccfg_destroy(cfg);
+
+	return 0;
+}
+
+/************************************************************************************************************/
+/* _ ********************************************************************************************************/
+/************************************************************************************************************/
+
+static void *
+reader_thread(void *param)
+{
+	ccfg_snapshot *snapshot;
+	ccfg_cursor cursor;
+
+	unsigned long generation = 0;
+	unsigned long mirror     = 0;
+	bool consistent          = true;
+
+	(void)param;
+
+	/* read until the last generation shows up */
+
+	while (generation < N_GENERATIONS)
+	{
+		snapshot = ccfg_slot_acquire(slot);
+
+		ccfg_snapshot_fetch(snapshot, &cursor, "server", "generation");
+		generation = ccfg_cursor_iterate(&cursor) ? strtoul(ccfg_cursor_resource(&cursor), NULL, 0) : 0;
+
+		ccfg_snapshot_fetch(snapshot, &cursor, "server", "mirror");
+		mirror = ccfg_cursor_iterate(&cursor) ? strtoul(ccfg_cursor_resource(&cursor), NULL, 0) : 0;
+
+		ccfg_snapshot_release(snapshot);
+
+		consistent &= generation == mirror;
+	}
+
+	printf("reader done -> generation = %lu, consistent = %s\n", generation, consistent ? "yes" : "no");
+
+	pthread_exit(NULL);
+}
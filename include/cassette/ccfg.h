@@ -22,6 +22,7 @@
 
 #include <cassette/cobj.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 #if __GNUC__ > 4
@@ -56,6 +57,178 @@ extern "C" {
  */
 typedef struct ccfg ccfg;
 
+/**
+ * Pre-resolved reference to a resource, obtained from ccfg_resolve(). A handle only makes sense with the
+ * config object it was obtained from (or its clones), and stays valid for the whole life of the config.
+ */
+typedef size_t ccfg_handle;
+
+/**
+ * Completion callback of ccfg_load_async(). It is called from the loader's thread with the freshly loaded
+ * config instance, which the callback takes ownership of, and the user data given along with the request.
+ */
+typedef void (*ccfg_load_callback)(ccfg *cfg, void *data);
+
+/**
+ * Types a resource value can be converted to by ccfg_fetch_fields(). Numerical types follow the same
+ * conversion rules as ccfg_resource_double(), ccfg_resource_long() and ccfg_resource_color().
+ *
+ * CCFG_TYPE_STRING : const char *, points to the config's storage, valid until resources change
+ * CCFG_TYPE_DOUBLE : double
+ * CCFG_TYPE_LONG   : long long, truncated
+ * CCFG_TYPE_COLOR  : struct ccolor
+ */
+enum ccfg_type
+{
+	CCFG_TYPE_STRING,
+	CCFG_TYPE_DOUBLE,
+	CCFG_TYPE_LONG,
+	CCFG_TYPE_COLOR,
+};
+
+/**
+ * Resource request descriptor for ccfg_fetch_fields(). Destination must point to a variable of the type
+ * matching the requested one.
+ */
+struct ccfg_field
+{
+	const char *namespace;
+	const char *property;
+	enum ccfg_type type;
+	void *destination;
+};
+
+/**
+ * Opaque, immutable copy of the resources held by a config object at the time it was taken. Snapshots are
+ * reference counted and can be read by any number of threads at the same time without locking, as long as
+ * every thread reads through its own ccfg_cursor.
+ */
+typedef struct ccfg_snapshot ccfg_snapshot;
+
+/**
+ * Opaque publication point for snapshots. A reloader thread can publish a new snapshot while reader threads
+ * keep acquiring the current one. Readers never block, and a replaced snapshot stays alive until its last
+ * reader releases it.
+ */
+typedef struct ccfg_slot ccfg_slot;
+
+/**
+ * Resource iterator over a snapshot. Unlike the one internal to config objects, cursors are owned by the
+ * caller and are meant to be allocated on the stack of the reading thread. Its fields should not be
+ * accessed directly, use ccfg_snapshot_fetch() to set it up.
+ */
+typedef struct ccfg_cursor ccfg_cursor;
+
+struct ccfg_cursor
+{
+	const ccfg_snapshot *snapshot;
+	size_t group;
+	size_t it;
+};
+
+/**
+ * Statistics of the last load, as returned by ccfg_get_stats(). They are only gathered if the library was
+ * built with CCFG_STATS defined. Tokens count the words read by the parser, either lexed from the sources or
+ * replayed from their compiled form, and matches count the keyword lookups the parser had to do, which the
+ * replayed words do not need. Includes count the child files that were followed, parsed or reused from the
+ * previous load, and the rejected ones those that were nested too deep or included within themselves. Peak
+ * sizes are counted in words, and phase times are wall clock durations in nanoseconds.
+ */
+struct ccfg_stats
+{
+	/* sources */
+
+	size_t files;
+	size_t bytes;
+	size_t lines;
+	size_t includes;
+	size_t includes_rejected;
+
+	/* parser */
+
+	size_t tokens;
+	size_t matches;
+	size_t iterations;
+
+	/* substitutions */
+
+	size_t maths;
+	size_t colors;
+	size_t joins;
+	size_t conditions;
+	size_t var_injections;
+	size_t param_injections;
+	size_t iter_injections;
+
+	/* peak storage sizes */
+
+	size_t peak_vars;
+	size_t peak_iteration;
+	size_t peak_sequences;
+
+	/* phase times */
+
+	uint64_t time_select;
+	uint64_t time_clear;
+	uint64_t time_parse;
+	uint64_t time_finish;
+};
+
+/**
+ * Size of a source file read by the last load, as returned by ccfg_get_file_stats(). The path is the one
+ * the file was opened with, and points to the config's storage until the next load.
+ */
+struct ccfg_file_stats
+{
+	const char *path;
+	size_t bytes;
+	size_t lines;
+};
+
+/**
+ * Output formats of ccfg_save_profile().
+ *
+ * CCFG_PROFILE_REPORT : One source line per row, sorted by the time spent on it, most expensive first
+ * CCFG_PROFILE_FOLDED : Folded stacks, as read by flamegraph tools, with INCLUDE and FOR_EACH lines as frames
+ */
+enum ccfg_profile_format
+{
+	CCFG_PROFILE_REPORT,
+	CCFG_PROFILE_FOLDED,
+};
+
+/**
+ * Kinds of resource changes between two loads, see ccfg_set_change_tracking().
+ *
+ * CCFG_CHANGE_ADDED    : The resource was not declared by the previous load
+ * CCFG_CHANGE_REMOVED  : The resource was declared by the previous load only
+ * CCFG_CHANGE_MODIFIED : The resource was declared by both loads, with different values
+ */
+enum ccfg_change_type
+{
+	CCFG_CHANGE_ADDED,
+	CCFG_CHANGE_REMOVED,
+	CCFG_CHANGE_MODIFIED,
+};
+
+/**
+ * Resource that changed with the last load, as returned by ccfg_get_change() or given to a change callback.
+ * Namespace and property point to the config's storage until the next load.
+ */
+struct ccfg_change
+{
+	const char *namespace;
+	const char *property;
+	enum ccfg_change_type type;
+};
+
+/**
+ * Change callback registered with ccfg_push_change_callback(). It is called at the end of a load, from the
+ * thread that did it, with the config instance that was loaded, one of the changes of the namespace it
+ * watches, and the user data given along with it.
+ */
+typedef void (*ccfg_change_callback)(ccfg *cfg, const struct ccfg_change *change, void *data);
+
 /************************************************************************************************************/
 /* GLOBALS **************************************************************************************************/
 /************************************************************************************************************/
@@ -73,12 +246,42 @@ typedef struct ccfg ccfg;
  */
 extern ccfg ccfg_placeholder_instance;
 
+/**
+ * Handle value returned by ccfg_resolve() on failure. Fetching it always results in an empty resource.
+ */
+#define CCFG_HANDLE_INVALID SIZE_MAX
+
+/**
+ * Same as CCFG_PLACEHOLDER, but for snapshots. The placeholder snapshot holds no resources.
+ */
+#define CCFG_SNAPSHOT_PLACEHOLDER (&ccfg_snapshot_placeholder_instance)
+
+/**
+ * Global snapshot instance without any resources. This instance is only made available to allow the static
+ * initialization of snapshot pointers with the macro CCFG_SNAPSHOT_PLACEHOLDER.
+ */
+extern ccfg_snapshot ccfg_snapshot_placeholder_instance;
+
+/**
+ * Same as CCFG_PLACEHOLDER, but for slots. The placeholder slot always holds the placeholder snapshot.
+ */
+#define CCFG_SLOT_PLACEHOLDER (&ccfg_slot_placeholder_instance)
+
+/**
+ * Global slot instance that ignores publications. This instance is only made available to allow the static
+ * initialization of slot pointers with the macro CCFG_SLOT_PLACEHOLDER.
+ */
+extern ccfg_slot ccfg_slot_placeholder_instance;
+
 /************************************************************************************************************/
 /* CONSTRUCTORS / DESTRUCTORS *******************************************************************************/
 /************************************************************************************************************/
 
 /**
- * Creates a config instance and deep copy the contents of another config instance into it.
+ * Creates a config instance with the same contents as another config instance. Resources, parameters, sources
+ * and namespace filters are shared between the two instances until one of them modifies them, at which point
+ * it gets a private copy, so cloning costs the same regardless of the size of the config. Shared contents are
+ * safe to read from several threads at once. Configs in an error state are not cloned.
  *
  * @return     : Created config instance
  * @return_err : CCFG_PLACEHOLDER
@@ -107,6 +310,49 @@ void
 ccfg_destroy(ccfg *cfg)
 CCFG_NONNULL(1);
 
+/**
+ * Creates an empty slot. Until a snapshot gets published into it, the slot holds CCFG_SNAPSHOT_PLACEHOLDER.
+ *
+ * @return     : Created slot
+ * @return_err : CCFG_SLOT_PLACEHOLDER
+ */
+ccfg_slot *
+ccfg_slot_create(void)
+CCFG_NONNULL_RETURN;
+
+/**
+ * Destroys the given slot and releases the snapshot it holds. No thread should be using the slot anymore.
+ *
+ * @param slot : Slot to interact with
+ */
+void
+ccfg_slot_destroy(ccfg_slot *slot)
+CCFG_NONNULL(1);
+
+/**
+ * Creates a snapshot of the resources the config currently holds. The snapshot is independent from the
+ * config, which can then be loaded again or destroyed without affecting it. The returned snapshot holds one
+ * reference that has to be released with ccfg_snapshot_release().
+ *
+ * @param cfg : Config instance to interact with
+ *
+ * @return     : Created snapshot
+ * @return_err : CCFG_SNAPSHOT_PLACEHOLDER
+ */
+ccfg_snapshot *
+ccfg_snapshot_create(ccfg *cfg)
+CCFG_NONNULL_RETURN
+CCFG_NONNULL(1);
+
+/**
+ * Releases a reference to a snapshot. When the last reference gets released, the snapshot is destroyed.
+ *
+ * @param snapshot : Snapshot to interact with
+ */
+void
+ccfg_snapshot_release(ccfg_snapshot *snapshot)
+CCFG_NONNULL(1);
+
 /************************************************************************************************************/
 /* IMPURE METHODS *******************************************************************************************/
 /************************************************************************************************************/
@@ -123,6 +369,25 @@ CCFG_NONNULL(1);
 		default      : ccfg_push_param_long    \
 	)(CFG, NAME, VAL)
 
+/**
+ * Removes all registered change callbacks.
+ *
+ * @param cfg : Config instance to interact with
+ */
+void
+ccfg_clear_change_callbacks(ccfg *cfg)
+CCFG_NONNULL(1);
+
+/**
+ * Removes all added namespace filters, so that the resources of every namespace get parsed again on the next
+ * load.
+ *
+ * @param cfg : Config instance to interact with
+ */
+void
+ccfg_clear_namespace_filters(ccfg *cfg)
+CCFG_NONNULL(1);
+
 /**
  * Removes all added parameters.
  *
@@ -150,6 +415,19 @@ void
 ccfg_clear_sources(ccfg *cfg)
 CCFG_NONNULL(1);
 
+/**
+ * Increments the cursor offset and makes available the next value of the resource it was set on with
+ * ccfg_snapshot_fetch(). Said value can be accessed with ccfg_cursor_resource().
+ *
+ * @param cursor : Cursor to interact with
+ *
+ * @return     : True is the next value could be picked, false otherwhise.
+ * @return_err : False
+ */
+bool
+ccfg_cursor_iterate(ccfg_cursor *cursor)
+CCFG_NONNULL(1);
+
 /**
  * Looks-up a resource by its namespace and property name. If found, its reference is kept around and the
  * resource values will become accessible through ccfg_iterate() and ccfg_resource(). To get the number of
@@ -171,6 +449,62 @@ void
 ccfg_fetch(ccfg *cfg, const char *namespace, const char *property)
 CCFG_NONNULL(1, 2, 3);
 
+/**
+ * Looks-up many resources at once, converts their first value to the requested types, and writes them into
+ * the given destinations. Destinations of resources that are not found or whose value could not be
+ * converted are left untouched, so they can be pre-filled with defaults. The internal iterator used by
+ * ccfg_fetch() is not affected.
+ *
+ * Usage example :
+ *
+ *	long long width = 0;
+ *	struct ccolor color = {0};
+ *	struct ccfg_field fields[] =
+ *	{
+ *		{"button", "border_width", CCFG_TYPE_LONG,  &width},
+ *		{"button", "border_color", CCFG_TYPE_COLOR, &color},
+ *	};
+ *	ccfg_fetch_fields(cfg, fields, 2);
+ *
+ * @param cfg    : Config instance to interact with
+ * @param fields : Array of resource descriptors
+ * @param n      : Number of descriptors
+ *
+ * @return     : Number of destinations that were written
+ * @return_err : 0
+ */
+size_t
+ccfg_fetch_fields(ccfg *cfg, const struct ccfg_field *fields, size_t n)
+CCFG_NONNULL(1);
+
+/**
+ * Same as ccfg_fetch(), but with a resource handle obtained from ccfg_resolve(). Since handles are bound to
+ * resources in advance, this function does not hash nor compare any string and runs in constant time.
+ *
+ * @param cfg    : Config instance to interact with
+ * @param handle : Resource handle
+ */
+void
+ccfg_fetch_handle(ccfg *cfg, ccfg_handle handle)
+CCFG_NONNULL(1);
+
+/**
+ * Packs the resources the config currently holds into a single contiguous read-only table, in which all
+ * values are stored next to each other, and that is indexed by a hash of both the namespace and property
+ * names. Once frozen, ccfg_fetch() resolves resources with a single table look-up, and ccfg_iterate() and
+ * ccfg_resource() read values straight from the table. The table gets dropped as soon as the resources are
+ * cleared or loaded again, in which case this function has to be called again to keep the benefits. The
+ * iterator is reset.
+ *
+ * @param cfg : Config instance to interact with
+ *
+ * @error CERR_OVERFLOW : The table would be larger than 4 GiB
+ * @error CERR_MEMORY   : Failed memory allocation
+ */
+void
+ccfg_freeze(ccfg *cfg)
+CCFG_NONNULL(1);
+
 /**
  * Increments an internal iterator offset and makes available the next value associated to a resource fetched
  * with ccfg_fetch(). Said value can be accessed with ccfg_resource(). This function exits early and returns
@@ -193,6 +527,15 @@ CCFG_NONNULL(1);
  * open any source files is not considered to be an error by default. If such a check is needed, use
  * ccfg_can_open_sources().
  *
+ * Source files are compiled into token streams that are kept in the config instance and reused by the
+ * following loads as long as the file's inode, size and modification time stay the same. Streams of files
+ * that did not get read during a load are dropped.
+ *
+ * The resources and variables produced by included files are kept as well. When a file gets included again
+ * in the same state (same variables, sections, parameters and random seed) and neither it nor the files it
+ * includes changed, its previous output is spliced back in instead of parsing it again. Files that are
+ * included from within an iteration, that print, or that read the current time are always parsed again.
+ *
  * @param cfg : Config instance to interact with
  *
  * @error CERR_OVERFLOW : The size of an internal components was about to overflow
@@ -202,6 +545,107 @@ void
 ccfg_load(ccfg *cfg)
 CCFG_NONNULL(1);
 
+/**
+ * Similar to ccfg_load(), except that the load happens on a thread of its own and into a clone of the config
+ * instance, so that the caller is never blocked by the source files being probed, opened and parsed. Once
+ * the load is over, successful or not, the callback is called from the loader's thread with the clone. The
+ * clone is never modified by the library afterwards, so it can be handed to other threads as is, or
+ * published through a snapshot. The given config instance is left untouched, and can keep being used or
+ * even destroyed while the load is running.
+ *
+ * Unlike with ccfg_load(), the clone starts without compiled source streams or previous output, so nothing
+ * gets reused from the previous loads of the given instance.
+ *
+ * @param cfg      : Config instance to clone and load
+ * @param callback : Function to call with the loaded clone
+ * @param data     : User data passed as is to the callback
+ *
+ * @return     : True if the load got started, false otherwise, in which case the callback will not be called
+ * @return_err : False
+ */
+bool
+ccfg_load_async(ccfg *cfg, ccfg_load_callback callback, void *data)
+CCFG_NONNULL(1, 2);
+
+/**
+ * Replaces the resources of the config with a table previously written by ccfg_save_frozen(). The file is
+ * mapped into memory and resources are read straight from the mapping, as if the config had been frozen with
+ * ccfg_freeze(), with no parsing or allocation. Processes that map the same file share the same memory
+ * pages. The file has to come from the same library version on a machine of the same byte order, and is
+ * otherwise rejected.
+ *
+ * No source is read, so the next ccfg_load_if_changed() always parses the sources again. Snapshots taken
+ * from a config loaded this way are empty, since they are built from the evaluated sequences, which are
+ * not part of the file.
+ *
+ * @param cfg      : Config instance to interact with
+ * @param filename : Path of the file to map
+ *
+ * @return     : True if the file was mapped, false otherwise, in which case the resources are left untouched
+ * @return_err : False
+ *
+ * @error CERR_MEMORY : Failed memory allocation
+ */
+bool
+ccfg_load_frozen(ccfg *cfg, const char *filename)
+CCFG_NONNULL(1, 2);
+
+/**
+ * Similar to ccfg_load(), except that nothing happens if none of the files read during the previous load,
+ * the root source and all included children alike, got modified since, and if the parameters and parsing
+ * mode are still the same. Files are compared by inode, size and modification time. This makes this function
+ * cheap enough to be called periodically. Loads done with ccfg_load_internal() or that failed are always
+ * considered outdated.
+ *
+ * @param cfg : Config instance to interact with
+ *
+ * @return     : True if the sources got parsed again, false otherwise
+ * @return_err : False
+ *
+ * @error CERR_OVERFLOW : The size of an internal components was about to overflow
+ * @error CERR_MEMORY   : Failed memory allocation during parsing
+ */
+bool
+ccfg_load_if_changed(ccfg *cfg)
+CCFG_NONNULL(1);
+
+/**
+ * Reads the notifications pending on the descriptor returned by ccfg_watch() without blocking, and calls
+ * ccfg_load_if_changed() if any of them concerns a file read by the last load. Every notification queued up
+ * to that point is consumed at once, so a burst of writes to the same files only leads to a single reload.
+ * It is meant to be called whenever the descriptor becomes readable.
+ *
+ * @param cfg : Config instance to interact with
+ *
+ * @return     : True if the sources got parsed again, false otherwise
+ * @return_err : False
+ *
+ * @error CERR_OVERFLOW : The size of an internal components was about to overflow
+ * @error CERR_MEMORY   : Failed memory allocation during parsing
+ */
+bool
+ccfg_load_if_notified(ccfg *cfg)
+CCFG_NONNULL(1);
+
+/**
+ * Replaces the resources of the config with the latest table published on the named channel by
+ * ccfg_publish(), if it is newer than the last one this config picked up from it. Published tables are
+ * mapped the same way as with ccfg_load_frozen(), and the same limitations apply. Once attached to the
+ * channel, checking it for a new generation only takes a single atomic load, so this function is cheap
+ * enough to be called very often, for instance before every batch of fetches.
+ *
+ * @param cfg  : Config instance to interact with
+ * @param name : Name of the shared memory channel, starting with a slash
+ *
+ * @return     : True if a new table was mapped, false otherwise, in which case the resources are untouched
+ * @return_err : False
+ *
+ * @error CERR_MEMORY : Failed memory allocation
+ */
+bool
+ccfg_load_published(ccfg *cfg, const char *name)
+CCFG_NONNULL(1, 2);
+
 /**
  * Similar to ccfg_load() except that no source file is opened. Instead, the resources will be parsed from
  * the given buffer. The only different behavior from standard parsing is the interpretation of relative 
@@ -218,6 +662,84 @@ void
 ccfg_load_internal(ccfg *cfg, const char *buffer)
 CCFG_NONNULL(1, 2);
 
+/**
+ * Loads the sources of cfg once in param tracking mode (see ccfg_set_param_tracking()), then gives each of
+ * the n tenant configs the resources it would have got by loading the same sources with its own params.
+ * Tenants take the sources and namespace filters of cfg, and only keep their params. The resources of cfg
+ * are shared by every tenant, each tenant only holding the values of the resources its params changed, which
+ * are evaluated again as by ccfg_reevaluate(). A tenant gets a full copy of the resources once it gets
+ * frozen or cloned. If params were read by anything else than the values of resources and variables, each
+ * tenant loads the sources in full instead. Tenants are spread over the threads of cfg, see
+ * ccfg_set_threads(). Tenants must be distinct from cfg and from each other. Errors of a tenant are set on
+ * that tenant only, and tenants are left untouched if loading cfg fails, or if none of its sources could be
+ * opened and its resources are still those of a load from a buffer.
+ *
+ * @param cfg     : Config instance holding the sources to load
+ * @param tenants : Configs to load the resources of, each with its own params
+ * @param n       : Number of tenants
+ *
+ * @error CERR_OVERFLOW : The size of an internal components was about to overflow
+ * @error CERR_MEMORY   : Failed memory allocation
+ */
+void
+ccfg_load_tenants(ccfg *cfg, ccfg *const *tenants, size_t n)
+CCFG_NONNULL(1);
+
+/**
+ * Freezes the config if it is not frozen yet, then publishes the frozen table as a new generation of the
+ * named shared memory channel, creating the channel if needed. Other processes pick it up with
+ * ccfg_load_published(). Each generation lives in a shared memory object of its own, named after the channel
+ * and the generation number, and the previous generation's object is unlinked once the new one is announced.
+ * Subscribers that still map an older table keep it until they move on. Only one process should publish on
+ * a given channel.
+ *
+ * @param cfg  : Config instance to interact with
+ * @param name : Name of the shared memory channel, starting with a slash
+ *
+ * @return     : True if the table was published, false otherwise
+ * @return_err : False
+ *
+ * @error CERR_OVERFLOW : The table would be larger than 4 GiB
+ * @error CERR_MEMORY   : Failed memory allocation
+ */
+bool
+ccfg_publish(ccfg *cfg, const char *name)
+CCFG_NONNULL(1, 2);
+
+/**
+ * Registers a function to call for every change of the resources of a namespace, at the end of each load
+ * that changed some, see ccfg_set_change_tracking(). Loads are tracked as long as at least one callback is
+ * registered, even if change tracking was not enabled. Several callbacks can watch the same namespace, they
+ * are called in registration order. Callbacks can fetch the resources of the config they are given, but
+ * should not call any function that loads or clears them. Clones do not inherit the callbacks.
+ *
+ * @param cfg       : Config instance to interact with
+ * @param namespace : Namespace to watch
+ * @param callback  : Function to call for each change
+ * @param data      : User data passed as is to the callback
+ *
+ * @error CERR_MEMORY : Failed memory allocation
+ */
+void
+ccfg_push_change_callback(ccfg *cfg, const char *namespace, ccfg_change_callback callback, void *data)
+CCFG_NONNULL(1, 2, 3);
+
+/**
+ * Adds a namespace to the list of namespaces to keep. Once at least one filter is set, resource definitions
+ * from other namespaces are skipped during the following loads, without their values being evaluated, and
+ * fetching them fails as if they were never defined. Because of that, random values from the skipped
+ * definitions are not drawn, and the ones of the kept resources may differ from an unfiltered load.
+ *
+ * @param cfg       : Config instance to interact with
+ * @param namespace : Name of the namespace to keep
+ *
+ * @error CERR_OVERFLOW : The size of an internal components was about to overflow
+ * @error CERR_MEMORY   : Failed memory allocation
+ */
+void
+ccfg_push_namespace_filter(ccfg *cfg, const char *namespace)
+CCFG_NONNULL(1, 2);
+
 /**
  * Adds a double as a config parameter. This parameter's value can then be accessed from a config source
  * file. Unlike user-defined variables, only one value per parameter can be defined.
@@ -277,6 +799,26 @@ void
 ccfg_push_source(ccfg *cfg, const char *filename)
 CCFG_NONNULL(1, 2);
 
+/**
+ * Updates the resources of the last load to the current params, without reading the sources again. Only the
+ * resources whose values were read from a param that changed since, directly or through variables, are
+ * evaluated again, from the words they were evaluated from during the load and with the same variables and
+ * iterator values. This requires the last load to have been done in param tracking mode, see
+ * ccfg_set_param_tracking(). Otherwise, or if params were read by anything else than the values of
+ * resources and variables, such as a resource name, a section, an iteration or an include path, or if a
+ * resource or variable ends up without values, the sources are loaded again with ccfg_load() instead. If the
+ * last load was done from a buffer, with ccfg_load_internal() or a stream, there is nothing to load again in
+ * those cases, and the resources are left as they are.
+ *
+ * @param cfg : Config instance to interact with
+ *
+ * @error CERR_OVERFLOW : The size of an internal components was about to overflow
+ * @error CERR_MEMORY   : Failed memory allocation
+ */
+void
+ccfg_reevaluate(ccfg *cfg)
+CCFG_NONNULL(1);
+
 /**
  * Clears errors and puts the config back into an usable state. The only unrecoverable error is CCFG_INVALID.
  *
@@ -286,6 +828,28 @@ void
 ccfg_repair(ccfg *cfg)
 CCFG_NONNULL(1);
 
+/**
+ * Resolves a resource by its namespace and property name into a handle that can be passed to
+ * ccfg_fetch_handle() as many times as needed. Handles stay valid across loads: they are bound again to the
+ * new resources every time these change, that is at the end of ccfg_load(), ccfg_load_internal(),
+ * ccfg_reevaluate(), ccfg_clear_resources() and ccfg_freeze(). A handle that refers to a resource that does
+ * not exist (yet) is still valid, fetching it gives an empty resource until a load defines it. Every call
+ * creates a new handle, so a given resource should only be resolved once.
+ *
+ * @param cfg       : Config instance to interact with
+ * @param namespace : Resource namespace
+ * @param property  : Resource property name
+ *
+ * @return     : Resource handle
+ * @return_err : CCFG_HANDLE_INVALID
+ *
+ * @error CERR_OVERFLOW : The size of an internal components was about to overflow
+ * @error CERR_MEMORY   : Failed memory allocation
+ */
+ccfg_handle
+ccfg_resolve(ccfg *cfg, const char *namespace, const char *property)
+CCFG_NONNULL(1, 2, 3);
+
 /**
  * Enables the restricted parsing mode.
  *
@@ -295,6 +859,244 @@ void
 ccfg_restrict(ccfg *cfg)
 CCFG_NONNULL(1);
 
+/**
+ * Freezes the config if it is not frozen yet, then writes the frozen table to a file that can be mapped
+ * back by ccfg_load_frozen(), from this process or any other. The table is written to a temporary file first
+ * which then replaces the one at filename, so processes that already mapped the previous file keep reading
+ * it safely.
+ *
+ * @param cfg      : Config instance to interact with
+ * @param filename : Path of the file to write
+ *
+ * @return     : True if the file was written, false otherwise
+ * @return_err : False
+ *
+ * @error CERR_OVERFLOW : The table would be larger than 4 GiB
+ * @error CERR_MEMORY   : Failed memory allocation
+ */
+bool
+ccfg_save_frozen(ccfg *cfg, const char *filename)
+CCFG_NONNULL(1, 2);
+
+/**
+ * Writes the profile gathered by the last load into a file. Only loads done in profiling mode gather one,
+ * see ccfg_set_profiling(). Time is attributed to the source line of each sequence, and only counts the time
+ * spent in the sequence itself: an INCLUDE or FOR_EACH line gets the time spent outside the sequences it
+ * ran. Sequences run from a FOR_EACH block are attributed to the line they were written on. Children parsed
+ * by the pool workers are attributed to the INCLUDE_PARALLEL line that included them.
+ *
+ * @param cfg      : Config instance to interact with
+ * @param filename : Path of the file to write
+ * @param format   : Output format
+ *
+ * @return     : True if the file was written, false otherwise
+ * @return_err : False
+ */
+bool
+ccfg_save_profile(ccfg *cfg, const char *filename, enum ccfg_profile_format format)
+CCFG_NONNULL(1, 2);
+
+/**
+ * Sets whether the next loads track which resources they changed. Once a load is over, each resource gets
+ * hashed from its values and compared with the resources of the previous tracked load, so that only the
+ * ones that were added, removed or modified are listed by ccfg_get_change() and given to the callbacks of
+ * ccfg_push_change_callback(). This applies to every way resources get replaced: ccfg_load() and its
+ * variants, ccfg_reevaluate(), ccfg_stream_end(), ccfg_load_frozen(), ccfg_load_published(), the tenants of
+ * ccfg_load_tenants() and ccfg_clear_resources(). Values that are still deferred in lazy mode get evaluated
+ * for that. The first tracked load reports every resource as added, and a failed load reports nothing and is
+ * not compared against. Clones keep the mode and compare their next load to the resources they were cloned
+ * with. Change tracking is disabled by default, disabling it drops the resources kept for comparison.
+ *
+ * @param cfg      : Config instance to interact with
+ * @param tracking : Change tracking mode state to set
+ *
+ * @error CERR_MEMORY : Failed memory allocation during the following loads
+ */
+void
+ccfg_set_change_tracking(ccfg *cfg, bool tracking)
+CCFG_NONNULL(1);
+
+/**
+ * Sets whether the next loads defer the evaluation of resource values until they get fetched. In lazy mode,
+ * the values of a resource that hold operations are written down as they are read, and only evaluated the
+ * first time the resource is reached by ccfg_fetch(), ccfg_fetch_fields() or ccfg_fetch_handle(). The
+ * outcome stays the same as with a regular load: variables, iterations and parameters are injected as they
+ * were when the resource got declared. Values that rely on TIME, RAND or EOF, and the ones in children
+ * that get cached, are still evaluated during the load. Freezing, cloning or taking a snapshot of the
+ * config evaluates the remaining ones. Lazy mode is disabled by default.
+ *
+ * @param cfg  : Config instance to interact with
+ * @param lazy : Lazy mode state to set
+ */
+void
+ccfg_set_lazy(ccfg *cfg, bool lazy)
+CCFG_NONNULL(1);
+
+/**
+ * Sets whether the next loads track which resources depend on which params, so that ccfg_reevaluate() can
+ * update them once params change. In param tracking mode, the words the values of a resource or variable
+ * are evaluated from are written down as soon as they read a param, or a variable that did. Tracked loads
+ * neither defer values in lazy mode, nor splice back the output of included files, nor parse them with the
+ * thread pool. Param tracking mode is disabled by default.
+ *
+ * @param cfg      : Config instance to interact with
+ * @param tracking : Param tracking mode state to set
+ */
+void
+ccfg_set_param_tracking(ccfg *cfg, bool tracking)
+CCFG_NONNULL(1);
+
+/**
+ * Sets whether the next loads profile the sources they parse. In profiling mode, the time spent on every
+ * sequence and the substitutions it evaluated are attributed to its source file and line, along with the
+ * chain of INCLUDE and FOR_EACH sequences it was run from. The profile can then be written out with
+ * ccfg_save_profile(). Profiling mode is disabled by default.
+ *
+ * @param cfg       : Config instance to interact with
+ * @param profiling : Profiling mode state to set
+ */
+void
+ccfg_set_profiling(ccfg *cfg, bool profiling)
+CCFG_NONNULL(1);
+
+/**
+ * Sets the number of threads, the calling one included, that parse the child files of INCLUDE_PARALLEL
+ * sequences. With 0 or 1, which is the default, those children are parsed one after another like with
+ * INCLUDE. If not every thread could be started, the ones that were get used.
+ *
+ * @param cfg : Config instance to interact with
+ * @param n   : Number of threads
+ */
+void
+ccfg_set_threads(ccfg *cfg, size_t n)
+CCFG_NONNULL(1);
+
+/**
+ * Gets the snapshot currently published in a slot and acquires a reference to it, which has to be released
+ * with ccfg_snapshot_release() once the caller is done reading. This function never blocks and can be
+ * called from any number of threads, even while another thread publishes a new snapshot.
+ *
+ * @param slot : Slot to interact with
+ *
+ * @return     : Acquired snapshot
+ * @return_err : CCFG_SNAPSHOT_PLACEHOLDER
+ */
+ccfg_snapshot *
+ccfg_slot_acquire(ccfg_slot *slot)
+CCFG_NONNULL_RETURN
+CCFG_NONNULL(1);
+
+/**
+ * Publishes a snapshot into a slot. The slot acquires its own reference to the snapshot, so the caller
+ * keeps the one it holds. The reference the slot held on the previously published snapshot is released once
+ * every thread that might have been acquiring it at the same time is done, which is the only case in which
+ * this function waits. Publications from several threads at once are serialized.
+ *
+ * @param slot     : Slot to interact with
+ * @param snapshot : Snapshot to publish
+ */
+void
+ccfg_slot_publish(ccfg_slot *slot, ccfg_snapshot *snapshot)
+CCFG_NONNULL(1, 2);
+
+/**
+ * Acquires an additional reference to a snapshot.
+ *
+ * @param snapshot : Snapshot to interact with
+ *
+ * @return : Same snapshot
+ */
+ccfg_snapshot *
+ccfg_snapshot_acquire(ccfg_snapshot *snapshot)
+CCFG_NONNULL_RETURN
+CCFG_NONNULL(1);
+
+/**
+ * Looks-up a resource in a snapshot by its namespace and property name, and sets the cursor on it. The
+ * resource values then become accessible through ccfg_cursor_iterate() and ccfg_cursor_resource(). The
+ * snapshot itself is not modified, concurrent fetches are safe.
+ *
+ * Usage example :
+ *
+ *	ccfg_cursor cursor;
+ *	ccfg_snapshot_fetch(snapshot, &cursor, "something", "something");
+ *	while (ccfg_cursor_iterate(&cursor))
+ *	{
+ *		printf("%s\n", ccfg_cursor_resource(&cursor));
+ *	}
+ *
+ * @param snapshot  : Snapshot to interact with
+ * @param cursor    : Cursor to set up
+ * @param namespace : Resource namespace
+ * @param property  : Resource property name
+ */
+void
+ccfg_snapshot_fetch(const ccfg_snapshot *snapshot, ccfg_cursor *cursor, const char *namespace,
+                    const char *property)
+CCFG_NONNULL(1, 2, 3, 4);
+
+/**
+ * Starts loading the resources from a source handed over in chunks with ccfg_stream_feed(), for sources that
+ * come from a socket or a pipe and cannot be mapped like a file. Sequences get parsed as soon as the chunk
+ * that ends them arrives, only the unfinished part of the source being kept around until the next chunk.
+ * Once ccfg_stream_end() returns, resources are the same as if the whole source had been passed at once to
+ * ccfg_load_internal(), relative INCLUDE paths being ignored the same way. Resources are cleared by this
+ * call, and fetched resources may be incomplete until the stream ends. No other function that modifies the
+ * config should be called before ccfg_stream_end(). A stream that was already open is dropped.
+ *
+ * @param cfg : Config instance to interact with
+ *
+ * @error CERR_MEMORY : Failed memory allocation
+ */
+void
+ccfg_stream_begin(ccfg *cfg)
+CCFG_NONNULL(1);
+
+/**
+ * Parses what is left of the source opened by ccfg_stream_begin(), a last sequence that does not end with a
+ * newline included, and finishes the load. Does nothing if no stream is open. If an error was set while the
+ * stream was open, the rest of it is dropped.
+ *
+ * @param cfg : Config instance to interact with
+ *
+ * @error CERR_OVERFLOW : The size of an internal components was about to overflow
+ * @error CERR_MEMORY   : Failed memory allocation during parsing
+ */
+void
+ccfg_stream_end(ccfg *cfg)
+CCFG_NONNULL(1);
+
+/**
+ * Hands the next chunk of the source over to the stream opened by ccfg_stream_begin(). Chunks can be cut
+ * anywhere, words and quotes included, and data is copied, so it can be reused once this function returns.
+ * Like for ccfg_load_internal(), a NUL character ends the source, data after it and in the chunks that follow
+ * is ignored. Does nothing if no stream is open.
+ *
+ * @param cfg  : Config instance to interact with
+ * @param data : Next bytes of the source, not necessarily NUL terminated
+ * @param n    : Number of bytes in data
+ *
+ * @error CERR_OVERFLOW : The size of an internal components was about to overflow
+ * @error CERR_MEMORY   : Failed memory allocation during parsing
+ */
+void
+ccfg_stream_feed(ccfg *cfg, const char *data, size_t n)
+CCFG_NONNULL(1);
+
+/**
+ * Releases the memory the parser keeps around between loads. To avoid allocating its working state (variables,
+ * iterations, temporary strings) again on every load, the parser clears and reuses it instead of destroying it,
+ * so that reloading similar sources does not allocate. This memory grows up to what the largest load needed
+ * and stays reserved until this function or ccfg_destroy() get called.
+ *
+ * @param cfg : Config instance to interact with
+ *
+ * @error CERR_MEMORY : Failed memory allocation
+ */
+void
+ccfg_trim(ccfg *cfg)
+CCFG_NONNULL(1);
+
 /**
  * Disables the restricted parsing mode.
  *
@@ -304,6 +1106,27 @@ void
 ccfg_unrestrict(ccfg *cfg)
 CCFG_NONNULL(1);
 
+/**
+ * Starts watching the files read by the last load, the included children and the candidate sources
+ * included, and returns a file descriptor that becomes readable when any of these gets written, created,
+ * removed or replaced. The set of watched files is updated at the end of every following load. The
+ * descriptor belongs to the config instance and stays the same for its whole life, so it can be added once
+ * to an event loop, and notifications should then be handled with ccfg_load_if_notified(). Calling this
+ * function again only returns the same descriptor. Clones do not inherit the watch.
+ *
+ * Only available on Linux, through inotify.
+ *
+ * @param cfg : Config instance to interact with
+ *
+ * @return     : Pollable file descriptor
+ * @return_err : -1
+ *
+ * @error CERR_MEMORY : Failed memory allocation
+ */
+int
+ccfg_watch(ccfg *cfg)
+CCFG_NONNULL(1);
+
 /************************************************************************************************************/
 /* PURE METHODS *********************************************************************************************/
 /************************************************************************************************************/
@@ -322,6 +1145,33 @@ bool
 ccfg_can_open_sources(const ccfg *cfg, size_t *index)
 CCFG_NONNULL(1);
 
+/**
+ * Gets the resource value a cursor is pointing at. Works like ccfg_resource().
+ *
+ * @param cursor : Cursor to interact with
+ *
+ * @return     : Resource value
+ * @return_err : "\0";
+ */
+const char *
+ccfg_cursor_resource(const ccfg_cursor *cursor)
+CCFG_NONNULL_RETURN
+CCFG_NONNULL(1)
+CCFG_PURE;
+
+/**
+ * Gets the number of values the resource a cursor was set on has.
+ *
+ * @param cursor : Cursor to interact with
+ *
+ * @return     : Number of values
+ * @return_err : 0
+ */
+size_t
+ccfg_cursor_resource_length(const ccfg_cursor *cursor)
+CCFG_NONNULL(1)
+CCFG_PURE;
+
 /**
  * Gets the error state.
  *
@@ -334,6 +1184,53 @@ ccfg_error(const ccfg *cfg)
 CCFG_NONNULL(1)
 CCFG_PURE;
 
+/**
+ * Gets the i-th resource change of the last load, see ccfg_set_change_tracking(). Additions and
+ * modifications come first, in declaration order, followed by removals, in the order the previous load
+ * declared them.
+ *
+ * @param cfg    : Config instance to interact with
+ * @param i      : Change rank
+ * @param change : Destination for the change
+ *
+ * @return     : True if the change exists, false otherwise
+ * @return_err : False
+ */
+bool
+ccfg_get_change(const ccfg *cfg, size_t i, struct ccfg_change *change)
+CCFG_NONNULL(1, 3);
+
+/**
+ * Gets the size of the i-th source file read by the last load, in the order the files were read. Files that
+ * could not be opened, or that were rejected for being included within themselves, are not counted. Files
+ * whose resources were reused from the previous load without being read again are not counted either.
+ *
+ * @param cfg  : Config instance to interact with
+ * @param i    : File rank
+ * @param file : Destination for the file's stats
+ *
+ * @return     : True if the file exists and stats were gathered, false otherwise
+ * @return_err : False
+ */
+bool
+ccfg_get_file_stats(const ccfg *cfg, size_t i, struct ccfg_file_stats *file)
+CCFG_NONNULL(1, 3);
+
+/**
+ * Gets the statistics of the last call to ccfg_load() or ccfg_load_internal(). Statistics are only gathered
+ * if the library was built with CCFG_STATS defined, otherwise the instrumentation is compiled out and this
+ * function always fails.
+ *
+ * @param cfg   : Config instance to interact with
+ * @param stats : Destination for the stats
+ *
+ * @return     : True if stats were gathered, false otherwise
+ * @return_err : False
+ */
+bool
+ccfg_get_stats(const ccfg *cfg, struct ccfg_stats *stats)
+CCFG_NONNULL(1, 2);
+
 /**
  * Gets the resource value an internal iterator is pointing at. The value is returned as a C string. It's the
  * responsibility of the caller to convert it into the required datatype. If no resource was pre-fetched
@@ -350,6 +1247,35 @@ CCFG_NONNULL_RETURN
 CCFG_NONNULL(1)
 CCFG_PURE;
 
+/**
+ * Same as ccfg_resource(), but returns the value as a color. Numerical values are read as ARGB integers, the
+ * way the parser's color functions produce them, and strings starting with '#' as hexadecimal colors.
+ *
+ * @param cfg : Config instance to interact with
+ * @param err : Optional, set to true if the value is not a valid color, false otherwise
+ *
+ * @return     : Resource value
+ * @return_err : Transparent black
+ */
+struct ccolor
+ccfg_resource_color(const ccfg *cfg, bool *err)
+CCFG_NONNULL(1);
+
+/**
+ * Same as ccfg_resource(), but returns the value as a double. The conversion is not done on the fly: values
+ * produced by math substitutions are kept as they were computed, and other values are converted once when
+ * loaded. A value only counts as a number if it is entirely made of one, or if it is a color.
+ *
+ * @param cfg : Config instance to interact with
+ * @param err : Optional, set to true if the value is not a number, false otherwise
+ *
+ * @return     : Resource value
+ * @return_err : 0.0
+ */
+double
+ccfg_resource_double(const ccfg *cfg, bool *err)
+CCFG_NONNULL(1);
+
 /**
  * Gets the number of values a pre-fetched resource has.
  *
@@ -363,6 +1289,19 @@ ccfg_resource_length(const ccfg *cfg)
 CCFG_NONNULL(1)
 CCFG_PURE;
 
+/**
+ * Same as ccfg_resource_double(), but the value is truncated into an integer.
+ *
+ * @param cfg : Config instance to interact with
+ * @param err : Optional, set to true if the value is not a number or does not fit, false otherwise
+ *
+ * @return     : Resource value
+ * @return_err : 0
+ */
+long long
+ccfg_resource_long(const ccfg *cfg, bool *err)
+CCFG_NONNULL(1);
+
 /************************************************************************************************************/
 /************************************************************************************************************/
 /************************************************************************************************************/
@@ -0,0 +1,454 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#include <cassette/ccfg.h>
+#include <cassette/cobj.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "cache.h"
+#include "context.h"
+#include "stream.h"
+#include "trace.h"
+#include "util.h"
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+static void apply         (struct context *, const struct cache_journal *, size_t) CCFG_NONNULL(1, 2);
+static void clear_journal (struct cache_journal *)                                 CCFG_NONNULL(1);
+static void free_journal  (struct cache_journal *)                                 CCFG_NONNULL(1);
+static void init_journal  (struct cache_journal *)                                 CCFG_NONNULL(1);
+static bool state_key     (const struct context *, uint64_t *)                     CCFG_NONNULL(1, 2);
+
+/************************************************************************************************************/
+/* PRIVATE **************************************************************************************************/
+/************************************************************************************************************/
+
+void
+cache_begin(struct context *ctx, struct cache_mark *mark)
+{
+	struct cache *cache = ctx->cache;
+
+	if (!(mark->enabled = state_key(ctx, &mark->key)))
+	{
+		return;
+	}
+
+	mark->events    = cache->journals[cache->current].events_n;
+	mark->files     = ctx->trace->files_n;
+	mark->volatiles = cache->volatiles;
+
+	cache->recording++;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+cache_end(struct context *ctx, const char *path, const struct cache_mark *mark)
+{
+	struct cache_journal *journal;
+	struct cache_entry *tmp;
+
+	if (!mark->enabled)
+	{
+		return;
+	}
+
+	journal = ctx->cache->journals + ctx->cache->current;
+
+	ctx->cache->recording--;
+
+	/* children that produced something that cannot be reproduced, like a timestamp, are not saved */
+
+	if (journal->err || ctx->trace->err || ctx->cache->volatiles != mark->volatiles)
+	{
+		return;
+	}
+
+	if (!(tmp = util_reserve(journal->entries, &journal->entries_cap, journal->entries_n + 1, sizeof(*tmp))))
+	{
+		journal->err = true;
+		return;
+	}
+
+	journal->entries = tmp;
+	journal->entries[journal->entries_n].key          = mark->key;
+	journal->entries[journal->entries_n].events_start = mark->events;
+	journal->entries[journal->entries_n].events_end   = journal->events_n;
+	journal->entries[journal->entries_n].files_start  = journal->files.files_n;
+
+	trace_append(&journal->files, ctx->trace, mark->files, ctx->trace->files_n);
+
+	journal->entries[journal->entries_n].files_end = journal->files.files_n;
+
+	cdict_write(journal->keys_entries, path, mark->key, journal->entries_n++);
+
+	if (cbook_error(journal->words) || cdict_error(journal->keys_entries) || journal->files.err)
+	{
+		journal->err = true;
+	}
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+cache_free(struct cache *cache)
+{
+	free_journal(cache->journals + 0);
+	free_journal(cache->journals + 1);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+cache_init(struct cache *cache)
+{
+	init_journal(cache->journals + 0);
+	init_journal(cache->journals + 1);
+
+	cache->current   = 0;
+	cache->recording = 0;
+	cache->volatiles = 0;
+	cache->hash      = 0;
+	cache->state     = UTIL_HASH_INIT;
+	cache->active    = false;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+bool
+cache_probe(const struct context *ctx, const char *path)
+{
+	const struct cache_journal *journal;
+	uint64_t key;
+	size_t i;
+
+	if (!state_key(ctx, &key))
+	{
+		return false;
+	}
+
+	journal = ctx->cache->journals + 1 - ctx->cache->current;
+
+	return cdict_find(journal->keys_entries, path, key, &i) && journal->entries[i].key == key;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+cache_record(struct context *ctx, enum cache_event event, const char *namespace, const char *name,
+             const cbook *values, size_t group)
+{
+	struct cache *cache = ctx->cache;
+	struct cache_journal *journal;
+	enum cache_event *tmp;
+	const char *word;
+	size_t n;
+
+	if (!cache || !cache->active)
+	{
+		return;
+	}
+
+	n = values ? cbook_group_length(values, group) : 0;
+
+	/* keep track of the state the next children will be evaluated under */
+
+	if (event != CACHE_RESOURCE)
+	{
+		cache->state = util_hash(cache->state, &event, sizeof(event));
+		cache->state = util_hash(cache->state, name, strlen(name) + 1);
+		for (size_t i = 0; i < n; i++)
+		{
+			word = cbook_word_in_group(values, group, i);
+			cache->state = util_hash(cache->state, word, strlen(word) + 1);
+		}
+	}
+
+	/* only save the event if it's part of a child's output */
+
+	journal = cache->journals + cache->current;
+
+	if (cache->recording == 0 || journal->err)
+	{
+		return;
+	}
+
+	if (!(tmp = util_reserve(journal->events, &journal->events_cap, journal->events_n + 1, sizeof(*tmp))))
+	{
+		journal->err = true;
+		return;
+	}
+
+	journal->events = tmp;
+	journal->events[journal->events_n++] = event;
+
+	cbook_prepare_new_group(journal->words);
+	cbook_write(journal->words, namespace);
+	cbook_write(journal->words, name);
+	for (size_t i = 0; i < n; i++)
+	{
+		cbook_write(journal->words, cbook_word_in_group(values, group, i));
+	}
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+bool
+cache_replay(struct context *ctx, const char *path, const struct cache_mark *mark)
+{
+	const struct cache_journal *journal;
+	const struct cache_entry *entry;
+	struct stat fs;
+	size_t i;
+
+	if (!mark->enabled)
+	{
+		return false;
+	}
+
+	journal = ctx->cache->journals + 1 - ctx->cache->current;
+
+	if (!cdict_find(journal->keys_entries, path, mark->key, &i) || journal->entries[i].key != mark->key)
+	{
+		return false;
+	}
+
+	entry = journal->entries + i;
+
+	/* make sure none of the files read by the child got modified, and keep their compiled streams */
+
+	for (i = entry->files_start; i < entry->files_end; i++)
+	{
+		if (!trace_check(&journal->files, i, &fs))
+		{
+			return false;
+		}
+
+		if (journal->files.files[i].exists)
+		{
+			stream_keep(*ctx->streams, &fs);
+		}
+	}
+
+	trace_append(ctx->trace, &journal->files, entry->files_start, entry->files_end);
+
+	/* splice the child's output */
+
+	for (i = entry->events_start; i < entry->events_end; i++)
+	{
+		apply(ctx, journal, i);
+	}
+
+	return true;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+cache_start(struct cache *cache, uint64_t hash)
+{
+	/* the journal written by the last load becomes the one entries are looked up from */
+
+	cache->current = 1 - cache->current;
+
+	clear_journal(cache->journals + cache->current);
+
+	if (cache->hash != hash)
+	{
+		clear_journal(cache->journals + 1 - cache->current);
+	}
+
+	cache->recording = 0;
+	cache->volatiles = 0;
+	cache->hash      = hash;
+	cache->state     = UTIL_HASH_INIT;
+	cache->active    = true;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+cache_stop(struct cache *cache, bool keep)
+{
+	if (!keep)
+	{
+		clear_journal(cache->journals + cache->current);
+	}
+
+	cache->active = false;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+cache_taint(struct context *ctx)
+{
+	if (ctx->cache)
+	{
+		ctx->cache->volatiles++;
+	}
+}
+
+/************************************************************************************************************/
+/* STATIC ***************************************************************************************************/
+/************************************************************************************************************/
+
+static void
+apply(struct context *ctx, const struct cache_journal *journal, size_t event)
+{
+	const char *namespace = cbook_word_in_group(journal->words, event, 0);
+	const char *name      = cbook_word_in_group(journal->words, event, 1);
+	size_t n              = cbook_group_length(journal->words, event);
+	size_t group;
+	size_t i;
+
+	/* same writes as the sequence handlers that generated the event */
+
+	switch (journal->events[event])
+	{
+		case CACHE_RESOURCE:
+			cbook_prepare_new_group(ctx->sequences);
+			for (size_t k = 2; k < n; k++)
+			{
+				cbook_write(ctx->sequences, cbook_word_in_group(journal->words, event, k));
+				numbers_push_str(ctx->numbers, cbook_word_in_group(journal->words, event, k));
+			}
+			if (!cdict_find(ctx->keys_sequences, namespace, 0, &i))
+			{
+				i = cbook_groups_number(ctx->sequences);
+				cdict_write(ctx->keys_sequences, namespace, 0, i);
+			}
+			group = cbook_groups_number(ctx->sequences) - 1;
+			cdict_write(ctx->keys_sequences, name, i, group);
+			cbook_prepare_new_group(ctx->names);
+			cbook_write(ctx->names, namespace);
+			cbook_write(ctx->names, name);
+			cache_record(ctx, CACHE_RESOURCE, namespace, name, ctx->sequences, group);
+			break;
+
+		case CACHE_VARIABLE:
+			cbook_prepare_new_group(ctx->vars);
+			for (size_t k = 2; k < n; k++)
+			{
+				cbook_write(ctx->vars, cbook_word_in_group(journal->words, event, k));
+			}
+			group = cbook_groups_number(ctx->vars) - 1;
+			cdict_write(ctx->keys_vars, name, CONTEXT_DICT_VARIABLE, group);
+			cache_record(ctx, CACHE_VARIABLE, "", name, ctx->vars, group);
+			break;
+
+		case CACHE_SECTION_ADD:
+			cdict_write(ctx->keys_vars, name, CONTEXT_DICT_SECTION, 0);
+			cache_record(ctx, CACHE_SECTION_ADD, "", name, NULL, 0);
+			break;
+
+		case CACHE_SECTION_DEL:
+			cdict_erase(ctx->keys_vars, name, CONTEXT_DICT_SECTION);
+			cache_record(ctx, CACHE_SECTION_DEL, "", name, NULL, 0);
+			break;
+	}
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+clear_journal(struct cache_journal *journal)
+{
+	cbook_repair(journal->words);
+	cdict_repair(journal->keys_entries);
+	cbook_clear(journal->words);
+	cdict_clear(journal->keys_entries);
+	trace_clear(&journal->files);
+
+	journal->events_n  = 0;
+	journal->entries_n = 0;
+	journal->err       = cbook_error(journal->words) || cdict_error(journal->keys_entries);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+free_journal(struct cache_journal *journal)
+{
+	cbook_destroy(journal->words);
+	cdict_destroy(journal->keys_entries);
+	trace_free(&journal->files);
+
+	free(journal->events);
+	free(journal->entries);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+init_journal(struct cache_journal *journal)
+{
+	journal->words        = cbook_create();
+	journal->keys_entries = cdict_create();
+	journal->events       = NULL;
+	journal->entries      = NULL;
+	journal->events_n     = 0;
+	journal->events_cap   = 0;
+	journal->entries_n    = 0;
+	journal->entries_cap  = 0;
+	journal->err          = cbook_error(journal->words) || cdict_error(journal->keys_entries);
+
+	trace_init(&journal->files);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static bool
+state_key(const struct context *ctx, uint64_t *key)
+{
+	const struct cache *cache = ctx->cache;
+
+	/* children included from within an iteration depend on the iterator values, they are never cached */
+	/* and neither are tracked children, since replayed events leave no dependencies behind them     */
+
+	if (!cache
+	 || !cache->active
+	 || cache->journals[cache->current].err
+	 || cbook_length(ctx->iteration) > 0
+	 || ctx->taint)
+	{
+		return false;
+	}
+
+	/* Besides variables and sections, a child also depends on the random number generator state, on how */
+	/* deep it gets included since the nesting depth is capped, and on the files that include it since    */
+	/* those are not allowed to be included again by the child.                                           */
+
+	*key = util_hash(cache->state, &ctx->rand,  sizeof(ctx->rand));
+	*key = util_hash(*key,         &ctx->depth, sizeof(ctx->depth));
+
+	for (const struct context *c = ctx; c; c = c->parent)
+	{
+		*key = util_hash(*key, &c->file_inode, sizeof(c->file_inode));
+	}
+
+	return true;
+}
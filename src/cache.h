@@ -0,0 +1,188 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#pragma once
+
+#include <cassette/ccfg.h>
+#include <cassette/cobj.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "context.h"
+#include "trace.h"
+
+/************************************************************************************************************/
+/* TYPES ****************************************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * Side effects a sequence can have on the parser state. Resources are written out but never read back during
+ * parsing, so only variable and section changes alter the way the following sequences get evaluated.
+ */
+enum cache_event
+{
+	CACHE_RESOURCE,
+	CACHE_VARIABLE,
+	CACHE_SECTION_ADD,
+	CACHE_SECTION_DEL,
+};
+
+/**
+ * Output of an included child file, as a range of journal events, and the range of journal files it read
+ * from. Entries are looked up by the child's path and by the key of the state it was evaluated under.
+ */
+struct cache_entry
+{
+	uint64_t key;
+	size_t events_start;
+	size_t events_end;
+	size_t files_start;
+	size_t files_end;
+};
+
+/**
+ * Every event produced during a load while at least one child file was being parsed. Events are stored as
+ * book groups, with the namespace as first word (empty if not a resource), the name as second word, and the
+ * values next.
+ */
+struct cache_journal
+{
+	cbook *words;
+	cdict *keys_entries;
+	enum cache_event *events;
+	struct cache_entry *entries;
+	struct trace files;
+	size_t events_n;
+	size_t events_cap;
+	size_t entries_n;
+	size_t entries_cap;
+	bool err;
+};
+
+/**
+ * State of the cache when a child starts being parsed.
+ */
+struct cache_mark
+{
+	uint64_t key;
+	size_t events;
+	size_t files;
+	size_t volatiles;
+	bool enabled;
+};
+
+/**
+ * Child files resources cache. The journal of the previous load is looked up while the current one is
+ * written. Once the load is over, the previous journal is dropped and the current one takes its place.
+ */
+struct cache
+{
+	struct cache_journal journals[2];
+	size_t current;
+	size_t recording;
+	size_t volatiles;
+	uint64_t hash;
+	uint64_t state;
+	bool active;
+};
+
+/************************************************************************************************************/
+/* CONSTRUCTORS / DESTRUCTORS *******************************************************************************/
+/************************************************************************************************************/
+
+void
+cache_init(struct cache *cache)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+cache_free(struct cache *cache)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/************************************************************************************************************/
+/* PROCEDURES ***********************************************************************************************/
+/************************************************************************************************************/
+
+void
+cache_begin(struct context *ctx, struct cache_mark *mark)
+CCFG_NONNULL(1, 2)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+cache_end(struct context *ctx, const char *path, const struct cache_mark *mark)
+CCFG_NONNULL(1, 2, 3)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+cache_record(struct context *ctx, enum cache_event event, const char *namespace, const char *name,
+             const cbook *values, size_t group)
+CCFG_NONNULL(1, 3, 4)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+bool
+cache_replay(struct context *ctx, const char *path, const struct cache_mark *mark)
+CCFG_NONNULL(1, 2, 3)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+cache_start(struct cache *cache, uint64_t hash)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+cache_stop(struct cache *cache, bool keep)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+cache_taint(struct context *ctx)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/************************************************************************************************************/
+/* FUNCTIONS ************************************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * Tells whether the previous load left an entry for the child at path under the current parser state,
+ * without starting to record anything. The entry may still get rejected by cache_replay() if the files it
+ * read from changed since.
+ */
+bool
+cache_probe(const struct context *ctx, const char *path)
+CCFG_NONNULL(1, 2)
+CCFG_HIDDEN
+CCFG_PURE;
@@ -0,0 +1,247 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#include <cassette/ccfg.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "channel.h"
+#include "freeze.h"
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+static bool attach     (struct channel *, const char *, bool) CCFG_NONNULL(1, 2);
+static bool table_name (char *, const char *, uint64_t)       CCFG_NONNULL(1, 2);
+
+/************************************************************************************************************/
+/* PRIVATE **************************************************************************************************/
+/************************************************************************************************************/
+
+void
+channel_free(struct channel *channel)
+{
+	if (channel->header)
+	{
+		munmap(channel->header, sizeof(struct channel_header));
+	}
+
+	channel_init(channel);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+channel_init(struct channel *channel)
+{
+	channel->header     = NULL;
+	channel->name[0]    = '\0';
+	channel->generation = 0;
+	channel->writable   = false;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+struct freeze *
+channel_poll(struct channel *channel, const char *name)
+{
+	struct freeze *freeze;
+	char table[NAME_MAX];
+	uint64_t generation;
+	int fd;
+
+	if (!attach(channel, name, false))
+	{
+		return NULL;
+	}
+
+	generation = atomic_load_explicit(&channel->header->generation, memory_order_acquire);
+
+	if (generation == 0 || generation == channel->generation || !table_name(table, name, generation))
+	{
+		return NULL;
+	}
+
+	/* the table may already have been replaced by a newer one, which the next poll will pick up */
+
+	if ((fd = shm_open(table, O_RDONLY, 0)) == -1)
+	{
+		return NULL;
+	}
+
+	freeze = freeze_map_fd(fd);
+
+	close(fd);
+
+	if (freeze)
+	{
+		channel->generation = generation;
+	}
+
+	return freeze;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+bool
+channel_publish(struct channel *channel, const char *name, const struct freeze *freeze)
+{
+	char table[NAME_MAX];
+	uint64_t generation;
+	bool ok;
+	int fd;
+
+	if (!attach(channel, name, true))
+	{
+		return false;
+	}
+
+	generation = atomic_load_explicit(&channel->header->generation, memory_order_relaxed) + 1;
+
+	if (!table_name(table, name, generation))
+	{
+		return false;
+	}
+
+	/* the table is complete before its generation gets announced, so subscribers never see it half done */
+
+	if ((fd = shm_open(table, O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH)) == -1)
+	{
+		return false;
+	}
+
+	ok = freeze_write(freeze, fd);
+	ok = close(fd) == 0 && ok;
+
+	if (!ok)
+	{
+		shm_unlink(table);
+		return false;
+	}
+
+	atomic_store_explicit(&channel->header->generation, generation, memory_order_release);
+
+	/* subscribers that mapped the previous table keep it alive until they unmap it */
+
+	if (generation > 1 && table_name(table, name, generation - 1))
+	{
+		shm_unlink(table);
+	}
+
+	return true;
+}
+
+/************************************************************************************************************/
+/* STATIC ***************************************************************************************************/
+/************************************************************************************************************/
+
+static bool
+attach(struct channel *channel, const char *name, bool writable)
+{
+	struct channel_header *header;
+	struct stat fs;
+	int prot;
+	int fd;
+
+	if (channel->header && (channel->writable || !writable) && !strcmp(channel->name, name))
+	{
+		return true;
+	}
+
+	if (strlen(name) >= NAME_MAX)
+	{
+		return false;
+	}
+
+	channel_free(channel);
+
+	if (writable)
+	{
+		fd   = shm_open(name, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+		prot = PROT_READ | PROT_WRITE;
+	}
+	else
+	{
+		fd   = shm_open(name, O_RDONLY, 0);
+		prot = PROT_READ;
+	}
+
+	if (fd == -1)
+	{
+		return false;
+	}
+
+	/* a channel that was just created is zero filled, which stands for no generation published yet */
+
+	if (fstat(fd, &fs) == -1
+	 || (fs.st_size == 0 && (!writable || ftruncate(fd, sizeof(struct channel_header)) == -1))
+	 || (fs.st_size != 0 && fs.st_size != sizeof(struct channel_header)))
+	{
+		close(fd);
+		return false;
+	}
+
+	header = mmap(0, sizeof(struct channel_header), prot, MAP_SHARED, fd, 0);
+
+	close(fd);
+
+	if (header == MAP_FAILED)
+	{
+		return false;
+	}
+
+	if (writable && header->magic == 0)
+	{
+		header->magic   = CHANNEL_MAGIC;
+		header->version = CHANNEL_VERSION;
+	}
+
+	if (header->magic != CHANNEL_MAGIC || header->version != CHANNEL_VERSION)
+	{
+		munmap(header, sizeof(struct channel_header));
+		return false;
+	}
+
+	strcpy(channel->name, name);
+
+	channel->header   = header;
+	channel->writable = writable;
+
+	return true;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static bool
+table_name(char *table, const char *name, uint64_t generation)
+{
+	return snprintf(table, NAME_MAX, "%s.%llu", name, (unsigned long long)generation) < NAME_MAX;
+}
@@ -0,0 +1,106 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#pragma once
+
+#include <cassette/ccfg.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "freeze.h"
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#define CHANNEL_MAGIC   0x43464343
+#define CHANNEL_VERSION 1
+
+/************************************************************************************************************/
+/* TYPES ****************************************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * Content of the shared memory object named after the channel. Each published table goes into an object of
+ * its own, named after the channel and the generation it was published as. Subscribers only have to load the
+ * generation counter to know whether there is something new to map.
+ */
+struct channel_header
+{
+	uint32_t magic;
+	uint32_t version;
+	_Atomic uint64_t generation;
+};
+
+/**
+ * Mapping of a channel's header, kept between calls so that polling a channel does not involve any system
+ * call while nothing new got published.
+ */
+struct channel
+{
+	struct channel_header *header;
+	char name[NAME_MAX];
+	uint64_t generation;
+	bool writable;
+};
+
+/************************************************************************************************************/
+/* CONSTRUCTORS / DESTRUCTORS *******************************************************************************/
+/************************************************************************************************************/
+
+void
+channel_init(struct channel *channel)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+channel_free(struct channel *channel)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/************************************************************************************************************/
+/* PROCEDURES ***********************************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * Maps the table of the latest generation published on the named channel, if it differs from the last one
+ * this channel mapped. Returns NULL otherwise, or if the channel or table cannot be opened.
+ */
+struct freeze *
+channel_poll(struct channel *channel, const char *name)
+CCFG_NONNULL(1, 2)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Copies the table into a new generation of the named channel, creating the channel if needed, and removes
+ * the name of the previous generation. Returns false on failure, in which case subscribers keep seeing the
+ * previous generation.
+ */
+bool
+channel_publish(struct channel *channel, const char *name, const struct freeze *freeze)
+CCFG_NONNULL(1, 2, 3)
+CCFG_HIDDEN;
@@ -27,53 +27,71 @@
 #include <string.h>
 
 #include "context.h"
+#include "loop.h"
+#include "scan.h"
+#include "stats.h"
 #include "substitution.h"
+#include "taint.h"
 #include "token.h"
+#include "util.h"
 
 /************************************************************************************************************/
 /************************************************************************************************************/
 /************************************************************************************************************/
 
-static char read_char    (struct context *)                              CCFG_NONNULL(1);
-static bool read_word    (struct context *, char [static TOKEN_MAX_LEN]) CCFG_NONNULL(1);
-static void update_state (struct context *, char)                        CCFG_NONNULL(1);
+static char read_char    (struct context *)                                   CCFG_NONNULL(1);
+static bool read_stream  (struct context *, struct token_view *, enum token *) CCFG_NONNULL(1, 2, 3);
+static bool read_token   (struct context *, struct token_view *, enum token *) CCFG_NONNULL(1, 2, 3);
+static bool read_word    (struct context *, struct token_view *)               CCFG_NONNULL(1, 2);
+static void update_state (struct context *, char)                             CCFG_NONNULL(1);
 
 /************************************************************************************************************/
 /* PRIVATE **************************************************************************************************/
 /************************************************************************************************************/
 
 enum token
-context_get_token(struct context *ctx, char token[static TOKEN_MAX_LEN], double *math_result)
+context_get_token(struct context *ctx, struct token_view *token, double *math_result)
 {
-	if (context_get_token_raw(ctx, token) == TOKEN_INVALID)
+	enum token type;
+
+	if (!read_token(ctx, token, &type))
 	{
 		return TOKEN_INVALID;
 	}
 
-	return substitution_apply(ctx, token, math_result);
+	return substitution_apply(ctx, token, math_result, type);
 }
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 
 enum token
-context_get_token_numeral(struct context *ctx, char token[static TOKEN_MAX_LEN], double *math_result)
+context_get_token_deferred(struct context *ctx, struct token_view *token)
+{
+	enum token type;
+
+	if (!read_token(ctx, token, &type))
+	{
+		return TOKEN_INVALID;
+	}
+
+	return substitution_defer(ctx, token, type);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+enum token
+context_get_token_numeral(struct context *ctx, struct token_view *token, double *math_result)
 {
 	bool err = false;
 
 	switch (context_get_token(ctx, token, math_result))
 	{
 		case TOKEN_NUMBER:
+		case TOKEN_COLOR:
 			return TOKEN_NUMBER;
 		
 		case TOKEN_STRING:
-			if (token[0] == '#')
-			{
-				*math_result = ccolor_to_argb_uint(ccolor_from_str(token, &err));
-			}
-			else
-			{
-				*math_result = strtod(token, NULL);
-			}
+			*math_result = util_str_to_double(token->chars, &err);
 			if (!err)
 			{
 				return TOKEN_NUMBER;
@@ -88,22 +106,11 @@ context_get_token_numeral(struct context *ctx, char token[static TOKEN_MAX_LEN],
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 
 enum token
-context_get_token_raw(struct context *ctx, char token[static TOKEN_MAX_LEN])
+context_get_token_raw(struct context *ctx, struct token_view *token)
 {
-	if (ctx->var_i < cbook_group_length(ctx->vars, ctx->var_group))
-	{
-		snprintf(token, TOKEN_MAX_LEN, "%s", cbook_word_in_group(ctx->vars, ctx->var_group, ctx->var_i++));
-	}
-	else if (ctx->it_i < cbook_group_length(ctx->iteration, ctx->it_group))
-	{
-		snprintf(token, TOKEN_MAX_LEN, "%s", cbook_word_in_group(ctx->iteration, ctx->it_group, ctx->it_i++));
-	}
-	else if (!read_word(ctx, token))
-	{
-		return TOKEN_INVALID;
-	}
-	
-	return TOKEN_STRING;
+	enum token type;
+
+	return read_token(ctx, token, &type) ? TOKEN_STRING : TOKEN_INVALID;
 }
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
@@ -111,8 +118,30 @@ context_get_token_raw(struct context *ctx, char token[static TOKEN_MAX_LEN])
 void
 context_goto_eol(struct context *ctx)
 {
-	while (!ctx->eol_reached)
+	size_t i;
+
+	/* compiled source, jump straight to the first word of the next line */
+
+	if (ctx->stream && !ctx->eol_reached)
 	{
+		if ((i = stream_skip(ctx->stream, ctx->buffer, ctx->word)) != SIZE_MAX)
+		{
+			ctx->eof_reached = ctx->stream->words[ctx->word].line_end == SIZE_MAX;
+			ctx->eol_reached = true;
+			ctx->word        = i;
+		}
+		else
+		{
+			ctx->buffer += ctx->stream->words[ctx->word].start;
+			ctx->stream  = NULL;
+		}
+	}
+
+	/* raw source */
+
+	if (!ctx->eol_reached)
+	{
+		ctx->buffer = scan_eol(ctx->buffer);
 		update_state(ctx, read_char(ctx));
 	}
 
@@ -120,6 +149,83 @@ context_goto_eol(struct context *ctx)
 	ctx->it_i  = SIZE_MAX;
 }
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+bool
+context_lex_word(struct context *ctx, struct token_view *token)
+{
+	return read_word(ctx, token);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+size_t
+context_line(struct context *ctx)
+{
+	const char *position;
+	const char *c;
+
+	if (ctx->it_i < cbook_group_length(ctx->iteration, ctx->it_group))
+	{
+		return loop_line(ctx->loop, ctx->it_group);
+	}
+
+	if (ctx->stream)
+	{
+		position = ctx->file_start + ctx->stream->words[ctx->word].start;
+	}
+	else
+	{
+		position = ctx->buffer;
+	}
+
+	/* the reading position only goes back when a sequence gets read again, which is rare enough */
+
+	if (position < ctx->line_start)
+	{
+		ctx->line_start = ctx->file_start;
+		ctx->line       = 1;
+	}
+
+	while ((c = memchr(ctx->line_start, '\n', position - ctx->line_start)))
+	{
+		ctx->line_start = c + 1;
+		ctx->line++;
+	}
+
+	return ctx->line;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+context_seek(struct context *ctx, const struct context_position *position)
+{
+	ctx->buffer      = position->buffer;
+	ctx->stream      = position->stream;
+	ctx->word        = position->word;
+	ctx->var_i       = position->var_i;
+	ctx->var_group   = position->var_group;
+	ctx->it_i        = position->it_i;
+	ctx->eol_reached = position->eol_reached;
+	ctx->eof_reached = position->eof_reached;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+context_tell(const struct context *ctx, struct context_position *position)
+{
+	position->buffer      = ctx->buffer;
+	position->stream      = ctx->stream;
+	position->word        = ctx->word;
+	position->var_i       = ctx->var_i;
+	position->var_group   = ctx->var_group;
+	position->it_i        = ctx->it_i;
+	position->eol_reached = ctx->eol_reached;
+	position->eof_reached = ctx->eof_reached;
+}
+
 /************************************************************************************************************/
 /* STATIC ***************************************************************************************************/
 /************************************************************************************************************/
@@ -133,9 +239,94 @@ read_char(struct context *ctx)
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 
 static bool
-read_word(struct context *ctx, char token[static TOKEN_MAX_LEN])
+read_stream(struct context *ctx, struct token_view *token, enum token *type)
 {
-	size_t i = 0;
+	const struct stream_word *word;
+
+	if (ctx->eol_reached)
+	{
+		return false;
+	}
+
+	/* the last word chains to itself, but past the end of the source read_word() only finds the null */
+	/* character, as when an escape ends the last line of an iteration body                            */
+
+	if (ctx->eof_reached)
+	{
+		ctx->eol_reached = true;
+		return false;
+	}
+
+	word = ctx->stream->words + ctx->word;
+
+	STATS_ADD(ctx->stats, tokens, 1);
+
+	token_view_borrow(token, cbook_word(ctx->stream->chars, word->chars));
+
+	ctx->eol_reached = word->eol;
+	ctx->eof_reached = word->eof || ctx->eof_reached;
+	ctx->word        = word->next;
+
+	*type = word->type;
+
+	return token->len > 0;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static bool
+read_token(struct context *ctx, struct token_view *token, enum token *type)
+{
+	size_t group = SIZE_MAX;
+
+	if (ctx->var_i < cbook_group_length(ctx->vars, ctx->var_group))
+	{
+		group = ctx->var_group;
+		token_view_borrow(token, cbook_word_in_group(ctx->vars, ctx->var_group, ctx->var_i++));
+	}
+	else if (ctx->it_i < cbook_group_length(ctx->iteration, ctx->it_group))
+	{
+		token_view_borrow(token, cbook_word_in_group(ctx->iteration, ctx->it_group, ctx->it_i));
+		*type = loop_type(ctx->loop, cbook_word_index(ctx->iteration, ctx->it_group, ctx->it_i++));
+		goto end;
+	}
+	else if (ctx->stream)
+	{
+		if (!read_stream(ctx, token, type))
+		{
+			return false;
+		}
+		goto end;
+	}
+	else if (read_word(ctx, token))
+	{
+		STATS_ADD(ctx->stats, tokens, 1);
+	}
+	else
+	{
+		return false;
+	}
+
+	STATS_ADD(ctx->stats, matches, 1);
+
+	*type = token_match(token->chars);
+
+end:
+
+	if (ctx->taint)
+	{
+		taint_read(ctx->taint, token->chars, group);
+	}
+
+	return true;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static bool
+read_word(struct context *ctx, struct token_view *token)
+{
+	size_t n;
 	bool quotes_1 = false;
 	bool quotes_2 = false;
 	char c;
@@ -147,29 +338,22 @@ read_word(struct context *ctx, char token[static TOKEN_MAX_LEN])
 
 	/* skip leading whitespaces */
 
+	ctx->buffer += scan_blanks(ctx->buffer);
+
+	token_view_clear(token);
+
+	/* read word, plain characters outside of quotes are copied in bulk */
+
 	for (;;)
 	{
-		switch ((c = read_char(ctx)))
+		if (!quotes_1 && !quotes_2)
 		{
-			case ' ' :
-			case '(' :
-			case ')' :
-			case '\t':
-			case '\v':
-				break;
-			
-			default:
-				goto exit_lead;
+			n = scan_word(ctx->buffer);
+			token_view_append(token, ctx->buffer, n);
+			ctx->buffer += n;
 		}
-	}
-
-exit_lead:
 
-	/* read word */
-
-	for (;; c = read_char(ctx))
-	{
-		switch (c)
+		switch ((c = read_char(ctx)))
 		{
 			case '\0':
 				goto exit_word;
@@ -204,10 +388,7 @@ exit_lead:
 
 			default:
 			char_add:
-				if (i < TOKEN_MAX_LEN - 1)
-				{
-					token[i++] = (char)c;
-				}
+				token_view_append(token, &c, 1);
 				break;
 		}
 	}
@@ -218,9 +399,7 @@ exit_word:
 
 	update_state(ctx, c);
 
-	token[i] = '\0';
-
-	return i;
+	return token->len > 0;
 }
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
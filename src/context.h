@@ -28,7 +28,17 @@
 #include <stdlib.h>
 #include <sys/types.h>
 
+#include "lazy.h"
+#include "loop.h"
+#include "memo.h"
+#include "numbers.h"
+#include "pool.h"
+#include "profile.h"
+#include "stats.h"
+#include "stream.h"
+#include "taint.h"
 #include "token.h"
+#include "trace.h"
 
 /************************************************************************************************************/
 /************************************************************************************************************/
@@ -40,23 +50,39 @@ struct context
 
 	const char *buffer; 
 
+	/* compiled source replay */
+
+	struct stream *stream;
+	struct stream **streams;
+	size_t word;
+
 	/* file data */
 
+	struct trace *trace;
 	ino_t file_inode;
 	off_t file_size;
 	char  file_dir[PATH_MAX];
+	const char *file_path;
+	const char *file_start;
+
+	/* line tracking, only kept up to date in profiling mode */
+
+	const char *line_start;
+	size_t line;
 
 	/* context states */
 
 	size_t depth;
 	bool eol_reached;
 	bool eof_reached;
+	bool eof_requested;
 	bool skip_sequences;
 
 	/* iteration injection */
 
 	size_t it_i;
 	size_t it_group;
+	struct loop *loop;
 
 	/* variable injection */
 
@@ -67,20 +93,45 @@ struct context
 
 	cbook *params;
 	cbook *sequences;
+	cbook *names;
+	struct numbers *numbers;
 	cbook *vars;
 	cbook *iteration;
+	cdict *keys_filters;
 	cdict *keys_params;
 	cdict *keys_sequences;
 	cdict *keys_vars;
-	cdict *tokens;
+	cstr *scratch;
 
 	/* misc */
 
 	struct context *parent;
+	struct cache *cache;
+	struct memo *memo;
+	struct lazy *lazy;
+	struct pool *pool;
+	struct stats *stats;
+	struct profile *profile;
+	struct taint *taint;
 	bool restricted;
 	crand rand;
 };
 
+/**
+ * Reading position of a context, so that the words read after it was taken can be read again.
+ */
+struct context_position
+{
+	const char *buffer;
+	struct stream *stream;
+	size_t word;
+	size_t var_i;
+	size_t var_group;
+	size_t it_i;
+	bool eol_reached;
+	bool eof_reached;
+};
+
 /************************************************************************************************************/
 /************************************************************************************************************/
 /************************************************************************************************************/
@@ -95,22 +146,32 @@ struct context
 /************************************************************************************************************/
 
 enum token
-context_get_token(struct context *ctx, char token[static TOKEN_MAX_LEN], double *math_result)
-CCFG_NONNULL(1)
+context_get_token(struct context *ctx, struct token_view *token, double *math_result)
+CCFG_NONNULL(1, 2)
 CCFG_HIDDEN;
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 
+/**
+ * Reads a token for a value whose evaluation gets deferred, see substitution_defer().
+ */
 enum token
-context_get_token_numeral(struct context *ctx, char token[static TOKEN_MAX_LEN], double *math_result)
-CCFG_NONNULL(1)
+context_get_token_deferred(struct context *ctx, struct token_view *token)
+CCFG_NONNULL(1, 2)
 CCFG_HIDDEN;
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 
 enum token
-context_get_token_raw(struct context *ctx, char token[static TOKEN_MAX_LEN])
-CCFG_NONNULL(1)
+context_get_token_numeral(struct context *ctx, struct token_view *token, double *math_result)
+CCFG_NONNULL(1, 2, 3)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+enum token
+context_get_token_raw(struct context *ctx, struct token_view *token)
+CCFG_NONNULL(1, 2)
 CCFG_HIDDEN;
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
@@ -119,3 +180,36 @@ void
 context_goto_eol(struct context *ctx)
 CCFG_NONNULL(1)
 CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+bool
+context_lex_word(struct context *ctx, struct token_view *token)
+CCFG_NONNULL(1, 2)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Returns the source line the next word will be read from. Words replayed from the iteration book are read
+ * from the line the FOR_EACH block had them on. Lines are counted from the last one returned, so the cost of
+ * a call only depends on the distance covered since the previous one.
+ */
+size_t
+context_line(struct context *ctx)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+context_seek(struct context *ctx, const struct context_position *position)
+CCFG_NONNULL(1, 2)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+context_tell(const struct context *ctx, struct context_position *position)
+CCFG_NONNULL(1, 2)
+CCFG_HIDDEN;
@@ -0,0 +1,379 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#include <cassette/ccfg.h>
+#include <cassette/cobj.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "diff.h"
+#include "util.h"
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+static void   clear_state   (struct diff_state *)                                              CCFG_NONNULL(1);
+static size_t find_resource (struct diff_state *, const char *, const char *, size_t)          CCFG_NONNULL(1, 2, 3);
+static void   push_change   (struct diff *, const char *, const char *, enum ccfg_change_type) CCFG_NONNULL(1, 2, 3);
+static bool   push_resource (struct diff_state *, const char *, const char *, uint64_t)        CCFG_NONNULL(1, 2, 3);
+
+/************************************************************************************************************/
+/* PRIVATE **************************************************************************************************/
+/************************************************************************************************************/
+
+void
+diff_begin(struct diff *diff)
+{
+	struct diff_state *previous;
+
+	diff->current = 1 - diff->current;
+	previous      = diff->states + 1 - diff->current;
+
+	clear_state(diff->states + diff->current);
+	cbook_clear(diff->changes);
+
+	for (size_t i = 0; i < cbook_groups_number(previous->names); i++)
+	{
+		previous->resources[i].seen = false;
+	}
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+diff_clear_callbacks(struct diff *diff)
+{
+	cbook_clear(diff->namespaces);
+
+	diff->callbacks_n = 0;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+diff_copy(struct diff *diff, const struct diff *src)
+{
+	const struct diff_state *state = src->states + src->current;
+
+	clear_state(diff->states + diff->current);
+
+	for (size_t i = 0; i < cbook_groups_number(state->names) && !diff->err; i++)
+	{
+		diff->err = !push_resource(
+			diff->states + diff->current,
+			cbook_word_in_group(state->names, i, 0),
+			cbook_word_in_group(state->names, i, 1),
+			state->resources[i].hash);
+	}
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+diff_end(struct diff *diff)
+{
+	const struct diff_state *previous = diff->states + 1 - diff->current;
+
+	for (size_t i = 0; i < cbook_groups_number(previous->names) && !diff->err; i++)
+	{
+		if (!previous->resources[i].seen)
+		{
+			push_change(
+				diff,
+				cbook_word_in_group(previous->names, i, 0),
+				cbook_word_in_group(previous->names, i, 1),
+				CCFG_CHANGE_REMOVED);
+		}
+	}
+
+	for (size_t i = 0; i < 2; i++)
+	{
+		diff->err = diff->err || cbook_error(diff->states[i].names) || cdict_error(diff->states[i].keys);
+	}
+
+	diff->err = diff->err || cbook_error(diff->changes) || cbook_error(diff->namespaces);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+diff_free(struct diff *diff)
+{
+	for (size_t i = 0; i < 2; i++)
+	{
+		cbook_destroy(diff->states[i].names);
+		cdict_destroy(diff->states[i].keys);
+		free(diff->states[i].resources);
+	}
+
+	cbook_destroy(diff->changes);
+	cbook_destroy(diff->namespaces);
+	free(diff->types);
+	free(diff->callbacks);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+diff_init(struct diff *diff)
+{
+	for (size_t i = 0; i < 2; i++)
+	{
+		diff->states[i].names         = cbook_create();
+		diff->states[i].keys          = cdict_create();
+		diff->states[i].resources     = NULL;
+		diff->states[i].resources_cap = 0;
+		diff->states[i].indexed       = false;
+	}
+
+	diff->current       = 0;
+	diff->changes       = cbook_create();
+	diff->types         = NULL;
+	diff->types_cap     = 0;
+	diff->namespaces    = cbook_create();
+	diff->callbacks     = NULL;
+	diff->callbacks_n   = 0;
+	diff->callbacks_cap = 0;
+	diff->enabled       = false;
+	diff->err           = false;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+bool
+diff_is_tracking(const struct diff *diff)
+{
+	return diff->enabled || diff->callbacks_n > 0;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+diff_notify(const struct diff *diff, ccfg *cfg)
+{
+	struct ccfg_change change;
+
+	if (diff->callbacks_n == 0)
+	{
+		return;
+	}
+
+	/* few callbacks are expected, matching them one after another is cheaper than keeping them indexed */
+
+	for (size_t i = 0; i < cbook_groups_number(diff->changes); i++)
+	{
+		change.namespace = cbook_word_in_group(diff->changes, i, 0);
+		change.property  = cbook_word_in_group(diff->changes, i, 1);
+		change.type      = diff->types[i];
+
+		for (size_t j = 0; j < diff->callbacks_n; j++)
+		{
+			if (!strcmp(cbook_word(diff->namespaces, j), change.namespace))
+			{
+				diff->callbacks[j].callback(cfg, &change, diff->callbacks[j].data);
+			}
+		}
+	}
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+diff_push(struct diff *diff, const char *namespace, const char *property, uint64_t hash)
+{
+	struct diff_state *previous = diff->states + 1 - diff->current;
+	size_t i;
+
+	if (diff->err)
+	{
+		return;
+	}
+
+	i = find_resource(previous, namespace, property, cbook_groups_number(diff->states[diff->current].names));
+
+	if (i == SIZE_MAX)
+	{
+		push_change(diff, namespace, property, CCFG_CHANGE_ADDED);
+	}
+	else
+	{
+		previous->resources[i].seen = true;
+		if (previous->resources[i].hash != hash)
+		{
+			push_change(diff, namespace, property, CCFG_CHANGE_MODIFIED);
+		}
+	}
+
+	if (!push_resource(diff->states + diff->current, namespace, property, hash))
+	{
+		diff->err = true;
+	}
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+diff_push_callback(struct diff *diff, const char *namespace, ccfg_change_callback callback, void *data)
+{
+	struct diff_callback *tmp;
+
+	if (!(tmp = util_reserve(diff->callbacks, &diff->callbacks_cap, diff->callbacks_n + 1, sizeof(*tmp))))
+	{
+		diff->err = true;
+		return;
+	}
+
+	cbook_write(diff->namespaces, namespace);
+
+	if (cbook_error(diff->namespaces))
+	{
+		diff->err = true;
+		return;
+	}
+
+	diff->callbacks = tmp;
+	diff->callbacks[diff->callbacks_n].callback = callback;
+	diff->callbacks[diff->callbacks_n].data     = data;
+	diff->callbacks_n++;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+diff_reset(struct diff *diff)
+{
+	for (size_t i = 0; i < 2; i++)
+	{
+		cbook_repair(diff->states[i].names);
+		cdict_repair(diff->states[i].keys);
+		clear_state(diff->states + i);
+	}
+
+	cbook_repair(diff->changes);
+	cbook_clear(diff->changes);
+
+	diff->err = cbook_error(diff->namespaces);
+}
+
+/************************************************************************************************************/
+/* STATIC ***************************************************************************************************/
+/************************************************************************************************************/
+
+static void
+clear_state(struct diff_state *state)
+{
+	cbook_clear(state->names);
+	cdict_clear(state->keys);
+
+	state->indexed = false;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static size_t
+find_resource(struct diff_state *state, const char *namespace, const char *property, size_t expected)
+{
+	const char *str;
+	size_t i;
+	size_t j;
+
+	if (expected < cbook_groups_number(state->names)
+	 && !strcmp(cbook_word_in_group(state->names, expected, 0), namespace)
+	 && !strcmp(cbook_word_in_group(state->names, expected, 1), property))
+	{
+		return expected;
+	}
+
+	/* namespaces are given values above 0, which is the group their own keys are written in */
+
+	for (size_t k = 0; k < cbook_groups_number(state->names) && !state->indexed; k++)
+	{
+		str = cbook_word_in_group(state->names, k, 0);
+		if (!cdict_find(state->keys, str, 0, &i))
+		{
+			i = k + 1;
+			cdict_write(state->keys, str, 0, i);
+		}
+		cdict_write(state->keys, cbook_word_in_group(state->names, k, 1), i, k);
+	}
+
+	state->indexed = true;
+
+	if (cdict_find(state->keys, namespace, 0, &i) && cdict_find(state->keys, property, i, &j))
+	{
+		return j;
+	}
+
+	return SIZE_MAX;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+push_change(struct diff *diff, const char *namespace, const char *property, enum ccfg_change_type type)
+{
+	enum ccfg_change_type *tmp;
+	size_t n;
+
+	n = cbook_groups_number(diff->changes);
+
+	if (!(tmp = util_reserve(diff->types, &diff->types_cap, n + 1, sizeof(*tmp))))
+	{
+		diff->err = true;
+		return;
+	}
+
+	diff->types    = tmp;
+	diff->types[n] = type;
+
+	cbook_prepare_new_group(diff->changes);
+	cbook_write(diff->changes, namespace);
+	cbook_write(diff->changes, property);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static bool
+push_resource(struct diff_state *state, const char *namespace, const char *property, uint64_t hash)
+{
+	struct diff_resource *tmp;
+	size_t n;
+
+	n = cbook_groups_number(state->names);
+
+	if (!(tmp = util_reserve(state->resources, &state->resources_cap, n + 1, sizeof(*tmp))))
+	{
+		return false;
+	}
+
+	state->resources = tmp;
+	state->resources[n].hash = hash;
+	state->resources[n].seen = false;
+
+	cbook_prepare_new_group(state->names);
+	cbook_write(state->names, namespace);
+	cbook_write(state->names, property);
+
+	return !cbook_error(state->names);
+}
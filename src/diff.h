@@ -0,0 +1,200 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#pragma once
+
+#include <cassette/ccfg.h>
+#include <cassette/cobj.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/************************************************************************************************************/
+/* TYPES ****************************************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * Resource of a tracked load, as a hash of its values. Seen marks the resources of the previous load that
+ * the current one also has.
+ */
+struct diff_resource
+{
+	uint64_t hash;
+	bool seen;
+};
+
+/**
+ * Resources of a tracked load. Names holds the namespace and property of each resource, one group per
+ * resource of the same index, and keys finds them from the namespace, then the property under the namespace's
+ * value, like keys_sequences does. Loads mostly declare the same resources in the same order as the previous
+ * one, which is checked first, so keys are only filled once a resource is not found where it was expected.
+ */
+struct diff_state
+{
+	cbook *names;
+	cdict *keys;
+	struct diff_resource *resources;
+	size_t resources_cap;
+	bool indexed;
+};
+
+/**
+ * Function registered with ccfg_push_change_callback(), along with its user data. The namespace it watches
+ * is the word of the same index in the namespaces book.
+ */
+struct diff_callback
+{
+	ccfg_change_callback callback;
+	void *data;
+};
+
+/**
+ * Changes of resources between the last two tracked loads. The resources of the previous load are kept in
+ * the state that is not current, and get compared to the current ones as they are pushed. Changes holds the
+ * namespace and property of each change, one group per change, and types what kind of change it is.
+ */
+struct diff
+{
+	struct diff_state states[2];
+	size_t current;
+	cbook *changes;
+	enum ccfg_change_type *types;
+	size_t types_cap;
+	cbook *namespaces;
+	struct diff_callback *callbacks;
+	size_t callbacks_n;
+	size_t callbacks_cap;
+	bool enabled;
+	bool err;
+};
+
+/************************************************************************************************************/
+/* CONSTRUCTORS / DESTRUCTORS *******************************************************************************/
+/************************************************************************************************************/
+
+void
+diff_init(struct diff *diff)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+diff_free(struct diff *diff)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/************************************************************************************************************/
+/* PROCEDURES ***********************************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * Starts a new tracked load, the resources of the last one becoming the previous ones.
+ */
+void
+diff_begin(struct diff *diff)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Forgets the registered callbacks.
+ */
+void
+diff_clear_callbacks(struct diff *diff)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Takes the resources of the last tracked load of src as if they were its own, so that its next load gets
+ * compared to them. Changes and callbacks are not copied.
+ */
+void
+diff_copy(struct diff *diff, const struct diff *src)
+CCFG_NONNULL(1, 2)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Ends the tracked load started by diff_begin(), and records the previous resources it does not have as
+ * removed.
+ */
+void
+diff_end(struct diff *diff)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Calls the callbacks watching the namespace of each change, in the order of the changes, then of the
+ * callbacks' registration.
+ */
+void
+diff_notify(const struct diff *diff, ccfg *cfg)
+CCFG_NONNULL(1, 2)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Adds a resource of the current load, given by the hash of its values, and records it as added or modified
+ * if it is new or if its hash differs from the one of the previous load. Each resource must be pushed once.
+ */
+void
+diff_push(struct diff *diff, const char *namespace, const char *property, uint64_t hash)
+CCFG_NONNULL(1, 2, 3)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+diff_push_callback(struct diff *diff, const char *namespace, ccfg_change_callback callback, void *data)
+CCFG_NONNULL(1, 2, 3)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Forgets the resources and changes of the tracked loads, so that the next one reports every resource as
+ * added. Callbacks are kept.
+ */
+void
+diff_reset(struct diff *diff)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/************************************************************************************************************/
+/* FUNCTIONS ************************************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * Tells whether loads need to be tracked, that is if tracking was enabled or a callback got registered.
+ */
+bool
+diff_is_tracking(const struct diff *diff)
+CCFG_NONNULL(1)
+CCFG_HIDDEN
+CCFG_PURE;
@@ -0,0 +1,342 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#include <cassette/ccfg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "feed.h"
+#include "scan.h"
+#include "token.h"
+#include "util.h"
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+static void add_chars (struct feed *, const char *, size_t) CCFG_NONNULL(1, 2);
+static void end_line (struct feed *)                       CCFG_NONNULL(1);
+static bool end_word (struct feed *)                       CCFG_NONNULL(1);
+static void scan     (struct feed *)                       CCFG_NONNULL(1);
+
+/************************************************************************************************************/
+/* PRIVATE **************************************************************************************************/
+/************************************************************************************************************/
+
+void
+feed_consume(struct feed *feed)
+{
+	memmove(feed->buffer, feed->buffer + feed->complete, feed->buffer_n - feed->complete + 1);
+
+	feed->buffer_n -= feed->complete;
+	feed->scanned  -= feed->complete;
+	feed->complete  = 0;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+struct feed *
+feed_create(void)
+{
+	struct feed *feed;
+
+	if (!(feed = malloc(sizeof(struct feed))))
+	{
+		return NULL;
+	}
+
+	feed->buffer     = NULL;
+	feed->buffer_n   = 0;
+	feed->buffer_cap = 0;
+	feed->scanned    = 0;
+	feed->complete   = 0;
+	feed->depth      = 0;
+	feed->word_n     = 0;
+	feed->word_open  = false;
+	feed->line_head  = true;
+	feed->escaped    = false;
+	feed->hold       = false;
+	feed->skip       = false;
+	feed->quotes_1   = false;
+	feed->quotes_2   = false;
+	feed->over       = false;
+	feed->err        = false;
+
+	/* the buffer is always kept null terminated for the lexer */
+
+	if (!(feed->buffer = util_reserve(NULL, &feed->buffer_cap, 1, 1)))
+	{
+		free(feed);
+		return NULL;
+	}
+
+	feed->buffer[0] = '\0';
+
+	return feed;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+feed_destroy(struct feed *feed)
+{
+	free(feed->buffer);
+	free(feed);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+feed_push(struct feed *feed, const char *data, size_t n)
+{
+	const char *end;
+	char *tmp;
+
+	if (feed->over || feed->err || n == 0)
+	{
+		return;
+	}
+
+	/* a null character ends an internal source, it does the same here */
+
+	if ((end = memchr(data, '\0', n)))
+	{
+		n = end - data;
+	}
+
+	if (n > SIZE_MAX - feed->buffer_n - 1
+	 || !(tmp = util_reserve(feed->buffer, &feed->buffer_cap, feed->buffer_n + n + 1, 1)))
+	{
+		feed->err = true;
+		return;
+	}
+
+	feed->buffer = tmp;
+	memcpy(feed->buffer + feed->buffer_n, data, n);
+	feed->buffer_n += n;
+	feed->buffer[feed->buffer_n] = '\0';
+
+	scan(feed);
+
+	if (end)
+	{
+		feed->complete = feed->buffer_n;
+		feed->over     = true;
+	}
+}
+
+/************************************************************************************************************/
+/* STATIC ***************************************************************************************************/
+/************************************************************************************************************/
+
+static void
+add_chars(struct feed *feed, const char *str, size_t n)
+{
+	size_t room;
+
+	/* words longer than a token key only need to be told apart from keys, which their length does */
+
+	if (n == 0)
+	{
+		return;
+	}
+
+	room = TOKEN_KEY_MAX_LEN + 1 - feed->word_n;
+	n    = n < room ? n : room;
+
+	memcpy(feed->word + feed->word_n, str, n);
+
+	feed->word_n   += n;
+	feed->word_open = true;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+end_line(struct feed *feed)
+{
+	feed->skip      = false;
+	feed->line_head = true;
+	feed->escaped   = false;
+
+	if (feed->depth == 0 && !feed->hold)
+	{
+		feed->complete = feed->scanned;
+	}
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static bool
+end_word(struct feed *feed)
+{
+	enum token type;
+
+	if (!feed->word_open)
+	{
+		return false;
+	}
+
+	feed->word[feed->word_n] = '\0';
+
+	type = token_match(feed->word);
+
+	/* inside FOR_EACH blocks, the parser only matches the first word of each line, to find FOR_END */
+
+	if (feed->depth == 0)
+	{
+		if (feed->escaped)
+		{
+			/* read raw by escape(), whatever it matches */
+			feed->escaped = false;
+		}
+		else if (type == TOKEN_ESCAPE)
+		{
+			feed->escaped = true;
+		}
+		else if (feed->line_head && type == TOKEN_FOR_BEGIN)
+		{
+			/* what follows the iterator is skipped by preproc_iter() */
+			feed->depth = 1;
+			feed->skip  = true;
+		}
+		else if (type == TOKEN_COMMENT)
+		{
+			feed->skip = true;
+		}
+	}
+	else if (feed->line_head && type == TOKEN_FOR_BEGIN)
+	{
+		feed->depth++;
+	}
+	else if (feed->line_head && type == TOKEN_FOR_END)
+	{
+		feed->depth--;
+		feed->skip = feed->depth == 0;
+	}
+	else if (type == TOKEN_ESCAPE)
+	{
+		/* iterated, it makes the lexer read on from the lines after FOR_END, as many times as there */
+		/* are iterations, so no line end that follows can be told to end a sequence anymore         */
+		feed->hold = true;
+	}
+
+	feed->word_n    = 0;
+	feed->word_open = false;
+	feed->line_head = false;
+
+	return feed->escaped;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+scan(struct feed *feed)
+{
+	const char *str;
+	size_t n;
+	char c;
+
+	while (feed->scanned < feed->buffer_n)
+	{
+		str = feed->buffer + feed->scanned;
+
+		/* rest of a line the parser skips, quotes do not matter there */
+
+		if (feed->skip)
+		{
+			feed->scanned = scan_eol(str) - feed->buffer;
+			if (feed->scanned < feed->buffer_n)
+			{
+				feed->scanned++;
+				end_line(feed);
+			}
+			continue;
+		}
+
+		/* plain characters outside of quotes are handled in bulk, as read_word() does */
+
+		if (!feed->quotes_1 && !feed->quotes_2)
+		{
+			n = scan_word(str);
+			add_chars(feed, str, n);
+			feed->scanned += n;
+			str           += n;
+			if (feed->scanned == feed->buffer_n)
+			{
+				break;
+			}
+		}
+
+		feed->scanned++;
+
+		switch ((c = *str))
+		{
+			case ' ' :
+			case '(' :
+			case ')' :
+			case '\t':
+			case '\v':
+			case '\n':
+				if (feed->quotes_1 || feed->quotes_2)
+				{
+					/* a sequence that fails before reaching a quoted newline skips to it as to a line end */
+					feed->hold = feed->hold || c == '\n';
+					goto char_add;
+				}
+				/* an escape right before a newline makes the lexer read on from the next line */
+				if (end_word(feed) && c == '\n')
+				{
+					break;
+				}
+				if (c == '\n')
+				{
+					end_line(feed);
+				}
+				break;
+
+			case '\'':
+				if (!feed->quotes_2)
+				{
+					feed->quotes_1  = !feed->quotes_1;
+					feed->word_open = true;
+					break;
+				}
+				goto char_add;
+
+			case '\"':
+				if (!feed->quotes_1)
+				{
+					feed->quotes_2  = !feed->quotes_2;
+					feed->word_open = true;
+					break;
+				}
+				goto char_add;
+
+			default:
+			char_add:
+				add_chars(feed, &c, 1);
+				break;
+		}
+	}
+}
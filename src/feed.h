@@ -0,0 +1,109 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#pragma once
+
+#include <cassette/ccfg.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "context.h"
+#include "token.h"
+
+/************************************************************************************************************/
+/* TYPES ****************************************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * Root source handed over in chunks by ccfg_stream_feed(). The lexer reads from a single null terminated
+ * buffer and cannot stop in the middle of a word, so chunks are appended to a buffer that gets scanned as it
+ * grows for the end of the last complete sequence, following the same word, quote and FOR_EACH block rules
+ * as the parser. Everything before that point, up to complete, can be parsed right away, and only the
+ * unfinished tail is kept for the next chunk. A line that ends with an escape token goes on with the next
+ * one, whose first word is read as is. Some line ends depend on how sequences get evaluated : an escape
+ * token inside a FOR_EACH block makes the iterated sequences read on from the lines after the block, as many
+ * times as there are iterations, and a newline inside quotes ends the line of a sequence that fails before
+ * reaching the quoted word. Once either is met, hold keeps the rest of the source buffered until it ends.
+ * Ctx is the parser state of the source, kept between parses. Once over, because of a null character or an
+ * EOF token, the data that follows is ignored.
+ */
+struct feed
+{
+	struct context ctx;
+	char *buffer;
+	size_t buffer_n;
+	size_t buffer_cap;
+	size_t scanned;
+	size_t complete;
+	size_t depth;
+	char word[TOKEN_KEY_MAX_LEN + 2];
+	size_t word_n;
+	bool word_open;
+	bool line_head;
+	bool escaped;
+	bool hold;
+	bool skip;
+	bool quotes_1;
+	bool quotes_2;
+	bool over;
+	bool err;
+};
+
+/************************************************************************************************************/
+/* CONSTRUCTORS / DESTRUCTORS *******************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * Allocates an empty feed. Its context is left for the caller to set up. Returns NULL on failure.
+ */
+struct feed *
+feed_create(void)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+feed_destroy(struct feed *feed)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/************************************************************************************************************/
+/* PROCEDURES ***********************************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * Drops the complete part of the buffer once it was parsed, moving the tail to the front.
+ */
+void
+feed_consume(struct feed *feed)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Appends n bytes of data to the buffer and moves complete forward to the end of the last sequence they
+ * finished. A null character in data ends the source, everything buffered until it is then complete.
+ */
+void
+feed_push(struct feed *feed, const char *data, size_t n)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
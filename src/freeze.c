@@ -0,0 +1,482 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#include <cassette/ccfg.h>
+#include <cassette/cobj.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "freeze.h"
+#include "intern.h"
+#include "numbers.h"
+#include "util.h"
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#define ARENA(F)   ((const char*)(F) + (F)->arena)
+#define ENTRIES(F) ((const struct freeze_entry*)((const char*)(F) + (F)->entries))
+#define NUMBERS(F) ((const double*)((const char*)(F) + (F)->numbers))
+#define SLOTS(F)   ((const uint32_t*)((const char*)(F) + (F)->slots))
+#define VALUES(F)  ((const uint32_t*)((const char*)(F) + (F)->values))
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+static uint64_t hash_pair (const char *, const char *)                              CCFG_NONNULL(1, 2) CCFG_PURE;
+static bool     is_live   (const cbook *, const cdict *, size_t)                    CCFG_NONNULL(1, 2) CCFG_PURE;
+static bool     is_valid  (const struct freeze *, size_t)                           CCFG_NONNULL(1) CCFG_PURE;
+static uint64_t layout    (struct freeze *, uint64_t, uint64_t, uint64_t, uint64_t) CCFG_NONNULL(1);
+
+/************************************************************************************************************/
+/* PRIVATE **************************************************************************************************/
+/************************************************************************************************************/
+
+struct freeze *
+freeze_create(const cbook *sequences, const cbook *names, const cdict *keys_sequences,
+              const struct numbers *numbers, enum cerr *err)
+{
+	struct freeze *freeze;
+	struct freeze_entry *entries;
+	double *numbers_f;
+	uint32_t *slots;
+	uint32_t *values;
+	char *arena;
+	const char *namespace;
+	const char *property;
+	struct intern intern;
+	size_t entries_n = 0;
+	size_t values_n  = 0;
+	size_t slots_n   = 1;
+	struct freeze tmp;
+	uint64_t size;
+	size_t i;
+	uint32_t v = 0;
+	uint32_t e = 0;
+
+	intern_init(&intern);
+
+	/* measure the table, only the latest definition of each resource is kept, and strings are stored once */
+
+	for (size_t g = 0; g < cbook_groups_number(names); g++)
+	{
+		if (!is_live(names, keys_sequences, g))
+		{
+			continue;
+		}
+
+		entries_n++;
+		values_n += cbook_group_length(sequences, g);
+		intern_push(&intern, cbook_word_in_group(names, g, 0));
+		intern_push(&intern, cbook_word_in_group(names, g, 1));
+		for (size_t k = 0; k < cbook_group_length(sequences, g); k++)
+		{
+			intern_push(&intern, cbook_word_in_group(sequences, g, k));
+		}
+	}
+
+	if (intern.err)
+	{
+		intern_free(&intern);
+		*err = CERR_MEMORY;
+		return NULL;
+	}
+
+	while (slots_n < entries_n * 2)
+	{
+		slots_n *= 2;
+	}
+
+	if ((size = layout(&tmp, entries_n, values_n, slots_n, intern.size)) > UINT32_MAX)
+	{
+		intern_free(&intern);
+		*err = CERR_OVERFLOW;
+		return NULL;
+	}
+
+	if (!(freeze = calloc(1, size)))
+	{
+		intern_free(&intern);
+		*err = CERR_MEMORY;
+		return NULL;
+	}
+
+	*freeze = tmp;
+
+	entries   = (struct freeze_entry*)((char*)freeze + freeze->entries);
+	numbers_f = (double*)((char*)freeze + freeze->numbers);
+	slots     = (uint32_t*)((char*)freeze + freeze->slots);
+	values    = (uint32_t*)((char*)freeze + freeze->values);
+	arena     = (char*)freeze + freeze->arena;
+
+	/* fill the table, every string was already given its offset while measuring */
+
+	intern_write(&intern, arena);
+
+	for (size_t g = 0; g < cbook_groups_number(names); g++)
+	{
+		if (!is_live(names, keys_sequences, g))
+		{
+			continue;
+		}
+
+		namespace = cbook_word_in_group(names, g, 0);
+		property  = cbook_word_in_group(names, g, 1);
+
+		entries[e].hash      = hash_pair(namespace, property);
+		entries[e].namespace = intern_push(&intern, namespace);
+		entries[e].property  = intern_push(&intern, property);
+		entries[e].values    = v;
+		entries[e].values_n  = cbook_group_length(sequences, g);
+
+		for (size_t k = 0; k < entries[e].values_n; k++)
+		{
+			numbers_f[v] = numbers_get(numbers, cbook_word_index(sequences, g, k));
+			values[v++]  = intern_push(&intern, cbook_word_in_group(sequences, g, k));
+		}
+
+		for (i = entries[e].hash & (slots_n - 1); slots[i] > 0; i = (i + 1) & (slots_n - 1));
+
+		slots[i] = ++e;
+	}
+
+	intern_free(&intern);
+
+	return freeze;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+freeze_destroy(struct freeze *freeze, bool mapped)
+{
+	if (freeze && mapped)
+	{
+		munmap(freeze, freeze->size);
+	}
+	else
+	{
+		free(freeze);
+	}
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+size_t
+freeze_find(const struct freeze *freeze, const char *namespace, const char *property)
+{
+	const struct freeze_entry *entry;
+	const uint32_t *slots = SLOTS(freeze);
+	uint64_t hash;
+	size_t mask;
+
+	hash = hash_pair(namespace, property);
+	mask = freeze->slots_n - 1;
+
+	/* the table is never more than half full, so probing always ends on an empty slot */
+
+	for (size_t i = hash & mask; slots[i] > 0; i = (i + 1) & mask)
+	{
+		entry = ENTRIES(freeze) + slots[i] - 1;
+		if (entry->hash == hash
+		 && !strcmp(ARENA(freeze) + entry->namespace, namespace)
+		 && !strcmp(ARENA(freeze) + entry->property,  property))
+		{
+			return slots[i] - 1;
+		}
+	}
+
+	return SIZE_MAX;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+size_t
+freeze_length(const struct freeze *freeze, size_t entry)
+{
+	if (entry >= freeze->entries_n)
+	{
+		return 0;
+	}
+
+	return ENTRIES(freeze)[entry].values_n;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+struct freeze *
+freeze_map(const char *path)
+{
+	struct freeze *freeze;
+	int fd;
+
+	if ((fd = open(path, O_RDONLY)) == -1)
+	{
+		return NULL;
+	}
+
+	freeze = freeze_map_fd(fd);
+
+	close(fd);
+
+	return freeze;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+struct freeze *
+freeze_map_fd(int fd)
+{
+	struct stat fs;
+	void *map;
+
+	if (fstat(fd, &fs) == -1 || fs.st_size < (off_t)sizeof(struct freeze) || fs.st_size > UINT32_MAX)
+	{
+		return NULL;
+	}
+
+	/* shared mappings let every process that maps the same file use the same page cache pages */
+
+	if ((map = mmap(0, fs.st_size, PROT_READ, MAP_SHARED, fd, 0)) == MAP_FAILED)
+	{
+		return NULL;
+	}
+
+	if (!is_valid(map, fs.st_size))
+	{
+		munmap(map, fs.st_size);
+		return NULL;
+	}
+
+	return map;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+const char *
+freeze_namespace(const struct freeze *freeze, size_t entry)
+{
+	if (entry >= freeze->entries_n)
+	{
+		return "";
+	}
+
+	return ARENA(freeze) + ENTRIES(freeze)[entry].namespace;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+double
+freeze_number(const struct freeze *freeze, size_t entry, size_t i)
+{
+	if (entry >= freeze->entries_n || i >= ENTRIES(freeze)[entry].values_n)
+	{
+		return NAN;
+	}
+
+	return NUMBERS(freeze)[ENTRIES(freeze)[entry].values + i];
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+const char *
+freeze_property(const struct freeze *freeze, size_t entry)
+{
+	if (entry >= freeze->entries_n)
+	{
+		return "";
+	}
+
+	return ARENA(freeze) + ENTRIES(freeze)[entry].property;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+bool
+freeze_save(const struct freeze *freeze, const char *path)
+{
+	char tmp[PATH_MAX];
+	bool ok;
+	int fd;
+
+	if (snprintf(tmp, PATH_MAX, "%s.XXXXXX", path) >= PATH_MAX || (fd = mkstemp(tmp)) == -1)
+	{
+		return false;
+	}
+
+	ok = fchmod(fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH) == 0 && freeze_write(freeze, fd);
+	ok = close(fd) == 0 && ok;
+
+	/* the file is swapped in whole, it never gets truncated or rewritten under someone's mapping */
+
+	if (!ok || rename(tmp, path) == -1)
+	{
+		unlink(tmp);
+		return false;
+	}
+
+	return true;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+const char *
+freeze_value(const struct freeze *freeze, size_t entry, size_t i)
+{
+	if (entry >= freeze->entries_n || i >= ENTRIES(freeze)[entry].values_n)
+	{
+		return "";
+	}
+
+	return ARENA(freeze) + VALUES(freeze)[ENTRIES(freeze)[entry].values + i];
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+bool
+freeze_write(const struct freeze *freeze, int fd)
+{
+	ssize_t written;
+
+	for (size_t i = 0; i < freeze->size; i += written)
+	{
+		if ((written = write(fd, (const char*)freeze + i, freeze->size - i)) <= 0)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+/************************************************************************************************************/
+/* STATIC ***************************************************************************************************/
+/************************************************************************************************************/
+
+static uint64_t
+hash_pair(const char *namespace, const char *property)
+{
+	uint64_t hash;
+
+	hash = util_hash(UTIL_HASH_INIT, namespace, strlen(namespace) + 1);
+	hash = util_hash(hash, property, strlen(property) + 1);
+
+	return hash;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static bool
+is_live(const cbook *names, const cdict *keys_sequences, size_t group)
+{
+	size_t i;
+	size_t j;
+
+	/* redefined resources leave their older groups behind, those are not referenced anymore */
+
+	return cdict_find(keys_sequences, cbook_word_in_group(names, group, 0), 0, &i)
+	    && cdict_find(keys_sequences, cbook_word_in_group(names, group, 1), i, &j)
+	    && j == group;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static bool
+is_valid(const struct freeze *freeze, size_t size)
+{
+	struct freeze tmp;
+
+	/* the layout is entirely determined by the counts, so the offsets have to match the ones it implies */
+
+	if (freeze->magic   != FREEZE_MAGIC
+	 || freeze->version != FREEZE_VERSION
+	 || freeze->size    != size
+	 || freeze->slots_n == 0
+	 || (freeze->slots_n & (freeze->slots_n - 1)) != 0
+	 || freeze->entries_n >= freeze->slots_n
+	 || freeze->arena > size)
+	{
+		return false;
+	}
+
+	if (layout(&tmp, freeze->entries_n, freeze->values_n, freeze->slots_n, size - freeze->arena) != size
+	 || tmp.entries != freeze->entries
+	 || tmp.numbers != freeze->numbers
+	 || tmp.slots   != freeze->slots
+	 || tmp.values  != freeze->values
+	 || tmp.arena   != freeze->arena)
+	{
+		return false;
+	}
+
+	/* strings are read from offsets into the arena, which has to end with a terminator */
+
+	return freeze->arena == size || ((const char*)freeze)[size - 1] == '\0';
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static uint64_t
+layout(struct freeze *freeze, uint64_t entries_n, uint64_t values_n, uint64_t slots_n, uint64_t arena_n)
+{
+	uint64_t header;
+	uint64_t size;
+
+	/* entries and numbers come first after the header to keep their 64 bits fields aligned */
+
+	header = (sizeof(struct freeze) + sizeof(double) - 1) / sizeof(double) * sizeof(double);
+
+	size = header
+		+ entries_n * sizeof(struct freeze_entry)
+		+ values_n  * sizeof(double)
+		+ slots_n   * sizeof(uint32_t)
+		+ values_n  * sizeof(uint32_t)
+		+ arena_n;
+
+	if (size > UINT32_MAX)
+	{
+		return size;
+	}
+
+	freeze->magic     = FREEZE_MAGIC;
+	freeze->version   = FREEZE_VERSION;
+	freeze->size      = size;
+	freeze->slots_n   = slots_n;
+	freeze->entries_n = entries_n;
+	freeze->values_n  = values_n;
+	freeze->entries   = header;
+	freeze->numbers   = freeze->entries + entries_n * sizeof(struct freeze_entry);
+	freeze->slots     = freeze->numbers + values_n  * sizeof(double);
+	freeze->values    = freeze->slots   + slots_n   * sizeof(uint32_t);
+	freeze->arena     = freeze->values  + values_n  * sizeof(uint32_t);
+
+	return size;
+}
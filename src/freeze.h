@@ -0,0 +1,192 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#pragma once
+
+#include <cassette/ccfg.h>
+#include <cassette/cobj.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "numbers.h"
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#define FREEZE_MAGIC   0x5a464343
+#define FREEZE_VERSION 1
+
+/************************************************************************************************************/
+/* TYPES ****************************************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * Resource entry, all fields except the hash are offsets or indexes within the table.
+ */
+struct freeze_entry
+{
+	uint64_t hash;
+	uint32_t namespace;
+	uint32_t property;
+	uint32_t values;
+	uint32_t values_n;
+};
+
+/**
+ * Read-only resource table packed into a single memory block made of this header, followed by the entries,
+ * the numerical form of all values, an open addressing hash table of entry indexes (0 meaning empty,
+ * otherwise index + 1), the value offsets of all resources, and the arena holding all the strings. Each
+ * distinct string is stored only once, so that names and values repeated across resources share the same
+ * offset. Since only offsets relative to the start of the block are stored, the block can be copied, or
+ * written to a file and mapped back anywhere as is. The magic number and version identify such files, and
+ * also reject the ones written on a machine of another byte order.
+ */
+struct freeze
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t size;
+	uint32_t slots_n;
+	uint32_t entries_n;
+	uint32_t values_n;
+	uint32_t slots;
+	uint32_t entries;
+	uint32_t numbers;
+	uint32_t values;
+	uint32_t arena;
+};
+
+/************************************************************************************************************/
+/* CONSTRUCTORS / DESTRUCTORS *******************************************************************************/
+/************************************************************************************************************/
+
+struct freeze *
+freeze_create(const cbook *sequences, const cbook *names, const cdict *keys_sequences,
+              const struct numbers *numbers, enum cerr *err)
+CCFG_NONNULL(1, 2, 3, 4, 5)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Maps a table previously written by freeze_save(). Returns NULL if the file cannot be mapped, or if it does
+ * not hold a table of the current version.
+ */
+struct freeze *
+freeze_map(const char *path)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Same as freeze_map(), from an open descriptor, which is left open.
+ */
+struct freeze *
+freeze_map_fd(int fd)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Frees a table obtained from freeze_create(), or unmaps one obtained from freeze_map().
+ */
+void
+freeze_destroy(struct freeze *freeze, bool mapped)
+CCFG_HIDDEN;
+
+/************************************************************************************************************/
+/* PROCEDURES ***********************************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * Writes the table into a new file that then replaces the one at path, so that processes that mapped the
+ * previous file keep reading it undisturbed. Returns false on failure, in which case the file at path is
+ * left as it was.
+ */
+bool
+freeze_save(const struct freeze *freeze, const char *path)
+CCFG_NONNULL(1, 2)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Writes the whole table to the descriptor, from its current position. Returns false on failure.
+ */
+bool
+freeze_write(const struct freeze *freeze, int fd)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/************************************************************************************************************/
+/* FUNCTIONS ************************************************************************************************/
+/************************************************************************************************************/
+
+size_t
+freeze_find(const struct freeze *freeze, const char *namespace, const char *property)
+CCFG_NONNULL(1, 2, 3)
+CCFG_HIDDEN
+CCFG_PURE;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+size_t
+freeze_length(const struct freeze *freeze, size_t entry)
+CCFG_NONNULL(1)
+CCFG_HIDDEN
+CCFG_PURE;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+const char *
+freeze_namespace(const struct freeze *freeze, size_t entry)
+CCFG_NONNULL_RETURN
+CCFG_NONNULL(1)
+CCFG_HIDDEN
+CCFG_PURE;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+double
+freeze_number(const struct freeze *freeze, size_t entry, size_t i)
+CCFG_NONNULL(1)
+CCFG_HIDDEN
+CCFG_PURE;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+const char *
+freeze_property(const struct freeze *freeze, size_t entry)
+CCFG_NONNULL_RETURN
+CCFG_NONNULL(1)
+CCFG_HIDDEN
+CCFG_PURE;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+const char *
+freeze_value(const struct freeze *freeze, size_t entry, size_t i)
+CCFG_NONNULL_RETURN
+CCFG_NONNULL(1)
+CCFG_HIDDEN
+CCFG_PURE;
@@ -0,0 +1,176 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#include <cassette/ccfg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "intern.h"
+#include "util.h"
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+static size_t find (const struct intern *, const char *, uint64_t) CCFG_NONNULL(1, 2) CCFG_PURE;
+static bool   grow (struct intern *)                               CCFG_NONNULL(1);
+
+/************************************************************************************************************/
+/* PRIVATE **************************************************************************************************/
+/************************************************************************************************************/
+
+void
+intern_free(struct intern *intern)
+{
+	free(intern->slots);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+intern_init(struct intern *intern)
+{
+	intern->slots     = NULL;
+	intern->slots_n   = 0;
+	intern->strings_n = 0;
+	intern->size      = 0;
+	intern->err       = false;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+size_t
+intern_push(struct intern *intern, const char *str)
+{
+	struct intern_slot *slot;
+	uint64_t hash;
+	size_t len;
+
+	len  = strlen(str);
+	hash = util_hash(UTIL_HASH_INIT, str, len);
+
+	if (intern->err || ((intern->strings_n + 1) * 2 > intern->slots_n && !grow(intern)))
+	{
+		intern->err = true;
+		return SIZE_MAX;
+	}
+
+	slot = intern->slots + find(intern, str, hash);
+
+	if (slot->str)
+	{
+		return slot->offset;
+	}
+
+	if (len >= SIZE_MAX - intern->size)
+	{
+		intern->err = true;
+		return SIZE_MAX;
+	}
+
+	slot->hash   = hash;
+	slot->str    = str;
+	slot->offset = intern->size;
+
+	intern->size += len + 1;
+	intern->strings_n++;
+
+	return slot->offset;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+intern_write(const struct intern *intern, char *arena)
+{
+	const struct intern_slot *slot;
+
+	for (size_t i = 0; i < intern->slots_n; i++)
+	{
+		slot = intern->slots + i;
+		if (slot->str)
+		{
+			memcpy(arena + slot->offset, slot->str, strlen(slot->str) + 1);
+		}
+	}
+}
+
+/************************************************************************************************************/
+/* STATIC ***************************************************************************************************/
+/************************************************************************************************************/
+
+static size_t
+find(const struct intern *intern, const char *str, uint64_t hash)
+{
+	const struct intern_slot *slot;
+	size_t mask = intern->slots_n - 1;
+	size_t i;
+
+	/* probing ends either on the slot of the same string or on the empty slot it would go into */
+
+	for (i = hash & mask; (slot = intern->slots + i)->str; i = (i + 1) & mask)
+	{
+		if (slot->hash == hash && !strcmp(slot->str, str))
+		{
+			break;
+		}
+	}
+
+	return i;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static bool
+grow(struct intern *intern)
+{
+	struct intern_slot *slots;
+	struct intern_slot *slots_old = intern->slots;
+	size_t slots_n_old = intern->slots_n;
+	size_t slots_n;
+	size_t i;
+
+	slots_n = slots_n_old > 0 ? slots_n_old * 2 : 64;
+
+	if (slots_n > SIZE_MAX / sizeof(*slots) || !(slots = calloc(slots_n, sizeof(*slots))))
+	{
+		return false;
+	}
+
+	/* strings keep their offsets, only their slots move */
+
+	intern->slots   = slots;
+	intern->slots_n = slots_n;
+
+	for (size_t k = 0; k < slots_n_old; k++)
+	{
+		if (slots_old[k].str)
+		{
+			for (i = slots_old[k].hash & (slots_n - 1); slots[i].str; i = (i + 1) & (slots_n - 1));
+			slots[i] = slots_old[k];
+		}
+	}
+
+	free(slots_old);
+
+	return true;
+}
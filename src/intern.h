@@ -0,0 +1,95 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#pragma once
+
+#include <cassette/ccfg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/************************************************************************************************************/
+/* TYPES ****************************************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * Distinct string pushed to the pool, along with its hash and the offset it was given in the arena. A NULL
+ * string marks an empty slot.
+ */
+struct intern_slot
+{
+	uint64_t hash;
+	const char *str;
+	size_t offset;
+};
+
+/**
+ * Pool laying out strings into an arena so that each distinct string is stored only once, however many times
+ * it was pushed. Strings are not copied, they are referred to until the pool gets written out, and must stay
+ * unchanged until then. Slots are an open addressing hash table that is never more than half full. Size is
+ * the size the arena needs to hold every string pushed so far, terminators included.
+ */
+struct intern
+{
+	struct intern_slot *slots;
+	size_t slots_n;
+	size_t strings_n;
+	size_t size;
+	bool err;
+};
+
+/************************************************************************************************************/
+/* CONSTRUCTORS / DESTRUCTORS *******************************************************************************/
+/************************************************************************************************************/
+
+void
+intern_init(struct intern *intern)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+intern_free(struct intern *intern)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/************************************************************************************************************/
+/* PROCEDURES ***********************************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * Gets the offset of a string in the arena, which is given to it if it was not pushed before. Returns
+ * SIZE_MAX on failure.
+ */
+size_t
+intern_push(struct intern *intern, const char *str)
+CCFG_NONNULL(1, 2)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Copies every distinct string to its offset in the arena, which must be at least intern->size bytes large.
+ */
+void
+intern_write(const struct intern *intern, char *arena)
+CCFG_NONNULL(1, 2)
+CCFG_HIDDEN;
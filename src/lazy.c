@@ -0,0 +1,228 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#include <cassette/ccfg.h>
+#include <cassette/cobj.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "lazy.h"
+#include "numbers.h"
+#include "util.h"
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+static void copy_group (cbook *, struct numbers *, const cbook *, const struct numbers *, size_t) CCFG_NONNULL(1, 2, 3, 4);
+static void rebind     (const struct lazy *, cdict *, const cbook *, size_t)                      CCFG_NONNULL(1, 2, 3);
+
+/************************************************************************************************************/
+/* PRIVATE **************************************************************************************************/
+/************************************************************************************************************/
+
+void
+lazy_clear(struct lazy *lazy)
+{
+	cbook_clear(lazy->words);
+	cbook_clear(lazy->values);
+	numbers_clear(&lazy->numbers);
+
+	lazy->entries_n = 0;
+	lazy->pending   = 0;
+	lazy->err       = false;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+struct lazy_entry *
+lazy_entry(const struct lazy *lazy, size_t group)
+{
+	return group < lazy->entries_n && lazy->entries[group].words != SIZE_MAX ? lazy->entries + group : NULL;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+lazy_free(struct lazy *lazy)
+{
+	cbook_destroy(lazy->words);
+	cbook_destroy(lazy->values);
+	numbers_free(&lazy->numbers);
+	free(lazy->entries);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+lazy_init(struct lazy *lazy)
+{
+	lazy->words       = cbook_create();
+	lazy->values      = cbook_create();
+	lazy->entries     = NULL;
+	lazy->entries_n   = 0;
+	lazy->entries_cap = 0;
+	lazy->pending     = 0;
+	lazy->enabled     = false;
+	lazy->err         = false;
+
+	numbers_init(&lazy->numbers);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+lazy_push(struct lazy *lazy, size_t group, size_t previous, size_t depth)
+{
+	struct lazy_entry *tmp;
+
+	if (!(tmp = util_reserve(lazy->entries, &lazy->entries_cap, group + 1, sizeof(struct lazy_entry))))
+	{
+		lazy->err = true;
+		return;
+	}
+
+	lazy->entries = tmp;
+
+	/* groups of the resources that were evaluated in between are left without words */
+
+	for (; lazy->entries_n < group; lazy->entries_n++)
+	{
+		lazy->entries[lazy->entries_n].words = SIZE_MAX;
+	}
+
+	lazy->entries[group].words    = cbook_groups_number(lazy->words) - 1;
+	lazy->entries[group].values   = LAZY_PENDING;
+	lazy->entries[group].previous = previous;
+	lazy->entries[group].depth    = depth;
+
+	lazy->entries_n = group + 1;
+	lazy->pending++;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+lazy_settle(struct lazy *lazy, cbook **sequences, struct numbers *numbers, cdict *keys_sequences,
+            const cbook *names)
+{
+	const struct lazy_entry *entry;
+	struct numbers numbers_new;
+	cbook *sequences_new;
+
+	if (lazy->entries_n == 0)
+	{
+		return;
+	}
+
+	sequences_new = cbook_create();
+	numbers_init(&numbers_new);
+
+	/* every group is written again in place, so that the indexes handed out so far stay valid */
+
+	for (size_t g = 0; g < cbook_groups_number(*sequences); g++)
+	{
+		cbook_prepare_new_group(sequences_new);
+		if (!(entry = lazy_entry(lazy, g)))
+		{
+			copy_group(sequences_new, &numbers_new, *sequences, numbers, g);
+		}
+		else if (entry->values != LAZY_EMPTY)
+		{
+			copy_group(sequences_new, &numbers_new, lazy->values, &lazy->numbers, entry->values);
+		}
+		else
+		{
+			cbook_write(sequences_new, "");
+			numbers_push(&numbers_new, NAN);
+			rebind(lazy, keys_sequences, names, g);
+		}
+	}
+
+	if (cbook_error(sequences_new) || cdict_error(keys_sequences) || numbers_new.err)
+	{
+		cbook_destroy(sequences_new);
+		numbers_free(&numbers_new);
+		lazy->err = true;
+		return;
+	}
+
+	cbook_destroy(*sequences);
+	numbers_free(numbers);
+
+	*sequences = sequences_new;
+	*numbers   = numbers_new;
+
+	lazy_clear(lazy);
+}
+
+/************************************************************************************************************/
+/* STATIC ***************************************************************************************************/
+/************************************************************************************************************/
+
+static void
+copy_group(cbook *book, struct numbers *numbers, const cbook *src, const struct numbers *src_numbers,
+           size_t group)
+{
+	for (size_t i = 0; i < cbook_group_length(src, group); i++)
+	{
+		cbook_write(book, cbook_word_in_group(src, group, i));
+		numbers_push(numbers, numbers_get(src_numbers, cbook_word_index(src, group, i)));
+	}
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+rebind(const struct lazy *lazy, cdict *keys_sequences, const cbook *names, size_t group)
+{
+	const struct lazy_entry *entry;
+	const char *name;
+	size_t i;
+	size_t j;
+
+	name = cbook_word_in_group(names, group, 1);
+
+	/* only the latest definition of a resource is bound */
+
+	if (!cdict_find(keys_sequences, cbook_word_in_group(names, group, 0), 0, &i)
+	 || !cdict_find(keys_sequences, name, i, &j)
+	 || j != group)
+	{
+		return;
+	}
+
+	/* go back to the last definition that had values, as if the empty ones never got declared */
+
+	for (j = lazy->entries[group].previous;
+	     (entry = lazy_entry(lazy, j)) && entry->values == LAZY_EMPTY;
+	     j = entry->previous);
+
+	if (j == SIZE_MAX)
+	{
+		cdict_erase(keys_sequences, name, i);
+	}
+	else
+	{
+		cdict_write(keys_sequences, name, i, j);
+	}
+}
@@ -0,0 +1,135 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#pragma once
+
+#include <cassette/ccfg.h>
+#include <cassette/cobj.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "numbers.h"
+
+/************************************************************************************************************/
+/* TYPES ****************************************************************************************************/
+/************************************************************************************************************/
+
+#define LAZY_PENDING SIZE_MAX
+#define LAZY_EMPTY   (SIZE_MAX - 1)
+
+/**
+ * Resource whose values were written down as raw words, as group of the word book, instead of being
+ * evaluated. Values are set to the group the evaluated values got written to once the resource is first
+ * fetched, or to LAZY_EMPTY if there were none, in which case the resource falls back to its previous
+ * definition, if any. The depth is the one the values would have been evaluated at during the load.
+ */
+struct lazy_entry
+{
+	size_t words;
+	size_t values;
+	size_t previous;
+	size_t depth;
+};
+
+/**
+ * Deferred resources of the last load. Entries are indexed like the groups of the sequence book, in which
+ * deferred resources only hold a placeholder word. Groups of resources that got evaluated during the load
+ * have an entry without words, if any. Evaluated values are kept in a book of their own, along with their
+ * numerical form.
+ */
+struct lazy
+{
+	cbook *words;
+	cbook *values;
+	struct numbers numbers;
+	struct lazy_entry *entries;
+	size_t entries_n;
+	size_t entries_cap;
+	size_t pending;
+	bool enabled;
+	bool err;
+};
+
+/************************************************************************************************************/
+/* CONSTRUCTORS / DESTRUCTORS *******************************************************************************/
+/************************************************************************************************************/
+
+void
+lazy_init(struct lazy *lazy)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+lazy_free(struct lazy *lazy)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/************************************************************************************************************/
+/* PROCEDURES ***********************************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * Drops every deferred resource and evaluated value. Whether lazy evaluation is enabled is kept.
+ */
+void
+lazy_clear(struct lazy *lazy)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Defers the resource of the given sequence group, with the last group of the word book as raw values.
+ * Previous is the group of the definition it replaces, or SIZE_MAX if there is none.
+ */
+void
+lazy_push(struct lazy *lazy, size_t group, size_t previous, size_t depth)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Writes the evaluated values of every deferred resource into their group of the sequence book, which gets
+ * rebuilt, and rebinds the resources that ended up without values to their previous definition. All the
+ * resources must have been evaluated beforehand. Once done, the lazy data gets cleared, and sequence groups
+ * keep the same indexes.
+ */
+void
+lazy_settle(struct lazy *lazy, cbook **sequences, struct numbers *numbers, cdict *keys_sequences,
+            const cbook *names)
+CCFG_NONNULL(1, 2, 3, 4, 5)
+CCFG_HIDDEN;
+
+/************************************************************************************************************/
+/* FUNCTIONS ************************************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * Gets the entry of a sequence group if its resource was deferred, NULL otherwise.
+ */
+struct lazy_entry *
+lazy_entry(const struct lazy *lazy, size_t group)
+CCFG_NONNULL(1)
+CCFG_HIDDEN
+CCFG_PURE;
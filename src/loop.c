@@ -0,0 +1,174 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#include <cassette/ccfg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "loop.h"
+#include "token.h"
+#include "util.h"
+
+/************************************************************************************************************/
+/* PRIVATE **************************************************************************************************/
+/************************************************************************************************************/
+
+size_t
+loop_block_end(const struct loop *loop, size_t group)
+{
+	return group < loop->ends_n ? loop->ends[group] : SIZE_MAX;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+loop_clear(struct loop *loop)
+{
+	loop->types_n = 0;
+	loop->ends_n  = 0;
+	loop->open    = SIZE_MAX;
+	loop->err     = false;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+loop_free(struct loop *loop)
+{
+	free(loop->types);
+	free(loop->ends);
+	free(loop->lines);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+loop_init(struct loop *loop)
+{
+	loop->types     = NULL;
+	loop->ends      = NULL;
+	loop->lines     = NULL;
+	loop->types_n   = 0;
+	loop->types_cap = 0;
+	loop->ends_n    = 0;
+	loop->ends_cap  = 0;
+	loop->lines_cap = 0;
+	loop->open      = SIZE_MAX;
+	loop->err       = false;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+size_t
+loop_line(const struct loop *loop, size_t group)
+{
+	return group < loop->ends_n ? loop->lines[group] : 0;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+loop_push_group(struct loop *loop, enum token lead, size_t line)
+{
+	size_t *tmp;
+	size_t group = loop->ends_n;
+	size_t next;
+
+	if (!(tmp = util_reserve(loop->lines, &loop->lines_cap, loop->ends_n + 1, sizeof(size_t))))
+	{
+		loop->err = true;
+		return;
+	}
+
+	loop->lines = tmp;
+	loop->lines[group] = line;
+
+	if (!(tmp = util_reserve(loop->ends, &loop->ends_cap, loop->ends_n + 1, sizeof(size_t))))
+	{
+		loop->err = true;
+		return;
+	}
+
+	loop->ends = tmp;
+	loop->ends[loop->ends_n++] = SIZE_MAX;
+
+	/* blocks still open are chained through their end slot, the innermost one being the chain's head */
+
+	switch (lead)
+	{
+		case TOKEN_FOR_BEGIN:
+			loop->ends[group] = loop->open;
+			loop->open = group;
+			break;
+
+		case TOKEN_FOR_END:
+			if (loop->open != SIZE_MAX)
+			{
+				next = loop->ends[loop->open];
+				loop->ends[loop->open] = group;
+				loop->open = next;
+			}
+			break;
+
+		default:
+			break;
+	}
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+loop_push_word(struct loop *loop, enum token type)
+{
+	enum token *tmp;
+
+	if (!(tmp = util_reserve(loop->types, &loop->types_cap, loop->types_n + 1, sizeof(enum token))))
+	{
+		loop->err = true;
+		return;
+	}
+
+	loop->types = tmp;
+	loop->types[loop->types_n++] = type;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+loop_seal(struct loop *loop)
+{
+	size_t next;
+
+	while (loop->open != SIZE_MAX)
+	{
+		next = loop->ends[loop->open];
+		loop->ends[loop->open] = SIZE_MAX;
+		loop->open = next;
+	}
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+enum token
+loop_type(const struct loop *loop, size_t word)
+{
+	return word < loop->types_n ? loop->types[word] : TOKEN_STRING;
+}
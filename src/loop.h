@@ -0,0 +1,137 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#pragma once
+
+#include <cassette/ccfg.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "token.h"
+
+/************************************************************************************************************/
+/* TYPES ****************************************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * Compiled form of the FOR_EACH block written into the iteration book, built once before the block is first
+ * run. Words get their token type, indexed like the words of the book, and every sequence led by FOR_EACH
+ * gets the group of the FOR_END that closes its nested block, indexed like the groups of the book. Groups
+ * also keep the source line they were read from, for the profiler.
+ */
+struct loop
+{
+	enum token *types;
+	size_t *ends;
+	size_t *lines;
+	size_t types_n;
+	size_t types_cap;
+	size_t ends_n;
+	size_t ends_cap;
+	size_t lines_cap;
+	size_t open;
+	bool err;
+};
+
+/************************************************************************************************************/
+/* CONSTRUCTORS / DESTRUCTORS *******************************************************************************/
+/************************************************************************************************************/
+
+void
+loop_init(struct loop *loop)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+loop_free(struct loop *loop)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/************************************************************************************************************/
+/* PROCEDURES ***********************************************************************************************/
+/************************************************************************************************************/
+
+void
+loop_clear(struct loop *loop)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Goes along a new group of the iteration book, with the type of its first word given as lead, and the
+ * source line it was read from, or 0 if it is not known.
+ */
+void
+loop_push_group(struct loop *loop, enum token lead, size_t line)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+loop_push_word(struct loop *loop, enum token type)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Marks the nested blocks that are still open once the last group was pushed as never closed.
+ */
+void
+loop_seal(struct loop *loop)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/************************************************************************************************************/
+/* FUNCTIONS ************************************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * Returns the group of the FOR_END closing the nested block started by the given group, or SIZE_MAX if the
+ * block is never closed.
+ */
+size_t
+loop_block_end(const struct loop *loop, size_t group)
+CCFG_NONNULL(1)
+CCFG_HIDDEN
+CCFG_PURE;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Returns the source line the given group was read from, or 0 if it is not known.
+ */
+size_t
+loop_line(const struct loop *loop, size_t group)
+CCFG_NONNULL(1)
+CCFG_HIDDEN
+CCFG_PURE;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+enum token
+loop_type(const struct loop *loop, size_t word)
+CCFG_NONNULL(1)
+CCFG_HIDDEN
+CCFG_PURE;
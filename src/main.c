@@ -20,13 +20,34 @@
 
 #include <cassette/ccfg.h>
 #include <cassette/cobj.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include "cache.h"
+#include "channel.h"
+#include "freeze.h"
+#include "lazy.h"
+#include "loop.h"
 #include "main.h"
+#include "memo.h"
+#include "numbers.h"
+#include "pool.h"
+#include "profile.h"
+#include "share.h"
 #include "source.h"
+#include "stats.h"
+#include "stream.h"
+#include "taint.h"
 #include "token.h"
+#include "trace.h"
+#include "util.h"
+#include "watch.h"
 
 /************************************************************************************************************/
 /************************************************************************************************************/
@@ -38,8 +59,36 @@
 /************************************************************************************************************/
 /************************************************************************************************************/
 
-static const char * select_source (const ccfg *, size_t *) CCFG_NONNULL_RETURN CCFG_NONNULL(1);
-static enum cerr    update_err    (ccfg *)                                     CCFG_NONNULL(1);
+static void         adopt_resources(ccfg *, ccfg *)                                  CCFG_NONNULL(1, 2);
+static void         adopt_sources  (ccfg *, ccfg *)                                  CCFG_NONNULL(1, 2);
+static void         bind_handles   (ccfg *)                                          CCFG_NONNULL(1);
+static bool         convert        (const ccfg *, size_t, const struct ccfg_field *) CCFG_NONNULL(1, 3);
+static void         drop_filters   (ccfg *)                                          CCFG_NONNULL(1);
+static void         drop_params    (ccfg *)                                          CCFG_NONNULL(1);
+static void         drop_resources (ccfg *)                                          CCFG_NONNULL(1);
+static void         drop_sources   (ccfg *)                                          CCFG_NONNULL(1);
+static size_t       evaluate       (ccfg *, size_t)                                  CCFG_NONNULL(1);
+static size_t       find_group     (const ccfg *, const char *, const char *)        CCFG_NONNULL(1, 2, 3);
+static bool         fits_color     (double)                                          CCFG_PURE;
+static bool         fits_long      (double)                                          CCFG_PURE;
+static uint64_t     hash_values    (const ccfg *, size_t)                            CCFG_NONNULL(1);
+static size_t       length         (const ccfg *, size_t)                            CCFG_NONNULL(1);
+static uint64_t     load_hash      (const ccfg *)                                    CCFG_NONNULL(1);
+static void         mount_frozen   (ccfg *, struct freeze *)                         CCFG_NONNULL(1, 2);
+static double       number         (const ccfg *, size_t, size_t)                    CCFG_NONNULL(1);
+static void         own_filters    (ccfg *, bool)                                    CCFG_NONNULL(1);
+static void         own_params     (ccfg *, bool)                                    CCFG_NONNULL(1);
+static void         own_resources  (ccfg *, bool)                                    CCFG_NONNULL(1);
+static void         own_sources    (ccfg *, bool)                                    CCFG_NONNULL(1);
+static void *       run_load       (void *)                                          CCFG_NONNULL(1);
+static void         run_tenant     (void *, size_t)                                  CCFG_NONNULL(1);
+static const char * select_source  (const ccfg *, size_t *)                          CCFG_NONNULL_RETURN CCFG_NONNULL(1);
+static void         settle         (ccfg *)                                          CCFG_NONNULL(1);
+static bool         share_all      (ccfg *)                                          CCFG_NONNULL(1);
+static void         thaw           (ccfg *)                                          CCFG_NONNULL(1);
+static void         track_changes  (ccfg *)                                          CCFG_NONNULL(1);
+static enum cerr    update_err     (ccfg *)                                          CCFG_NONNULL(1);
+static const char * value          (const ccfg *, size_t, size_t)                    CCFG_NONNULL_RETURN CCFG_NONNULL(1);
 
 /************************************************************************************************************/
 /************************************************************************************************************/
@@ -47,15 +96,41 @@ static enum cerr    update_err    (ccfg *)                                     C
 
 ccfg ccfg_placeholder_instance =
 {
+	.filters        = CBOOK_PLACEHOLDER,
 	.params         = CBOOK_PLACEHOLDER,
 	.sequences      = CBOOK_PLACEHOLDER,
+	.names          = CBOOK_PLACEHOLDER,
 	.sources        = CBOOK_PLACEHOLDER,
+	.handles        = CBOOK_PLACEHOLDER,
+	.vars           = CBOOK_PLACEHOLDER,
+	.iteration      = CBOOK_PLACEHOLDER,
+	.keys_filters   = CDICT_PLACEHOLDER,
 	.keys_params    = CDICT_PLACEHOLDER,
 	.keys_sequences = CDICT_PLACEHOLDER,
-	.tokens         = CDICT_PLACEHOLDER,
+	.keys_vars      = CDICT_PLACEHOLDER,
+	.scratch        = CSTR_PLACEHOLDER,
+	.frozen         = NULL,
+	.frozen_mapped  = false,
+	.feed           = NULL,
+	.handles_groups = NULL,
+	.handles_cap    = 0,
+	.streams        = NULL,
+	.trace          = {.paths = CBOOK_PLACEHOLDER},
+	.profile        = {.files = CBOOK_PLACEHOLDER, .keys_files = CDICT_PLACEHOLDER,
+	                   .keys_nodes = CDICT_PLACEHOLDER},
+	.taint          = {.lines = CBOOK_PLACEHOLDER, .params = CBOOK_PLACEHOLDER, .vars = CBOOK_PLACEHOLDER,
+	                   .values = CBOOK_PLACEHOLDER, .keys_params = CDICT_PLACEHOLDER,
+	                   .keys_vars = CDICT_PLACEHOLDER},
+	.lazy           = {.words = CBOOK_PLACEHOLDER, .values = CBOOK_PLACEHOLDER},
+	.diff           = {.states = {{.names = CBOOK_PLACEHOLDER, .keys = CDICT_PLACEHOLDER},
+	                              {.names = CBOOK_PLACEHOLDER, .keys = CDICT_PLACEHOLDER}},
+	                   .changes = CBOOK_PLACEHOLDER, .namespaces = CBOOK_PLACEHOLDER},
+	.filters_hash   = UTIL_HASH_INIT,
+	.params_hash    = UTIL_HASH_INIT,
 	.it_group       = SIZE_MAX,
 	.it             = SIZE_MAX,
 	.restricted     = false,
+	.internal       = false,
 	.err            = CERR_INVALID,
 };
 
@@ -84,8 +159,52 @@ ccfg_clear_resources(ccfg *cfg)
 		return;
 	}
 
+	own_resources(cfg, false);
 	cbook_clear(cfg->sequences);
+	cbook_clear(cfg->names);
 	cdict_clear(cfg->keys_sequences);
+	numbers_clear(&cfg->numbers);
+	lazy_clear(&cfg->lazy);
+	taint_clear(&cfg->taint);
+	thaw(cfg);
+	trace_clear(&cfg->trace);
+	bind_handles(cfg);
+	track_changes(cfg);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+ccfg_clear_change_callbacks(ccfg *cfg)
+{
+	if (cfg->err)
+	{
+		return;
+	}
+
+	diff_clear_callbacks(&cfg->diff);
+
+	if (!diff_is_tracking(&cfg->diff))
+	{
+		diff_reset(&cfg->diff);
+	}
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+ccfg_clear_namespace_filters(ccfg *cfg)
+{
+	if (cfg->err)
+	{
+		return;
+	}
+
+	own_filters(cfg, false);
+	cbook_clear(cfg->filters);
+	cdict_clear(cfg->keys_filters);
+
+	cfg->filters_hash = UTIL_HASH_INIT;
 }
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
@@ -98,8 +217,11 @@ ccfg_clear_params(ccfg *cfg)
 		return;
 	}
 
+	own_params(cfg, false);
 	cbook_clear(cfg->params);
 	cdict_clear(cfg->keys_params);
+
+	cfg->params_hash = UTIL_HASH_INIT;
 }
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
@@ -112,6 +234,7 @@ ccfg_clear_sources(ccfg *cfg)
 		return;
 	}
 
+	own_sources(cfg, false);
 	cbook_clear(cfg->sources);
 }
 
@@ -122,23 +245,88 @@ ccfg_clone(ccfg *cfg)
 {
 	ccfg *cfg_new;
 
-	if (!(cfg_new = malloc(sizeof(ccfg))))
+	if (cfg->err)
+	{
+		return CCFG_PLACEHOLDER;
+	}
+
+	/* deferred resources are evaluated first, so that the clone does not depend on the lazy data */
+
+	settle(cfg);
+
+	if (cfg->lazy.entries_n > 0 || !share_all(cfg) || !(cfg_new = malloc(sizeof(ccfg))))
 	{
 		return CCFG_PLACEHOLDER;
 	}
 
-	cfg_new->params         = cbook_clone(cfg->params);
-	cfg_new->sequences      = cbook_clone(cfg->sequences);
-	cfg_new->sources        = cbook_clone(cfg->sources);
-	cfg_new->keys_params    = cdict_clone(cfg->keys_params);
-	cfg_new->keys_sequences = cdict_clone(cfg->keys_sequences);
-	cfg_new->tokens         = cdict_clone(cfg->tokens);
+	/* resources, params, sources and filters are shared until either config modifies them */
+
+	cfg_new->filters        = cfg->filters;
+	cfg_new->params         = cfg->params;
+	cfg_new->sequences      = cfg->sequences;
+	cfg_new->names          = cfg->names;
+	cfg_new->sources        = cfg->sources;
+	cfg_new->handles        = cbook_clone(cfg->handles);
+	cfg_new->vars           = cbook_create();
+	cfg_new->iteration      = cbook_create();
+	cfg_new->keys_filters   = cfg->keys_filters;
+	cfg_new->keys_params    = cfg->keys_params;
+	cfg_new->keys_sequences = cfg->keys_sequences;
+	cfg_new->keys_vars      = cdict_create();
+	cfg_new->scratch        = cstr_create();
+	cfg_new->frozen         = cfg->frozen;
+	cfg_new->frozen_mapped  = cfg->frozen_mapped;
+	cfg_new->feed           = NULL;
+	cfg_new->numbers        = cfg->numbers;
+	cfg_new->handles_groups = NULL;
+	cfg_new->handles_cap    = 0;
+	cfg_new->streams        = NULL;
+	cfg_new->filters_hash   = cfg->filters_hash;
+	cfg_new->params_hash    = cfg->params_hash;
 	cfg_new->it_group       = cfg->it_group;
 	cfg_new->it             = cfg->it;
 	cfg_new->restricted     = cfg->restricted;
+	cfg_new->internal       = cfg->internal;
 	cfg_new->err            = CERR_NONE;
 
-	if (update_err(cfg_new))
+	cfg_new->filters_share   = share_acquire(cfg->filters_share);
+	cfg_new->params_share    = share_acquire(cfg->params_share);
+	cfg_new->resources_share = share_acquire(cfg->resources_share);
+	cfg_new->sources_share   = share_acquire(cfg->sources_share);
+
+	trace_init(&cfg_new->trace);
+	stats_init(&cfg_new->stats);
+	watch_init(&cfg_new->watch);
+	channel_init(&cfg_new->channel);
+	cache_init(&cfg_new->cache);
+	loop_init(&cfg_new->loop);
+	memo_init(&cfg_new->memo);
+	pool_init(&cfg_new->pool);
+	pool_resize(&cfg_new->pool, cfg->pool.threads_max);
+	lazy_init(&cfg_new->lazy);
+	profile_init(&cfg_new->profile);
+	taint_init(&cfg_new->taint);
+	diff_init(&cfg_new->diff);
+
+	if (cfg->handles_cap && (cfg_new->handles_groups = malloc(cfg->handles_cap * sizeof(size_t))))
+	{
+		memcpy(cfg_new->handles_groups, cfg->handles_groups, cfg->handles_cap * sizeof(size_t));
+		cfg_new->handles_cap = cfg->handles_cap;
+	}
+
+	cfg_new->lazy.enabled    = cfg->lazy.enabled;
+	cfg_new->profile.enabled = cfg->profile.enabled;
+	cfg_new->taint.enabled   = cfg->taint.enabled;
+	cfg_new->diff.enabled    = cfg->diff.enabled;
+
+	/* the clone's next load gets compared to the resources it starts with */
+
+	if (cfg->diff.enabled)
+	{
+		diff_copy(&cfg_new->diff, &cfg->diff);
+	}
+
+	if (update_err(cfg_new) || (cfg->handles_cap && !cfg_new->handles_groups))
 	{
 		ccfg_destroy(cfg_new);
 		return CCFG_PLACEHOLDER;
@@ -159,17 +347,52 @@ ccfg_create(void)
 		return CCFG_PLACEHOLDER;
 	}
 
+	cfg->filters        = cbook_create();
 	cfg->params         = cbook_create();
 	cfg->sequences      = cbook_create();
+	cfg->names          = cbook_create();
 	cfg->sources        = cbook_create();
+	cfg->handles        = cbook_create();
+	cfg->vars           = cbook_create();
+	cfg->iteration      = cbook_create();
+	cfg->keys_filters   = cdict_create();
 	cfg->keys_params    = cdict_create();
 	cfg->keys_sequences = cdict_create();
-	cfg->tokens         = token_dict_create();
+	cfg->keys_vars      = cdict_create();
+	cfg->scratch        = cstr_create();
+	cfg->frozen         = NULL;
+	cfg->frozen_mapped  = false;
+	cfg->feed           = NULL;
+	cfg->handles_groups = NULL;
+	cfg->handles_cap    = 0;
+	cfg->streams        = NULL;
+	cfg->filters_hash   = UTIL_HASH_INIT;
+	cfg->params_hash    = UTIL_HASH_INIT;
 	cfg->it_group       = SIZE_MAX;
 	cfg->it             = SIZE_MAX;
 	cfg->restricted     = false;
+	cfg->internal       = false;
 	cfg->err            = CERR_NONE;
 
+	cfg->filters_share   = NULL;
+	cfg->params_share    = NULL;
+	cfg->resources_share = NULL;
+	cfg->sources_share   = NULL;
+
+	trace_init(&cfg->trace);
+	stats_init(&cfg->stats);
+	watch_init(&cfg->watch);
+	channel_init(&cfg->channel);
+	cache_init(&cfg->cache);
+	loop_init(&cfg->loop);
+	memo_init(&cfg->memo);
+	pool_init(&cfg->pool);
+	lazy_init(&cfg->lazy);
+	profile_init(&cfg->profile);
+	taint_init(&cfg->taint);
+	diff_init(&cfg->diff);
+	numbers_init(&cfg->numbers);
+
 	if (update_err(cfg))
 	{
 		ccfg_destroy(cfg);
@@ -189,12 +412,35 @@ ccfg_destroy(ccfg *cfg)
 		return;
 	}
 
-	cbook_destroy(cfg->params);
-	cbook_destroy(cfg->sequences);
-	cbook_destroy(cfg->sources);
-	cdict_destroy(cfg->keys_params);
-	cdict_destroy(cfg->keys_sequences);
-	cdict_destroy(cfg->tokens);
+	drop_filters(cfg);
+	drop_params(cfg);
+	drop_resources(cfg);
+	drop_sources(cfg);
+
+	if (cfg->feed)
+	{
+		feed_destroy(cfg->feed);
+	}
+
+	cbook_destroy(cfg->handles);
+	cbook_destroy(cfg->vars);
+	cbook_destroy(cfg->iteration);
+	cdict_destroy(cfg->keys_vars);
+	cstr_destroy(cfg->scratch);
+	stream_destroy_all(&cfg->streams);
+	free(cfg->handles_groups);
+	trace_free(&cfg->trace);
+	stats_free(&cfg->stats);
+	watch_free(&cfg->watch);
+	channel_free(&cfg->channel);
+	cache_free(&cfg->cache);
+	loop_free(&cfg->loop);
+	memo_free(&cfg->memo);
+	pool_free(&cfg->pool);
+	lazy_free(&cfg->lazy);
+	profile_free(&cfg->profile);
+	taint_free(&cfg->taint);
+	diff_free(&cfg->diff);
 
 	free(cfg);
 }
@@ -212,21 +458,133 @@ ccfg_error(const ccfg *cfg)
 void
 ccfg_fetch(ccfg *cfg, const char *namespace, const char *property)
 {
-	size_t i;
+	if (cfg->err)
+	{
+		return;
+	}
+
+	cfg->it_group = evaluate(cfg, find_group(cfg, namespace, property));
+	cfg->it       = cfg->it_group != SIZE_MAX ? 0 : SIZE_MAX;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+size_t
+ccfg_fetch_fields(ccfg *cfg, const struct ccfg_field *fields, size_t n)
+{
+	size_t group;
+	size_t k = 0;
+
+	if (cfg->err)
+	{
+		return 0;
+	}
 
+	for (size_t i = 0; i < n; i++)
+	{
+		if ((group = evaluate(cfg, find_group(cfg, fields[i].namespace, fields[i].property))) != SIZE_MAX
+		 && convert(cfg, group, fields + i))
+		{
+			k++;
+		}
+	}
+
+	return k;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+ccfg_fetch_handle(ccfg *cfg, ccfg_handle handle)
+{
 	if (cfg->err)
 	{
 		return;
 	}
 
-	cfg->it_group = SIZE_MAX;
-	cfg->it       = SIZE_MAX;
+	cfg->it_group = handle < cbook_groups_number(cfg->handles) ? cfg->handles_groups[handle] : SIZE_MAX;
+	cfg->it_group = evaluate(cfg, cfg->it_group);
+	cfg->it       = cfg->it_group != SIZE_MAX ? 0 : SIZE_MAX;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 
-	if (cdict_find(cfg->keys_sequences, namespace, 0, &i)
-	 && cdict_find(cfg->keys_sequences, property,  i, &cfg->it_group))
+void
+ccfg_freeze(ccfg *cfg)
+{
+	enum cerr err = CERR_NONE;
+
+	/* a mapped table has no sequences behind it to be frozen from again */
+
+	if (cfg->err || cfg->frozen_mapped)
+	{
+		return;
+	}
+
+	own_resources(cfg, true);
+	thaw(cfg);
+	settle(cfg);
+
+	if (cfg->err)
+	{
+		return;
+	}
+
+	if (!(cfg->frozen = freeze_create(cfg->sequences, cfg->names, cfg->keys_sequences, &cfg->numbers, &err)))
+	{
+		SET_ERR(err)
+	}
+
+	bind_handles(cfg);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+bool
+ccfg_get_change(const ccfg *cfg, size_t i, struct ccfg_change *change)
+{
+	if (cfg->err || i >= cbook_groups_number(cfg->diff.changes))
+	{
+		return false;
+	}
+
+	change->namespace = cbook_word_in_group(cfg->diff.changes, i, 0);
+	change->property  = cbook_word_in_group(cfg->diff.changes, i, 1);
+	change->type      = cfg->diff.types[i];
+
+	return true;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+bool
+ccfg_get_file_stats(const ccfg *cfg, size_t i, struct ccfg_file_stats *file)
+{
+	if (cfg->err || !STATS_ENABLED || i >= cfg->stats.files_n || cfg->stats.err)
+	{
+		return false;
+	}
+
+	file->path  = cbook_word(cfg->stats.paths, i);
+	file->bytes = cfg->stats.files[i].bytes;
+	file->lines = cfg->stats.files[i].lines;
+
+	return true;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+bool
+ccfg_get_stats(const ccfg *cfg, struct ccfg_stats *stats)
+{
+	if (cfg->err || !STATS_ENABLED)
 	{
-		cfg->it = 0;
+		return false;
 	}
+
+	*stats = cfg->stats.counters;
+
+	return true;
 }
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
@@ -234,7 +592,7 @@ ccfg_fetch(ccfg *cfg, const char *namespace, const char *property)
 bool
 ccfg_iterate(ccfg *cfg)
 {
-	if (cfg->err || cfg->it >= cbook_group_length(cfg->sequences, cfg->it_group))
+	if (cfg->err || cfg->it >= ccfg_resource_length(cfg))
 	{
 		return false;
 	}
@@ -251,160 +609,796 @@ ccfg_load(ccfg *cfg)
 {
 	const char *source;
 
-	if (cfg->err || (source = select_source(cfg, NULL))[0] == '\0')
+	if (cfg->err)
+	{
+		return;
+	}
+
+	STATS_START(&cfg->stats);
+	profile_clear(&cfg->profile);
+
+	if ((source = select_source(cfg, NULL))[0] == '\0')
 	{
 		return;
 	}
 
+	STATS_LAP(&cfg->stats, time_select);
+
+	cfg->internal = false;
+
+	own_resources(cfg, false);
 	cbook_clear(cfg->sequences);
+	cbook_clear(cfg->names);
 	cdict_clear(cfg->keys_sequences);
+	numbers_clear(&cfg->numbers);
+	lazy_clear(&cfg->lazy);
+	taint_clear(&cfg->taint);
+	thaw(cfg);
+	trace_clear(&cfg->trace);
+	STATS_LAP(&cfg->stats, time_clear);
+
+	cache_start(&cfg->cache, load_hash(cfg));
 	source_parse_root(cfg, source, false);
+	STATS_LAP(&cfg->stats, time_parse);
 
-	update_err(cfg);
+	stream_clean(&cfg->streams);
+
+	if (!update_err(cfg))
+	{
+		trace_validate(&cfg->trace, load_hash(cfg));
+	}
+
+	cfg->taint.valid = cfg->taint.enabled && !cfg->err;
+
+	cache_stop(&cfg->cache, !cfg->err);
+	watch_arm(&cfg->watch, &cfg->trace, cfg->sources);
+	bind_handles(cfg);
+	track_changes(cfg);
+	STATS_LAP(&cfg->stats, time_finish);
 }
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 
-void
-ccfg_load_internal(ccfg *cfg, const char *buffer)
+bool
+ccfg_load_async(ccfg *cfg, ccfg_load_callback callback, void *data)
 {
-	if (cfg->err)
+	struct load_job *job;
+	pthread_t thread;
+
+	if (cfg->err || !(job = malloc(sizeof(struct load_job))))
 	{
-		return;
+		return false;
 	}
 
-	cbook_clear(cfg->sequences);
-	cdict_clear(cfg->keys_sequences);
-	source_parse_root(cfg, buffer, true);
+	/* clones share the config's components, so this does not copy anything the load will replace */
 
-	update_err(cfg);
+	job->cfg      = ccfg_clone(cfg);
+	job->callback = callback;
+	job->data     = data;
+
+	if (job->cfg == CCFG_PLACEHOLDER || pthread_create(&thread, NULL, run_load, job) != 0)
+	{
+		ccfg_destroy(job->cfg);
+		free(job);
+		return false;
+	}
+
+	pthread_detach(thread);
+
+	return true;
 }
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 
-void
-ccfg_push_param_double(ccfg *cfg, const char *name, double d)
+bool
+ccfg_load_frozen(ccfg *cfg, const char *filename)
 {
-	char tmp[64];
+	struct freeze *frozen;
 
-	snprintf(tmp, 64, "%f", d);
+	if (cfg->err || !(frozen = freeze_map(filename)))
+	{
+		return false;
+	}
 
-	ccfg_push_param_str(cfg, name, tmp);
+	mount_frozen(cfg, frozen);
+
+	return true;
 }
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 
-void
-ccfg_push_param_long(ccfg *cfg, const char *name, long long l)
+bool
+ccfg_load_if_changed(ccfg *cfg)
 {
-	char tmp[64];
+	const char *source;
 
-	snprintf(tmp, 64, "%lli", l);
+	if (cfg->err
+	 || (source = select_source(cfg, NULL))[0] == '\0'
+	 || !trace_changed(&cfg->trace, source, load_hash(cfg)))
+	{
+		return false;
+	}
 
-	ccfg_push_param_str(cfg, name, tmp);
+	ccfg_load(cfg);
+
+	return true;
 }
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 
-void
-ccfg_push_param_str(ccfg *cfg, const char *name, const char *str)
+bool
+ccfg_load_if_notified(ccfg *cfg)
 {
-	if (cfg->err)
+	if (cfg->err || !watch_drain(&cfg->watch))
 	{
-		return;
+		return false;
 	}
 
-	cbook_write(cfg->params, str);
-	if (!cbook_error(cfg->params))
-	{
-		cdict_write(cfg->keys_params, name, 0, cbook_words_number(cfg->params) - 1);
-	}
+	/* notifications only hint at a change, the files are still compared against the trace */
 
-	update_err(cfg);
+	return ccfg_load_if_changed(cfg);
 }
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 
 void
-ccfg_push_source(ccfg *cfg, const char *filename)
+ccfg_load_internal(ccfg *cfg, const char *buffer)
 {
 	if (cfg->err)
 	{
 		return;
 	}
 
-	cbook_write(cfg->sources, filename);
+	STATS_START(&cfg->stats);
+	profile_clear(&cfg->profile);
+
+	own_resources(cfg, false);
+	cbook_clear(cfg->sequences);
+	cbook_clear(cfg->names);
+	cdict_clear(cfg->keys_sequences);
+	numbers_clear(&cfg->numbers);
+	lazy_clear(&cfg->lazy);
+	taint_clear(&cfg->taint);
+	thaw(cfg);
+	trace_clear(&cfg->trace);
+	STATS_LAP(&cfg->stats, time_clear);
+
+	cfg->internal = true;
+
+	source_parse_root(cfg, buffer, true);
+	STATS_LAP(&cfg->stats, time_parse);
+
+	watch_arm(&cfg->watch, &cfg->trace, cfg->sources);
 
 	update_err(cfg);
+	bind_handles(cfg);
+	track_changes(cfg);
+
+	cfg->taint.valid = cfg->taint.enabled && !cfg->err;
+	STATS_LAP(&cfg->stats, time_finish);
 }
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 
-void
-ccfg_repair(ccfg *cfg)
+bool
+ccfg_load_published(ccfg *cfg, const char *name)
 {
-	if (cfg->err == CERR_INVALID)
+	struct freeze *frozen;
+
+	if (cfg->err || !(frozen = channel_poll(&cfg->channel, name)))
 	{
-		return;
+		return false;
 	}
 
-	cbook_repair(cfg->params);
-	cbook_repair(cfg->sequences);
-	cbook_repair(cfg->sources);
-	cdict_repair(cfg->keys_params);
-	cdict_repair(cfg->keys_sequences);
-	cdict_repair(cfg->tokens);
-	
-	cfg->err = CERR_NONE;
+	mount_frozen(cfg, frozen);
 
-	update_err(cfg);
+	return true;
 }
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 
-const char *
-ccfg_resource(const ccfg *cfg)
+void
+ccfg_load_tenants(ccfg *cfg, ccfg *const *tenants, size_t n)
 {
+	struct tenant_job job;
+	bool tracking;
+
 	if (cfg->err)
 	{
-		return "";
+		return;
+	}
+
+	/* dependencies tell each tenant which resources its own params make differ from the shared ones */
+
+	tracking = cfg->taint.enabled;
+	cfg->taint.enabled = true;
+	ccfg_load(cfg);
+	cfg->taint.enabled = tracking;
+
+	/* without a source to read, the resources are still those of a former load from a buffer, which */
+	/* tenants would not be able to load again when their params call for it                          */
+
+	if (cfg->err || cfg->internal)
+	{
+		return;
+	}
+
+	if (!share_all(cfg))
+	{
+		cfg->err = CERR_MEMORY;
+		return;
 	}
 
-	return cbook_word_in_group(cfg->sequences, cfg->it_group, cfg->it - 1);
+	job.cfg     = cfg;
+	job.tenants = tenants;
+
+	pool_run(&cfg->pool, run_tenant, &job, n);
 }
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 
-size_t
-ccfg_resource_length(const ccfg *cfg)
+bool
+ccfg_publish(ccfg *cfg, const char *name)
 {
 	if (cfg->err)
 	{
-		return 0;
+		return false;
+	}
+
+	if (!cfg->frozen)
+	{
+		ccfg_freeze(cfg);
 	}
 
-	return cbook_group_length(cfg->sequences, cfg->it_group);
+	return !cfg->err && channel_publish(&cfg->channel, name, cfg->frozen);
 }
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 
 void
-ccfg_restrict(ccfg *cfg)
+ccfg_push_change_callback(ccfg *cfg, const char *namespace, ccfg_change_callback callback, void *data)
 {
 	if (cfg->err)
 	{
 		return;
 	}
 
-	cfg->restricted = true;
+	diff_push_callback(&cfg->diff, namespace, callback, data);
+
+	update_err(cfg);
 }
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 
 void
-ccfg_unrestrict(ccfg *cfg)
+ccfg_push_namespace_filter(ccfg *cfg, const char *namespace)
 {
-	if (cfg->err)
+	if (cfg->err || cdict_find(cfg->keys_filters, namespace, 0, NULL))
+	{
+		return;
+	}
+
+	own_filters(cfg, true);
+	cbook_write(cfg->filters, namespace);
+	if (!cbook_error(cfg->filters))
+	{
+		cdict_write(cfg->keys_filters, namespace, 0, cbook_words_number(cfg->filters) - 1);
+	}
+
+	cfg->filters_hash = util_hash(cfg->filters_hash, namespace, strlen(namespace) + 1);
+
+	update_err(cfg);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+ccfg_push_param_double(ccfg *cfg, const char *name, double d)
+{
+	char tmp[64];
+
+	snprintf(tmp, 64, "%f", d);
+
+	ccfg_push_param_str(cfg, name, tmp);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+ccfg_push_param_long(ccfg *cfg, const char *name, long long l)
+{
+	char tmp[64];
+
+	snprintf(tmp, 64, "%lli", l);
+
+	ccfg_push_param_str(cfg, name, tmp);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+ccfg_push_param_str(ccfg *cfg, const char *name, const char *str)
+{
+	if (cfg->err)
+	{
+		return;
+	}
+
+	own_params(cfg, true);
+	cbook_write(cfg->params, str);
+	if (!cbook_error(cfg->params))
+	{
+		cdict_write(cfg->keys_params, name, 0, cbook_words_number(cfg->params) - 1);
+	}
+
+	cfg->params_hash = util_hash(cfg->params_hash, name, strlen(name) + 1);
+	cfg->params_hash = util_hash(cfg->params_hash, str,  strlen(str)  + 1);
+
+	update_err(cfg);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+ccfg_push_source(ccfg *cfg, const char *filename)
+{
+	if (cfg->err)
+	{
+		return;
+	}
+
+	own_sources(cfg, true);
+	cbook_write(cfg->sources, filename);
+
+	update_err(cfg);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+ccfg_reevaluate(ccfg *cfg)
+{
+	uint64_t changes;
+	bool frozen;
+
+	if (cfg->err)
+	{
+		return;
+	}
+
+	/* without dependencies to go by, or if params decide which sequences get evaluated, load everything */
+	/* again, unless the resources came from a buffer, in which case there is nothing to read them from  */
+
+	if (!cfg->taint.valid || cfg->taint.structural)
+	{
+		if (!cfg->internal)
+		{
+			ccfg_load(cfg);
+		}
+		return;
+	}
+
+	changes = taint_changes(&cfg->taint, cfg->params, cfg->keys_params);
+
+	if (!update_err(cfg) && changes)
+	{
+		frozen = cfg->frozen;
+		own_resources(cfg, true);
+		thaw(cfg);
+		if (!source_reevaluate(cfg, changes, true) && !cfg->internal)
+		{
+			ccfg_load(cfg);
+			return;
+		}
+		if (frozen)
+		{
+			ccfg_freeze(cfg);
+		}
+	}
+
+	/* the trace now stands for the current params, as if they had been set before the load */
+
+	if (!update_err(cfg) && cfg->trace.valid)
+	{
+		trace_validate(&cfg->trace, load_hash(cfg));
+	}
+
+	bind_handles(cfg);
+	track_changes(cfg);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+ccfg_repair(ccfg *cfg)
+{
+	if (cfg->err == CERR_INVALID)
+	{
+		return;
+	}
+
+	cbook_repair(cfg->filters);
+	cbook_repair(cfg->params);
+	cbook_repair(cfg->sequences);
+	cbook_repair(cfg->names);
+	cbook_repair(cfg->sources);
+	cbook_repair(cfg->handles);
+	cbook_repair(cfg->vars);
+	cbook_repair(cfg->iteration);
+	cdict_repair(cfg->keys_filters);
+	cdict_repair(cfg->keys_params);
+	cdict_repair(cfg->keys_sequences);
+	cdict_repair(cfg->keys_vars);
+	cstr_repair(cfg->scratch);
+	cbook_repair(cfg->lazy.words);
+	cbook_repair(cfg->lazy.values);
+	cbook_repair(cfg->taint.lines);
+	cbook_repair(cfg->taint.params);
+	cbook_repair(cfg->taint.vars);
+	cbook_repair(cfg->taint.values);
+	cdict_repair(cfg->taint.keys_params);
+	cdict_repair(cfg->taint.keys_vars);
+	taint_clear(&cfg->taint);
+
+	/* resources and changes that were being tracked when the error happened cannot be relied upon */
+
+	if (cfg->diff.err)
+	{
+		diff_reset(&cfg->diff);
+	}
+
+	/* a stream cut short by the error cannot be resumed */
+
+	if (cfg->feed)
+	{
+		source_feed_end(cfg, false);
+	}
+	
+	cfg->err = CERR_NONE;
+
+	update_err(cfg);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+ccfg_handle
+ccfg_resolve(ccfg *cfg, const char *namespace, const char *property)
+{
+	size_t *tmp;
+	size_t n;
+
+	if (cfg->err)
+	{
+		return CCFG_HANDLE_INVALID;
+	}
+
+	n = cbook_groups_number(cfg->handles);
+
+	if (!(tmp = util_reserve(cfg->handles_groups, &cfg->handles_cap, n + 1, sizeof(size_t))))
+	{
+		SET_ERR(CERR_MEMORY)
+		return CCFG_HANDLE_INVALID;
+	}
+
+	cfg->handles_groups = tmp;
+
+	cbook_prepare_new_group(cfg->handles);
+	cbook_write(cfg->handles, namespace);
+	cbook_write(cfg->handles, property);
+
+	if (update_err(cfg))
+	{
+		return CCFG_HANDLE_INVALID;
+	}
+
+	cfg->handles_groups[n] = find_group(cfg, namespace, property);
+
+	return n;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+const char *
+ccfg_resource(const ccfg *cfg)
+{
+	if (cfg->err)
+	{
+		return "";
+	}
+
+	return value(cfg, cfg->it_group, cfg->it - 1);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+struct ccolor
+ccfg_resource_color(const ccfg *cfg, bool *err)
+{
+	double d;
+
+	d = number(cfg, cfg->it_group, cfg->it - 1);
+
+	if (err)
+	{
+		*err = !fits_color(d);
+	}
+
+	return ccolor_from_argb_uint(fits_color(d) ? d : 0);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+double
+ccfg_resource_double(const ccfg *cfg, bool *err)
+{
+	double d;
+
+	d = number(cfg, cfg->it_group, cfg->it - 1);
+
+	if (err)
+	{
+		*err = isnan(d);
+	}
+
+	return isnan(d) ? 0.0 : d;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+size_t
+ccfg_resource_length(const ccfg *cfg)
+{
+	if (cfg->err)
+	{
+		return 0;
+	}
+
+	return length(cfg, cfg->it_group);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+long long
+ccfg_resource_long(const ccfg *cfg, bool *err)
+{
+	double d;
+
+	d = number(cfg, cfg->it_group, cfg->it - 1);
+
+	if (err)
+	{
+		*err = !fits_long(d);
+	}
+
+	return fits_long(d) ? d : 0;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+ccfg_restrict(ccfg *cfg)
+{
+	if (cfg->err)
+	{
+		return;
+	}
+
+	cfg->restricted = true;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+bool
+ccfg_save_frozen(ccfg *cfg, const char *filename)
+{
+	if (cfg->err)
+	{
+		return false;
+	}
+
+	if (!cfg->frozen)
+	{
+		ccfg_freeze(cfg);
+	}
+
+	return !cfg->err && freeze_save(cfg->frozen, filename);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+bool
+ccfg_save_profile(ccfg *cfg, const char *filename, enum ccfg_profile_format format)
+{
+	if (cfg->err)
+	{
+		return false;
+	}
+
+	return profile_save(&cfg->profile, filename, format);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+ccfg_set_change_tracking(ccfg *cfg, bool tracking)
+{
+	if (cfg->err)
+	{
+		return;
+	}
+
+	cfg->diff.enabled = tracking;
+
+	if (!diff_is_tracking(&cfg->diff))
+	{
+		diff_reset(&cfg->diff);
+	}
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+ccfg_set_lazy(ccfg *cfg, bool lazy)
+{
+	if (cfg->err)
+	{
+		return;
+	}
+
+	cfg->lazy.enabled = lazy;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+ccfg_set_param_tracking(ccfg *cfg, bool tracking)
+{
+	if (cfg->err)
+	{
+		return;
+	}
+
+	cfg->taint.enabled = tracking;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+ccfg_set_profiling(ccfg *cfg, bool profiling)
+{
+	if (cfg->err)
+	{
+		return;
+	}
+
+	cfg->profile.enabled = profiling;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+ccfg_set_threads(ccfg *cfg, size_t n)
+{
+	if (cfg->err)
+	{
+		return;
+	}
+
+	/* the thread that loads the config takes part in the parsing, so it is not part of the pool */
+
+	pool_resize(&cfg->pool, n > 1 ? n - 1 : 0);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+ccfg_stream_begin(ccfg *cfg)
+{
+	if (cfg->err)
+	{
+		return;
+	}
+
+	if (cfg->feed)
+	{
+		source_feed_end(cfg, false);
+	}
+
+	STATS_START(&cfg->stats);
+	profile_clear(&cfg->profile);
+
+	own_resources(cfg, false);
+	cbook_clear(cfg->sequences);
+	cbook_clear(cfg->names);
+	cdict_clear(cfg->keys_sequences);
+	numbers_clear(&cfg->numbers);
+	lazy_clear(&cfg->lazy);
+	taint_clear(&cfg->taint);
+	thaw(cfg);
+	trace_clear(&cfg->trace);
+	STATS_LAP(&cfg->stats, time_clear);
+
+	cfg->internal = true;
+
+	source_feed_begin(cfg);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+ccfg_stream_end(ccfg *cfg)
+{
+	if (!cfg->feed)
+	{
+		return;
+	}
+
+	if (cfg->err)
+	{
+		source_feed_end(cfg, false);
+		return;
+	}
+
+	source_feed_end(cfg, true);
+	STATS_LAP(&cfg->stats, time_parse);
+
+	watch_arm(&cfg->watch, &cfg->trace, cfg->sources);
+
+	update_err(cfg);
+	bind_handles(cfg);
+	track_changes(cfg);
+
+	cfg->taint.valid = cfg->taint.enabled && !cfg->err;
+	STATS_LAP(&cfg->stats, time_finish);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+ccfg_stream_feed(ccfg *cfg, const char *data, size_t n)
+{
+	if (cfg->err || !cfg->feed)
+	{
+		return;
+	}
+
+	source_feed(cfg, data, n);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+ccfg_trim(ccfg *cfg)
+{
+	if (cfg->err)
+	{
+		return;
+	}
+
+	cbook_destroy(cfg->vars);
+	cbook_destroy(cfg->iteration);
+	cdict_destroy(cfg->keys_vars);
+	cstr_destroy(cfg->scratch);
+	loop_free(&cfg->loop);
+	memo_free(&cfg->memo);
+
+	cfg->vars      = cbook_create();
+	cfg->iteration = cbook_create();
+	cfg->keys_vars = cdict_create();
+	cfg->scratch   = cstr_create();
+
+	loop_init(&cfg->loop);
+	memo_init(&cfg->memo);
+
+	update_err(cfg);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+ccfg_unrestrict(ccfg *cfg)
+{
+	if (cfg->err)
 	{
 		return;
 	}
@@ -412,9 +1406,555 @@ ccfg_unrestrict(ccfg *cfg)
 	cfg->restricted = false;
 }
 
-/************************************************************************************************************/
-/* STATIC ***************************************************************************************************/
-/************************************************************************************************************/
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+int
+ccfg_watch(ccfg *cfg)
+{
+	if (cfg->err || !watch_open(&cfg->watch))
+	{
+		return -1;
+	}
+
+	watch_arm(&cfg->watch, &cfg->trace, cfg->sources);
+
+	if (update_err(cfg))
+	{
+		return -1;
+	}
+
+	return cfg->watch.fd;
+}
+
+/************************************************************************************************************/
+/* STATIC ***************************************************************************************************/
+/************************************************************************************************************/
+
+static void
+adopt_resources(ccfg *cfg, ccfg *src)
+{
+	drop_resources(cfg);
+	lazy_clear(&cfg->lazy);
+	taint_clear(&cfg->taint);
+	trace_clear(&cfg->trace);
+
+	cfg->sequences       = src->sequences;
+	cfg->names           = src->names;
+	cfg->keys_sequences  = src->keys_sequences;
+	cfg->numbers         = src->numbers;
+	cfg->frozen          = src->frozen;
+	cfg->frozen_mapped   = src->frozen_mapped;
+	cfg->it_group        = SIZE_MAX;
+	cfg->it              = SIZE_MAX;
+	cfg->resources_share = share_acquire(src->resources_share);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+adopt_sources(ccfg *cfg, ccfg *src)
+{
+	drop_filters(cfg);
+	drop_sources(cfg);
+
+	cfg->filters       = src->filters;
+	cfg->keys_filters  = src->keys_filters;
+	cfg->sources       = src->sources;
+	cfg->filters_hash  = src->filters_hash;
+	cfg->filters_share = share_acquire(src->filters_share);
+	cfg->sources_share = share_acquire(src->sources_share);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+bind_handles(ccfg *cfg)
+{
+	for (size_t i = 0; i < cbook_groups_number(cfg->handles); i++)
+	{
+		cfg->handles_groups[i] = cfg->err ? SIZE_MAX : find_group(
+			cfg,
+			cbook_word_in_group(cfg->handles, i, 0),
+			cbook_word_in_group(cfg->handles, i, 1));
+	}
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static bool
+convert(const ccfg *cfg, size_t group, const struct ccfg_field *field)
+{
+	double d;
+
+	d = number(cfg, group, 0);
+
+	switch (field->type)
+	{
+		case CCFG_TYPE_STRING:
+			*(const char**)field->destination = value(cfg, group, 0);
+			return true;
+
+		case CCFG_TYPE_DOUBLE:
+			if (isnan(d))
+			{
+				return false;
+			}
+			*(double*)field->destination = d;
+			return true;
+
+		case CCFG_TYPE_LONG:
+			if (!fits_long(d))
+			{
+				return false;
+			}
+			*(long long*)field->destination = d;
+			return true;
+
+		case CCFG_TYPE_COLOR:
+			if (!fits_color(d))
+			{
+				return false;
+			}
+			*(struct ccolor*)field->destination = ccolor_from_argb_uint(d);
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+drop_filters(ccfg *cfg)
+{
+	if (share_release(cfg->filters_share))
+	{
+		cbook_destroy(cfg->filters);
+		cdict_destroy(cfg->keys_filters);
+	}
+
+	cfg->filters_share = NULL;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+drop_params(ccfg *cfg)
+{
+	if (share_release(cfg->params_share))
+	{
+		cbook_destroy(cfg->params);
+		cdict_destroy(cfg->keys_params);
+	}
+
+	cfg->params_share = NULL;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+drop_resources(ccfg *cfg)
+{
+	if (share_release(cfg->resources_share))
+	{
+		cbook_destroy(cfg->sequences);
+		cbook_destroy(cfg->names);
+		cdict_destroy(cfg->keys_sequences);
+		numbers_free(&cfg->numbers);
+		freeze_destroy(cfg->frozen, cfg->frozen_mapped);
+	}
+
+	cfg->resources_share = NULL;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+drop_sources(ccfg *cfg)
+{
+	if (share_release(cfg->sources_share))
+	{
+		cbook_destroy(cfg->sources);
+	}
+
+	cfg->sources_share = NULL;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static size_t
+evaluate(ccfg *cfg, size_t group)
+{
+	const struct lazy_entry *entry;
+
+	/* deferred resources that turn out to have no values fall back to the definition they replaced */
+
+	while ((entry = lazy_entry(&cfg->lazy, group)))
+	{
+		source_parse_deferred(cfg, group);
+		if (entry->values != LAZY_EMPTY)
+		{
+			break;
+		}
+		group = entry->previous;
+	}
+
+	return group;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static size_t
+find_group(const ccfg *cfg, const char *namespace, const char *property)
+{
+	size_t i;
+	size_t j;
+
+	if (cfg->frozen)
+	{
+		return freeze_find(cfg->frozen, namespace, property);
+	}
+
+	if (cdict_find(cfg->keys_sequences, namespace, 0, &i)
+	 && cdict_find(cfg->keys_sequences, property,  i, &j))
+	{
+		return j;
+	}
+
+	return SIZE_MAX;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static bool
+fits_color(double d)
+{
+	return d >= 0.0 && d <= UINT32_MAX;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static bool
+fits_long(double d)
+{
+	return d > (double)LLONG_MIN && d < (double)LLONG_MAX;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static uint64_t
+hash_values(const ccfg *cfg, size_t group)
+{
+	uint64_t hash = UTIL_HASH_INIT;
+	const char *str;
+	double d;
+
+	/* numbers go along, values computed in a way that rounds to the same string still count as different */
+
+	for (size_t i = 0; i < length(cfg, group); i++)
+	{
+		str  = value(cfg, group, i);
+		d    = number(cfg, group, i);
+		hash = util_hash(hash, str, strlen(str) + 1);
+		hash = util_hash(hash, &d, sizeof(d));
+	}
+
+	return hash;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static size_t
+length(const ccfg *cfg, size_t group)
+{
+	const struct lazy_entry *entry;
+	size_t overlay;
+
+	if (cfg->frozen)
+	{
+		return freeze_length(cfg->frozen, group);
+	}
+
+	if ((entry = lazy_entry(&cfg->lazy, group)))
+	{
+		return cbook_group_length(cfg->lazy.values, entry->values);
+	}
+
+	if ((overlay = taint_overlay(&cfg->taint, group)) != SIZE_MAX)
+	{
+		return cbook_group_length(cfg->taint.values, overlay);
+	}
+
+	return cbook_group_length(cfg->sequences, group);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static uint64_t
+load_hash(const ccfg *cfg)
+{
+	uint64_t hash;
+	bool restricted;
+
+	restricted = cfg->restricted || getenv("CCFG_RESTRICT");
+
+	/* filtered out resources are not recorded, so a cached child only holds for the same filters */
+
+	hash = util_hash(cfg->params_hash, &cfg->filters_hash, sizeof(cfg->filters_hash));
+
+	return util_hash(hash, &restricted, sizeof(restricted));
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+mount_frozen(ccfg *cfg, struct freeze *frozen)
+{
+	own_resources(cfg, false);
+	cbook_clear(cfg->sequences);
+	cbook_clear(cfg->names);
+	cdict_clear(cfg->keys_sequences);
+	numbers_clear(&cfg->numbers);
+	lazy_clear(&cfg->lazy);
+	taint_clear(&cfg->taint);
+	thaw(cfg);
+	trace_clear(&cfg->trace);
+
+	cfg->frozen        = frozen;
+	cfg->frozen_mapped = true;
+
+	update_err(cfg);
+	bind_handles(cfg);
+	track_changes(cfg);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static double
+number(const ccfg *cfg, size_t group, size_t i)
+{
+	const struct lazy_entry *entry;
+	size_t overlay;
+
+	if (cfg->err)
+	{
+		return NAN;
+	}
+
+	if (cfg->frozen)
+	{
+		return freeze_number(cfg->frozen, group, i);
+	}
+
+	if ((entry = lazy_entry(&cfg->lazy, group)))
+	{
+		return numbers_get(&cfg->lazy.numbers, cbook_word_index(cfg->lazy.values, entry->values, i));
+	}
+
+	if ((overlay = taint_overlay(&cfg->taint, group)) != SIZE_MAX)
+	{
+		return i < cbook_group_length(cfg->taint.values, overlay)
+		     ? numbers_get(&cfg->taint.numbers, cbook_word_index(cfg->taint.values, overlay, i))
+		     : NAN;
+	}
+
+	if (group >= cbook_groups_number(cfg->sequences) || i >= cbook_group_length(cfg->sequences, group))
+	{
+		return NAN;
+	}
+
+	return numbers_get(&cfg->numbers, cbook_word_index(cfg->sequences, group, i));
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+own_filters(ccfg *cfg, bool keep)
+{
+	cbook *filters;
+	cdict *keys_filters;
+
+	if (share_is_owned(cfg->filters_share))
+	{
+		return;
+	}
+
+	filters      = keep ? cbook_clone(cfg->filters)      : cbook_create();
+	keys_filters = keep ? cdict_clone(cfg->keys_filters) : cdict_create();
+
+	drop_filters(cfg);
+
+	cfg->filters      = filters;
+	cfg->keys_filters = keys_filters;
+
+	update_err(cfg);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+own_params(ccfg *cfg, bool keep)
+{
+	cbook *params;
+	cdict *keys_params;
+
+	if (share_is_owned(cfg->params_share))
+	{
+		return;
+	}
+
+	params      = keep ? cbook_clone(cfg->params)      : cbook_create();
+	keys_params = keep ? cdict_clone(cfg->keys_params) : cdict_create();
+
+	drop_params(cfg);
+
+	cfg->params      = params;
+	cfg->keys_params = keys_params;
+
+	update_err(cfg);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+own_resources(ccfg *cfg, bool keep)
+{
+	struct numbers numbers;
+	struct freeze *frozen = NULL;
+	cbook *sequences;
+	cbook *names;
+	cdict *keys_sequences;
+
+	if (share_is_owned(cfg->resources_share))
+	{
+		return;
+	}
+
+	numbers_init(&numbers);
+
+	if (keep)
+	{
+		sequences      = cbook_clone(cfg->sequences);
+		names          = cbook_clone(cfg->names);
+		keys_sequences = cdict_clone(cfg->keys_sequences);
+		numbers_copy(&numbers, &cfg->numbers);
+		if (cfg->frozen && (frozen = malloc(cfg->frozen->size)))
+		{
+			memcpy(frozen, cfg->frozen, cfg->frozen->size);
+		}
+		if (cfg->frozen && !frozen)
+		{
+			numbers.err = true;
+		}
+	}
+	else
+	{
+		sequences      = cbook_create();
+		names          = cbook_create();
+		keys_sequences = cdict_create();
+		if (cfg->frozen)
+		{
+			cfg->it_group = SIZE_MAX;
+			cfg->it       = SIZE_MAX;
+		}
+	}
+
+	/* the other owners keep the originals, which only get freed here if they all let go meanwhile */
+
+	drop_resources(cfg);
+
+	cfg->sequences      = sequences;
+	cfg->names          = names;
+	cfg->keys_sequences = keys_sequences;
+	cfg->numbers        = numbers;
+	cfg->frozen         = frozen;
+	cfg->frozen_mapped  = false;
+
+	update_err(cfg);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+own_sources(ccfg *cfg, bool keep)
+{
+	cbook *sources;
+
+	if (share_is_owned(cfg->sources_share))
+	{
+		return;
+	}
+
+	sources = keep ? cbook_clone(cfg->sources) : cbook_create();
+
+	drop_sources(cfg);
+
+	cfg->sources = sources;
+
+	update_err(cfg);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void *
+run_load(void *data)
+{
+	struct load_job *job = data;
+
+	ccfg_load(job->cfg);
+
+	job->callback(job->cfg, job->data);
+
+	free(job);
+
+	return NULL;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+run_tenant(void *data, size_t i)
+{
+	const struct tenant_job *job = data;
+	ccfg *cfg = job->tenants[i];
+	uint64_t changes;
+
+	if (cfg->err)
+	{
+		return;
+	}
+
+	/* the template was just loaded from these sources, so tenants that cannot reuse its evaluation read */
+	/* the same ones                                                                                   */
+
+	adopt_sources(cfg, job->cfg);
+
+	if (job->cfg->taint.structural)
+	{
+		ccfg_load(cfg);
+		return;
+	}
+
+	/* the tenant only holds the values its params changed, on top of the table of the template */
+
+	adopt_resources(cfg, job->cfg);
+	taint_copy(&cfg->taint, &job->cfg->taint);
+
+	changes = taint_changes(&cfg->taint, cfg->params, cfg->keys_params);
+
+	if (!update_err(cfg) && changes && !source_reevaluate(cfg, changes, false))
+	{
+		ccfg_load(cfg);
+		return;
+	}
+
+	update_err(cfg);
+	bind_handles(cfg);
+	track_changes(cfg);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 
 static const char *
 select_source(const ccfg *cfg, size_t *index)
@@ -441,15 +1981,183 @@ select_source(const ccfg *cfg, size_t *index)
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 
+static void
+settle(ccfg *cfg)
+{
+	/* values a tenant evaluated again over a shared table get written into a table of its own */
+
+	if (cfg->taint.results_n > 0)
+	{
+		own_resources(cfg, true);
+		if (!cfg->err)
+		{
+			taint_settle(&cfg->taint, &cfg->sequences, &cfg->numbers);
+		}
+		update_err(cfg);
+	}
+
+	source_settle(cfg);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static bool
+share_all(ccfg *cfg)
+{
+	struct share **shares[] =
+	{
+		&cfg->filters_share,
+		&cfg->params_share,
+		&cfg->resources_share,
+		&cfg->sources_share,
+	};
+
+	/* components only get a reference count once they are about to be shared for the first time */
+
+	for (size_t i = 0; i < sizeof(shares) / sizeof(*shares); i++)
+	{
+		if (!*shares[i] && !(*shares[i] = share_create()))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+thaw(ccfg *cfg)
+{
+	if (!cfg->frozen)
+	{
+		return;
+	}
+
+	freeze_destroy(cfg->frozen, cfg->frozen_mapped);
+
+	cfg->frozen        = NULL;
+	cfg->frozen_mapped = false;
+	cfg->it_group      = SIZE_MAX;
+	cfg->it            = SIZE_MAX;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+track_changes(ccfg *cfg)
+{
+	const char *namespace;
+	const char *property;
+	size_t group;
+	size_t n;
+
+	if (cfg->err || !diff_is_tracking(&cfg->diff))
+	{
+		return;
+	}
+
+	diff_begin(&cfg->diff);
+
+	/* frozen tables only hold live resources, while the books also keep the groups of redefined ones */
+
+	n = cfg->frozen ? cfg->frozen->entries_n : cbook_groups_number(cfg->names);
+
+	for (size_t g = 0; g < n; g++)
+	{
+		if (cfg->frozen)
+		{
+			namespace = freeze_namespace(cfg->frozen, g);
+			property  = freeze_property(cfg->frozen, g);
+		}
+		else
+		{
+			namespace = cbook_word_in_group(cfg->names, g, 0);
+			property  = cbook_word_in_group(cfg->names, g, 1);
+			if (find_group(cfg, namespace, property) != g)
+			{
+				continue;
+			}
+		}
+
+		/* deferred values are evaluated the way fetching them would */
+
+		if ((group = evaluate(cfg, g)) != SIZE_MAX)
+		{
+			diff_push(&cfg->diff, namespace, property, hash_values(cfg, group));
+		}
+	}
+
+	diff_end(&cfg->diff);
+
+	if (!update_err(cfg))
+	{
+		diff_notify(&cfg->diff, cfg);
+	}
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
 static enum cerr
 update_err(ccfg *cfg)
 {
+	SET_ERR(cbook_error(cfg->filters))
 	SET_ERR(cbook_error(cfg->params))
 	SET_ERR(cbook_error(cfg->sequences))
+	SET_ERR(cbook_error(cfg->names))
 	SET_ERR(cbook_error(cfg->sources))
+	SET_ERR(cbook_error(cfg->handles))
+	SET_ERR(cbook_error(cfg->vars))
+	SET_ERR(cbook_error(cfg->iteration))
+	SET_ERR(cdict_error(cfg->keys_filters))
 	SET_ERR(cdict_error(cfg->keys_params))
 	SET_ERR(cdict_error(cfg->keys_sequences))
-	SET_ERR(cdict_error(cfg->tokens))
+	SET_ERR(cdict_error(cfg->keys_vars))
+	SET_ERR(cstr_error(cfg->scratch))
+	SET_ERR(cdict_error(cfg->watch.keys_names))
+	SET_ERR(cbook_error(cfg->lazy.words))
+	SET_ERR(cbook_error(cfg->lazy.values))
+	SET_ERR(cfg->numbers.err || cfg->watch.err ? CERR_MEMORY : CERR_NONE)
+	SET_ERR(cbook_error(cfg->profile.files))
+	SET_ERR(cdict_error(cfg->profile.keys_files))
+	SET_ERR(cdict_error(cfg->profile.keys_nodes))
+	SET_ERR(cfg->lazy.numbers.err || cfg->lazy.err ? CERR_MEMORY : CERR_NONE)
+	SET_ERR(cfg->profile.err ? CERR_MEMORY : CERR_NONE)
+	SET_ERR(cbook_error(cfg->taint.lines))
+	SET_ERR(cbook_error(cfg->taint.params))
+	SET_ERR(cbook_error(cfg->taint.vars))
+	SET_ERR(cbook_error(cfg->taint.values))
+	SET_ERR(cdict_error(cfg->taint.keys_params))
+	SET_ERR(cdict_error(cfg->taint.keys_vars))
+	SET_ERR(cfg->taint.numbers.err || cfg->taint.err ? CERR_MEMORY : CERR_NONE)
+	SET_ERR(cfg->diff.err ? CERR_MEMORY : CERR_NONE)
 
 	return cfg->err;
 }
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static const char *
+value(const ccfg *cfg, size_t group, size_t i)
+{
+	const struct lazy_entry *entry;
+	size_t overlay;
+
+	if (cfg->frozen)
+	{
+		return freeze_value(cfg->frozen, group, i);
+	}
+
+	if ((entry = lazy_entry(&cfg->lazy, group)))
+	{
+		return cbook_word_in_group(cfg->lazy.values, entry->values, i);
+	}
+
+	if ((overlay = taint_overlay(&cfg->taint, group)) != SIZE_MAX)
+	{
+		return cbook_word_in_group(cfg->taint.values, overlay, i);
+	}
+
+	return cbook_word_in_group(cfg->sequences, group, i);
+}
@@ -22,6 +22,25 @@
 
 #include <cassette/cobj.h>
 #include <stdbool.h>
+#include <stdint.h>
+
+#include "cache.h"
+#include "channel.h"
+#include "diff.h"
+#include "feed.h"
+#include "freeze.h"
+#include "lazy.h"
+#include "loop.h"
+#include "memo.h"
+#include "numbers.h"
+#include "pool.h"
+#include "profile.h"
+#include "share.h"
+#include "stats.h"
+#include "stream.h"
+#include "taint.h"
+#include "trace.h"
+#include "watch.h"
 
 /************************************************************************************************************/
 /************************************************************************************************************/
@@ -29,14 +48,66 @@
 
 struct ccfg
 {
+	cbook *filters;
 	cbook *params;
 	cbook *sequences; 
+	cbook *names;
 	cbook *sources;
+	cbook *handles;
+	cbook *vars;
+	cbook *iteration;
+	cdict *keys_filters;
 	cdict *keys_params;
 	cdict *keys_sequences;
-	cdict *tokens;
+	cdict *keys_vars;
+	cstr *scratch;
+	struct freeze *frozen;
+	bool frozen_mapped;
+	struct feed *feed;
+	struct numbers numbers;
+	struct lazy lazy;
+	struct profile profile;
+	struct taint taint;
+	struct diff diff;
+	struct loop loop;
+	size_t *handles_groups;
+	size_t handles_cap;
+	struct stream *streams;
+	struct trace trace;
+	struct stats stats;
+	struct watch watch;
+	struct channel channel;
+	struct cache cache;
+	struct memo memo;
+	struct pool pool;
+	struct share *filters_share;
+	struct share *params_share;
+	struct share *resources_share;
+	struct share *sources_share;
+	uint64_t filters_hash;
+	uint64_t params_hash;
 	size_t it_group;
 	size_t it;
 	bool restricted;
+	bool internal;
 	enum cerr err;
 };
+
+/**
+ * Load handed to a thread of its own by ccfg_load_async().
+ */
+struct load_job
+{
+	ccfg *cfg;
+	ccfg_load_callback callback;
+	void *data;
+};
+
+/**
+ * Tenants handed out to the threads of the template's pool by ccfg_load_tenants().
+ */
+struct tenant_job
+{
+	ccfg *cfg;
+	ccfg *const *tenants;
+};
@@ -0,0 +1,164 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#include <cassette/ccfg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "memo.h"
+#include "token.h"
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+static size_t slot_of (enum token, const double *, size_t) CCFG_NONNULL(2);
+
+/************************************************************************************************************/
+/* PRIVATE **************************************************************************************************/
+/************************************************************************************************************/
+
+struct memo_slot *
+memo_find(struct memo *memo, enum token type, const double *args, size_t n)
+{
+	struct memo_slot *slot;
+
+	if (!memo->slots)
+	{
+		return NULL;
+	}
+
+	if (memo->idle > 0)
+	{
+		memo->idle--;
+		return NULL;
+	}
+
+	/* stay idle for 15 windows out of 16 while less than one lookup in 8 is a hit */
+
+	if (++memo->lookups == MEMO_WINDOW)
+	{
+		memo->idle    = memo->hits < MEMO_WINDOW / 8 ? MEMO_WINDOW * 15 : 0;
+		memo->lookups = 0;
+		memo->hits    = 0;
+	}
+
+	/* arguments are compared bitwise, so that NaN matches itself and -0 does not match 0 */
+
+	slot = memo->slots + slot_of(type, args, n);
+
+	if (slot->type != type || memcmp(slot->args, args, n * sizeof(double)) != 0)
+	{
+		return NULL;
+	}
+
+	memo->hits++;
+
+	return slot;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+memo_free(struct memo *memo)
+{
+	free(memo->slots);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+memo_init(struct memo *memo)
+{
+	memo->slots   = NULL;
+	memo->lookups = 0;
+	memo->hits    = 0;
+	memo->idle    = 0;
+	memo->err     = false;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+struct memo_slot *
+memo_store(struct memo *memo, enum token type, const double *args, size_t n, double result)
+{
+	struct memo_slot *slot;
+
+	/* zeroed slots are never matched since their type is TOKEN_INVALID */
+
+	if (!memo->slots && !memo->err && !(memo->slots = calloc(MEMO_SLOTS, sizeof(struct memo_slot))))
+	{
+		memo->err = true;
+	}
+
+	if (!memo->slots || memo->idle > 0)
+	{
+		return NULL;
+	}
+
+	slot = memo->slots + slot_of(type, args, n);
+
+	memcpy(slot->args, args, n * sizeof(double));
+
+	slot->result   = result;
+	slot->type     = type;
+	slot->text_len = 0;
+
+	return slot;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+memo_store_text(struct memo_slot *slot, const char *text, size_t len)
+{
+	if (len == 0 || len >= MEMO_TEXT_LEN)
+	{
+		return;
+	}
+
+	memcpy(slot->text, text, len + 1);
+
+	slot->text_len = len;
+}
+
+/************************************************************************************************************/
+/* STATIC ***************************************************************************************************/
+/************************************************************************************************************/
+
+static size_t
+slot_of(enum token type, const double *args, size_t n)
+{
+	uint64_t hash = (uint64_t)type * 0x9E3779B97F4A7C15ULL;
+	uint64_t bits;
+
+	/* a few multiply-xorshift rounds, arguments are mixed as whole words rather than bytes */
+
+	for (size_t i = 0; i < n; i++)
+	{
+		memcpy(&bits, args + i, sizeof(bits));
+		hash = (hash ^ bits) * 0xBF58476D1CE4E5B9ULL;
+		hash ^= hash >> 31;
+	}
+
+	return hash % MEMO_SLOTS;
+}
@@ -0,0 +1,119 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#pragma once
+
+#include <cassette/ccfg.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "token.h"
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#define MEMO_SLOTS    2048
+#define MEMO_ARGS_N   4
+#define MEMO_TEXT_LEN 24
+#define MEMO_WINDOW   256
+
+/************************************************************************************************************/
+/* TYPES ****************************************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * Result of a math or color operation, along with the operator and the argument values it was computed
+ * from. The string form of the result is only filled in once it gets asked for, and only if it is short
+ * enough, text_len stays 0 otherwise.
+ */
+struct memo_slot
+{
+	double args[MEMO_ARGS_N];
+	double result;
+	enum token type;
+	size_t text_len;
+	char text[MEMO_TEXT_LEN];
+};
+
+/**
+ * Fixed size table of the last operations evaluated by the parser, with slots picked from the hash of the
+ * operator and arguments. A newer result simply replaces the older one that used the same slot. Slots are
+ * only allocated once the first result gets stored.
+ *
+ * Lookups are counted by windows of MEMO_WINDOW. When too few of them hit within a window, the table is
+ * left idle for the next few ones, so that sources in which values never repeat do not pay for it.
+ */
+struct memo
+{
+	struct memo_slot *slots;
+	size_t lookups;
+	size_t hits;
+	size_t idle;
+	bool err;
+};
+
+/************************************************************************************************************/
+/* CONSTRUCTORS / DESTRUCTORS *******************************************************************************/
+/************************************************************************************************************/
+
+void
+memo_init(struct memo *memo)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+memo_free(struct memo *memo)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/************************************************************************************************************/
+/* PROCEDURES ***********************************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * Looks up a previously stored result of the same operation over the exact same argument values. Returns
+ * NULL if there is none or if the table is idle.
+ */
+struct memo_slot *
+memo_find(struct memo *memo, enum token type, const double *args, size_t n)
+CCFG_NONNULL(1, 3)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Saves the result of an operation, and returns the slot it was written to so that its string form can be
+ * added to it. Returns NULL if the table is idle or if the slots could not be allocated. Only the n first
+ * arguments are used.
+ */
+struct memo_slot *
+memo_store(struct memo *memo, enum token type, const double *args, size_t n, double result)
+CCFG_NONNULL(1, 3)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+memo_store_text(struct memo_slot *slot, const char *text, size_t len)
+CCFG_NONNULL(1, 2)
+CCFG_HIDDEN;
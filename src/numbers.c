@@ -0,0 +1,133 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+#include <cassette/ccfg.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "numbers.h"
+#include "util.h"
+
+/************************************************************************************************************/
+/* PRIVATE **************************************************************************************************/
+/************************************************************************************************************/
+
+void
+numbers_clear(struct numbers *numbers)
+{
+	numbers->n   = 0;
+	numbers->err = false;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+numbers_copy(struct numbers *numbers, const struct numbers *src)
+{
+	double *tmp;
+
+	numbers->n   = 0;
+	numbers->err = src->err;
+
+	if (src->n == 0)
+	{
+		return;
+	}
+
+	if (!(tmp = util_reserve(numbers->values, &numbers->cap, src->n, sizeof(double))))
+	{
+		numbers->err = true;
+		return;
+	}
+
+	memcpy(tmp, src->values, src->n * sizeof(double));
+
+	numbers->values = tmp;
+	numbers->n      = src->n;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+numbers_free(struct numbers *numbers)
+{
+	free(numbers->values);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+double
+numbers_get(const struct numbers *numbers, size_t i)
+{
+	return i < numbers->n ? numbers->values[i] : NAN;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+numbers_init(struct numbers *numbers)
+{
+	numbers->values = NULL;
+	numbers->n      = 0;
+	numbers->cap    = 0;
+	numbers->err    = false;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+numbers_push(struct numbers *numbers, double d)
+{
+	double *tmp;
+
+	if (!(tmp = util_reserve(numbers->values, &numbers->cap, numbers->n + 1, sizeof(double))))
+	{
+		numbers->err = true;
+		return;
+	}
+
+	numbers->values = tmp;
+	numbers->values[numbers->n++] = d;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+numbers_push_str(struct numbers *numbers, const char *str)
+{
+	double d;
+	char *end;
+	bool err = false;
+
+	/* unlike the parser, which reads any string as a number, only values fully made of a number are kept */
+
+	if (str[0] == '#')
+	{
+		d = util_str_to_double(str, &err);
+	}
+	else
+	{
+		d   = strtod(str, &end);
+		err = end == str || *end != '\0';
+	}
+
+	numbers_push(numbers, err ? NAN : d);
+}
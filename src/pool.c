@@ -0,0 +1,208 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#include <cassette/ccfg.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "pool.h"
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+static void   start     (struct pool *) CCFG_NONNULL(1);
+static void   take_jobs (struct pool *) CCFG_NONNULL(1);
+static void * work      (void *)        CCFG_NONNULL(1);
+
+/************************************************************************************************************/
+/* PRIVATE **************************************************************************************************/
+/************************************************************************************************************/
+
+void
+pool_free(struct pool *pool)
+{
+	pool_resize(pool, 0);
+
+	pthread_mutex_destroy(&pool->mutex);
+	pthread_cond_destroy(&pool->cond_start);
+	pthread_cond_destroy(&pool->cond_done);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+pool_init(struct pool *pool)
+{
+	pool->threads     = NULL;
+	pool->threads_n   = 0;
+	pool->threads_max = 0;
+	pool->started     = false;
+	pool->job         = NULL;
+	pool->data        = NULL;
+	pool->jobs_n      = 0;
+	pool->jobs_next   = 0;
+	pool->jobs_done   = 0;
+	pool->batch       = 0;
+	pool->stop        = false;
+
+	pthread_mutex_init(&pool->mutex, NULL);
+	pthread_cond_init(&pool->cond_start, NULL);
+	pthread_cond_init(&pool->cond_done, NULL);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+pool_resize(struct pool *pool, size_t n)
+{
+	/* stop and collect the current workers */
+
+	pthread_mutex_lock(&pool->mutex);
+	pool->stop = true;
+	pthread_cond_broadcast(&pool->cond_start);
+	pthread_mutex_unlock(&pool->mutex);
+
+	for (size_t i = 0; i < pool->threads_n; i++)
+	{
+		pthread_join(pool->threads[i], NULL);
+	}
+
+	free(pool->threads);
+
+	pool->threads     = NULL;
+	pool->threads_n   = 0;
+	pool->threads_max = n;
+	pool->started     = false;
+	pool->stop        = false;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+pool_run(struct pool *pool, void (*job)(void *, size_t), void *data, size_t n)
+{
+	if (!pool->started)
+	{
+		start(pool);
+	}
+
+	pthread_mutex_lock(&pool->mutex);
+
+	pool->job       = job;
+	pool->data      = data;
+	pool->jobs_n    = n;
+	pool->jobs_next = 0;
+	pool->jobs_done = 0;
+	pool->batch++;
+
+	pthread_cond_broadcast(&pool->cond_start);
+
+	take_jobs(pool);
+
+	while (pool->jobs_done < pool->jobs_n)
+	{
+		pthread_cond_wait(&pool->cond_done, &pool->mutex);
+	}
+
+	pthread_mutex_unlock(&pool->mutex);
+}
+
+/************************************************************************************************************/
+/* STATIC ***************************************************************************************************/
+/************************************************************************************************************/
+
+static void
+start(struct pool *pool)
+{
+	/* a failed start is not retried, the batches get run by the workers that could be started */
+
+	pool->started = true;
+
+	if (pool->threads_max == 0 || !(pool->threads = malloc(pool->threads_max * sizeof(pthread_t))))
+	{
+		return;
+	}
+
+	for (; pool->threads_n < pool->threads_max; pool->threads_n++)
+	{
+		if (pthread_create(pool->threads + pool->threads_n, NULL, work, pool) != 0)
+		{
+			return;
+		}
+	}
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+take_jobs(struct pool *pool)
+{
+	size_t i;
+
+	/* called with the mutex held, which is released while a job runs */
+
+	while (pool->jobs_next < pool->jobs_n)
+	{
+		i = pool->jobs_next++;
+
+		pthread_mutex_unlock(&pool->mutex);
+		pool->job(pool->data, i);
+		pthread_mutex_lock(&pool->mutex);
+
+		if (++pool->jobs_done == pool->jobs_n)
+		{
+			pthread_cond_broadcast(&pool->cond_done);
+		}
+	}
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void *
+work(void *data)
+{
+	struct pool *pool = data;
+	size_t batch = 0;
+
+	pthread_mutex_lock(&pool->mutex);
+
+	for (;;)
+	{
+		while (!pool->stop && pool->batch == batch)
+		{
+			pthread_cond_wait(&pool->cond_start, &pool->mutex);
+		}
+
+		if (pool->stop)
+		{
+			break;
+		}
+
+		batch = pool->batch;
+		take_jobs(pool);
+	}
+
+	pthread_mutex_unlock(&pool->mutex);
+
+	return NULL;
+}
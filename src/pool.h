@@ -0,0 +1,94 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#pragma once
+
+#include <cassette/ccfg.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+/************************************************************************************************************/
+/* TYPES ****************************************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * Fixed set of worker threads that run batches of jobs alongside the thread that submits them. Jobs of a
+ * batch are handed out one index at a time, and a batch is over once every one of them returned. Workers
+ * are only started with the first batch, so that a pool that never runs any costs no threads.
+ */
+struct pool
+{
+	pthread_t *threads;
+	size_t threads_n;
+	size_t threads_max;
+	bool started;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond_start;
+	pthread_cond_t cond_done;
+	void (*job)(void *, size_t);
+	void *data;
+	size_t jobs_n;
+	size_t jobs_next;
+	size_t jobs_done;
+	size_t batch;
+	bool stop;
+};
+
+/************************************************************************************************************/
+/* CONSTRUCTORS / DESTRUCTORS *******************************************************************************/
+/************************************************************************************************************/
+
+void
+pool_init(struct pool *pool)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+pool_free(struct pool *pool)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/************************************************************************************************************/
+/* PROCEDURES ***********************************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * Stops the current worker threads and sets the number of new ones to start with the next batch. If not all
+ * of them can be started then, the pool keeps running with the ones that were.
+ */
+void
+pool_resize(struct pool *pool, size_t n)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Calls job(data, i) for every i in [0, n) and waits until all of the calls returned. The calling thread
+ * takes part in the batch, so jobs still get run, one after another, by a pool without workers.
+ */
+void
+pool_run(struct pool *pool, void (*job)(void *, size_t), void *data, size_t n)
+CCFG_NONNULL(1, 2)
+CCFG_HIDDEN;
@@ -0,0 +1,348 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#include <cassette/ccfg.h>
+#include <cassette/cobj.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "profile.h"
+#include "util.h"
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#define PROFILE_KEY_LEN 48
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+static int  compare     (const void *, const void *)             CCFG_NONNULL(1, 2);
+static bool save_folded (const struct profile *, FILE *)         CCFG_NONNULL(1, 2);
+static bool save_report (const struct profile *, FILE *)         CCFG_NONNULL(1, 2);
+static void write_stack (const struct profile *, FILE *, size_t) CCFG_NONNULL(1, 2);
+
+/************************************************************************************************************/
+/* PRIVATE **************************************************************************************************/
+/************************************************************************************************************/
+
+void
+profile_clear(struct profile *profile)
+{
+	cbook_clear(profile->files);
+	cdict_clear(profile->keys_files);
+	cdict_clear(profile->keys_nodes);
+
+	profile->nodes_n  = 0;
+	profile->frames_n = 0;
+	profile->err      = false;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+profile_count(struct profile *profile)
+{
+	if (profile->frames_n > 0)
+	{
+		profile->nodes[profile->frames[profile->frames_n - 1].node].substitutions++;
+	}
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+profile_enter(struct profile *profile, const char *path, size_t line)
+{
+	struct profile_node *node;
+	struct profile_frame *frame;
+	char key[PROFILE_KEY_LEN];
+	size_t parent;
+	size_t file;
+	size_t i;
+
+	if (!(frame = util_reserve(profile->frames, &profile->frames_cap, profile->frames_n + 1, sizeof(*frame))))
+	{
+		profile->err = true;
+		return;
+	}
+
+	profile->frames = frame;
+
+	/* the parent goes in the dictionary group, shifted by one to leave group 0 to the root sequences */
+
+	parent = profile->frames_n > 0 ? profile->frames[profile->frames_n - 1].node : SIZE_MAX;
+
+	if (!cdict_find(profile->keys_files, path, 0, &file))
+	{
+		file = cbook_words_number(profile->files);
+		cbook_write(profile->files, path);
+		cdict_write(profile->keys_files, path, 0, file);
+	}
+
+	snprintf(key, PROFILE_KEY_LEN, "%zu:%zu", file, line);
+
+	if (!cdict_find(profile->keys_nodes, key, parent + 1, &i))
+	{
+		if (!(node = util_reserve(profile->nodes, &profile->nodes_cap, profile->nodes_n + 1, sizeof(*node))))
+		{
+			profile->err = true;
+			i = SIZE_MAX;
+		}
+		else
+		{
+			profile->nodes = node;
+			i = profile->nodes_n++;
+			profile->nodes[i].parent        = parent;
+			profile->nodes[i].file          = file;
+			profile->nodes[i].line          = line;
+			profile->nodes[i].time          = 0;
+			profile->nodes[i].sequences     = 0;
+			profile->nodes[i].substitutions = 0;
+			cdict_write(profile->keys_nodes, key, parent + 1, i);
+		}
+	}
+
+	/* frames are pushed even without a node so that profile_leave() stays balanced, they get dropped there */
+
+	frame = profile->frames + profile->frames_n++;
+	frame->node     = i;
+	frame->children = 0;
+	frame->start    = util_clock();
+
+	if (i != SIZE_MAX)
+	{
+		profile->nodes[i].sequences++;
+	}
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+profile_free(struct profile *profile)
+{
+	cbook_destroy(profile->files);
+	cdict_destroy(profile->keys_files);
+	cdict_destroy(profile->keys_nodes);
+	free(profile->nodes);
+	free(profile->frames);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+profile_init(struct profile *profile)
+{
+	profile->files      = cbook_create();
+	profile->keys_files = cdict_create();
+	profile->keys_nodes = cdict_create();
+	profile->nodes      = NULL;
+	profile->frames     = NULL;
+	profile->nodes_n    = 0;
+	profile->nodes_cap  = 0;
+	profile->frames_n   = 0;
+	profile->frames_cap = 0;
+	profile->enabled    = false;
+	profile->err        = false;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+profile_leave(struct profile *profile)
+{
+	struct profile_frame *frame;
+	uint64_t elapsed;
+
+	if (profile->frames_n == 0)
+	{
+		return;
+	}
+
+	frame   = profile->frames + --profile->frames_n;
+	elapsed = util_clock() - frame->start;
+
+	if (frame->node != SIZE_MAX)
+	{
+		profile->nodes[frame->node].time += elapsed - frame->children;
+	}
+
+	if (profile->frames_n > 0)
+	{
+		profile->frames[profile->frames_n - 1].children += elapsed;
+	}
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+bool
+profile_save(const struct profile *profile, const char *path, enum ccfg_profile_format format)
+{
+	FILE *f;
+	bool ok;
+
+	if (profile->err
+	 || cbook_error(profile->files)
+	 || cdict_error(profile->keys_files)
+	 || cdict_error(profile->keys_nodes)
+	 || !(f = fopen(path, "w")))
+	{
+		return false;
+	}
+
+	switch (format)
+	{
+		case CCFG_PROFILE_REPORT:
+			ok = save_report(profile, f);
+			break;
+
+		case CCFG_PROFILE_FOLDED:
+			ok = save_folded(profile, f);
+			break;
+
+		default:
+			ok = false;
+			break;
+	}
+
+	return fclose(f) == 0 && ok;
+}
+
+/************************************************************************************************************/
+/* STATIC ***************************************************************************************************/
+/************************************************************************************************************/
+
+static int
+compare(const void *a, const void *b)
+{
+	const struct profile_node *node_a = a;
+	const struct profile_node *node_b = b;
+
+	/* most expensive lines first, then in source order */
+
+	if (node_a->time != node_b->time)
+	{
+		return node_a->time < node_b->time ? 1 : -1;
+	}
+
+	if (node_a->file != node_b->file)
+	{
+		return node_a->file < node_b->file ? -1 : 1;
+	}
+
+	return (node_a->line > node_b->line) - (node_a->line < node_b->line);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static bool
+save_folded(const struct profile *profile, FILE *f)
+{
+	for (size_t i = 0; i < profile->nodes_n; i++)
+	{
+		if (profile->nodes[i].time == 0)
+		{
+			continue;
+		}
+
+		write_stack(profile, f, i);
+		fprintf(f, " %llu\n", (unsigned long long)profile->nodes[i].time);
+	}
+
+	return !ferror(f);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static bool
+save_report(const struct profile *profile, FILE *f)
+{
+	struct profile_node *lines;
+	cdict *keys_lines;
+	char key[PROFILE_KEY_LEN];
+	size_t lines_n = 0;
+	size_t j;
+	bool ok;
+
+	if (!(lines = malloc((profile->nodes_n + 1) * sizeof(struct profile_node))))
+	{
+		return false;
+	}
+
+	/* the same line reached through different chains of sequences is reported once */
+
+	keys_lines = cdict_create();
+
+	for (size_t i = 0; i < profile->nodes_n; i++)
+	{
+		snprintf(key, PROFILE_KEY_LEN, "%zu:%zu", profile->nodes[i].file, profile->nodes[i].line);
+		if (cdict_find(keys_lines, key, 0, &j))
+		{
+			lines[j].time          += profile->nodes[i].time;
+			lines[j].sequences     += profile->nodes[i].sequences;
+			lines[j].substitutions += profile->nodes[i].substitutions;
+		}
+		else
+		{
+			lines[lines_n] = profile->nodes[i];
+			cdict_write(keys_lines, key, 0, lines_n++);
+		}
+	}
+
+	if ((ok = !cdict_error(keys_lines)))
+	{
+		qsort(lines, lines_n, sizeof(struct profile_node), compare);
+		fprintf(f, "%16s %12s %14s  %s\n", "self time (us)", "sequences", "substitutions", "source");
+	}
+
+	for (const struct profile_node *l = lines; l < lines + lines_n && ok; l++)
+	{
+		fprintf(f, "%16.3f %12zu %14zu  ", l->time / 1000.0, l->sequences, l->substitutions);
+		fprintf(f, "%s:%zu\n", cbook_word(profile->files, l->file), l->line);
+	}
+
+	cdict_destroy(keys_lines);
+	free(lines);
+
+	return ok && !ferror(f);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+write_stack(const struct profile *profile, FILE *f, size_t node)
+{
+	const struct profile_node *n = profile->nodes + node;
+
+	/* chains are as deep as sequences can be nested, which is bounded by the parser's maximum depth */
+
+	if (n->parent != SIZE_MAX)
+	{
+		write_stack(profile, f, n->parent);
+		fputc(';', f);
+	}
+
+	fprintf(f, "%s:%zu", cbook_word(profile->files, n->file), n->line);
+}
@@ -0,0 +1,143 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#pragma once
+
+#include <cassette/ccfg.h>
+#include <cassette/cobj.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/************************************************************************************************************/
+/* TYPES ****************************************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * Source line as reached through a given chain of sequences. Nodes form a tree in which the parent of a
+ * sequence is the INCLUDE or FOR_EACH sequence it was run from, or SIZE_MAX for sequences of the root file.
+ * Time only counts the time spent in the sequence itself, not in the ones it ran.
+ */
+struct profile_node
+{
+	size_t parent;
+	size_t file;
+	size_t line;
+	uint64_t time;
+	size_t sequences;
+	size_t substitutions;
+};
+
+/**
+ * Sequence being parsed, along with the time spent in the sequences it ran so far.
+ */
+struct profile_frame
+{
+	size_t node;
+	uint64_t start;
+	uint64_t children;
+};
+
+/**
+ * Time and substitutions attributed to the source lines read during a load. Files are looked up by path,
+ * and nodes by their file and line, stored as a string, and by their parent, stored as dictionary group.
+ */
+struct profile
+{
+	cbook *files;
+	cdict *keys_files;
+	cdict *keys_nodes;
+	struct profile_node *nodes;
+	struct profile_frame *frames;
+	size_t nodes_n;
+	size_t nodes_cap;
+	size_t frames_n;
+	size_t frames_cap;
+	bool enabled;
+	bool err;
+};
+
+/************************************************************************************************************/
+/* CONSTRUCTORS / DESTRUCTORS *******************************************************************************/
+/************************************************************************************************************/
+
+void
+profile_init(struct profile *profile)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+profile_free(struct profile *profile)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/************************************************************************************************************/
+/* PROCEDURES ***********************************************************************************************/
+/************************************************************************************************************/
+
+void
+profile_clear(struct profile *profile)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Attributes one substitution to the sequence being parsed.
+ */
+void
+profile_count(struct profile *profile)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Starts timing a sequence read from the given file and line, on top of the sequence being parsed.
+ */
+void
+profile_enter(struct profile *profile, const char *path, size_t line)
+CCFG_NONNULL(1, 2)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Stops timing the sequence started by the last call to profile_enter().
+ */
+void
+profile_leave(struct profile *profile)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/************************************************************************************************************/
+/* FUNCTIONS ************************************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * Writes the profile into a file, in the given format. Returns false if the file could not be written, or
+ * if the profile is incomplete because memory ran out while it was gathered.
+ */
+bool
+profile_save(const struct profile *profile, const char *path, enum ccfg_profile_format format)
+CCFG_NONNULL(1, 2)
+CCFG_HIDDEN;
@@ -0,0 +1,314 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#include <cassette/ccfg.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+	#include <emmintrin.h>
+#endif
+
+#if defined(__ARM_NEON)
+	#include <arm_neon.h>
+#endif
+
+#if defined(__GNUC__) && defined(__x86_64__)
+	#include <immintrin.h>
+	#define SCAN_AVX2
+#endif
+
+#include "scan.h"
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#define CLASS_BLANK 1
+#define CLASS_STOP  2
+
+#define ALIGNED(PTR, N) (((uintptr_t)(PTR) & ((N) - 1)) == 0)
+
+/* the vector kernels load whole aligned blocks, which may extend past the terminating null character of   */
+/* the string. An aligned block never crosses a page boundary, so the bytes past the end are mapped and    */
+/* only compared against, the same way libc string functions read them. Heap buffers are not padded to a   */
+/* vector width though, so address sanitizer instrumentation is kept out of these kernels.                 */
+
+#if defined(__GNUC__)
+	#define NO_SANITIZE_ADDRESS __attribute__((no_sanitize_address))
+#else
+	#define NO_SANITIZE_ADDRESS
+#endif
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+static void   select_impl (void);
+static size_t word_scalar (const char *) CCFG_NONNULL(1);
+
+#if defined(__SSE2__)
+static size_t word_sse2   (const char *) CCFG_NONNULL(1) NO_SANITIZE_ADDRESS;
+#endif
+
+#if defined(__ARM_NEON)
+static size_t word_neon   (const char *) CCFG_NONNULL(1) NO_SANITIZE_ADDRESS;
+#endif
+
+#if defined(SCAN_AVX2)
+static size_t word_avx2   (const char *) CCFG_NONNULL(1) NO_SANITIZE_ADDRESS __attribute__((target("avx2")));
+#endif
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+/* characters that end a run of plain word characters, blanks also separate words */
+
+static const uint8_t classes[256] =
+{
+	['\0'] = CLASS_STOP,
+	['\t'] = CLASS_STOP | CLASS_BLANK,
+	['\n'] = CLASS_STOP,
+	['\v'] = CLASS_STOP | CLASS_BLANK,
+	[' ']  = CLASS_STOP | CLASS_BLANK,
+	['"']  = CLASS_STOP,
+	['\''] = CLASS_STOP,
+	['(']  = CLASS_STOP | CLASS_BLANK,
+	[')']  = CLASS_STOP | CLASS_BLANK,
+};
+
+/* widest implementation the CPU supports, picked on first use */
+
+static pthread_once_t impl_once = PTHREAD_ONCE_INIT;
+static size_t (*impl)(const char *) = word_scalar;
+
+/************************************************************************************************************/
+/* PRIVATE **************************************************************************************************/
+/************************************************************************************************************/
+
+size_t
+scan_blanks(const char *str)
+{
+	size_t n = 0;
+
+	while (classes[(unsigned char)str[n]] & CLASS_BLANK)
+	{
+		n++;
+	}
+
+	return n;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+const char *
+scan_eol(const char *str)
+{
+	/* single character reject sets are vectorized by the C library */
+
+	return str + strcspn(str, "\n");
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+size_t
+scan_word(const char *str)
+{
+	pthread_once(&impl_once, select_impl);
+
+	return impl(str);
+}
+
+/************************************************************************************************************/
+/* STATIC ***************************************************************************************************/
+/************************************************************************************************************/
+
+static void
+select_impl(void)
+{
+#if defined(__SSE2__)
+	impl = word_sse2;
+#endif
+
+#if defined(__ARM_NEON)
+	impl = word_neon;
+#endif
+
+#if defined(SCAN_AVX2)
+	if (__builtin_cpu_supports("avx2"))
+	{
+		impl = word_avx2;
+	}
+#endif
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+#if defined(SCAN_AVX2)
+
+static size_t
+word_avx2(const char *str)
+{
+	const char *c = str;
+	__m256i v;
+	__m256i m;
+	uint32_t mask;
+
+	/* vector loads are aligned so that they never cross into a page the string does not reach */
+
+	for (; !ALIGNED(c, 32); c++)
+	{
+		if (classes[(unsigned char)*c] & CLASS_STOP)
+		{
+			return c - str;
+		}
+	}
+
+	for (;; c += 32)
+	{
+		v = _mm256_load_si256((const __m256i*)c);
+		m = _mm256_or_si256(
+			_mm256_or_si256(
+				_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\0')),
+				                _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+				_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')),
+				                _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\v')))),
+			_mm256_or_si256(
+				_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+				                _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"'))),
+				_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\'')),
+				                _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('(')),
+				                                _mm256_cmpeq_epi8(v, _mm256_set1_epi8(')'))))));
+		if ((mask = _mm256_movemask_epi8(m)))
+		{
+			return c - str + __builtin_ctz(mask);
+		}
+	}
+}
+
+#endif
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+#if defined(__ARM_NEON)
+
+static size_t
+word_neon(const char *str)
+{
+	const char *c = str;
+	uint8x16_t v;
+	uint8x16_t m;
+	uint64_t mask;
+
+	/* vector loads are aligned so that they never cross into a page the string does not reach */
+
+	for (; !ALIGNED(c, 16); c++)
+	{
+		if (classes[(unsigned char)*c] & CLASS_STOP)
+		{
+			return c - str;
+		}
+	}
+
+	for (;; c += 16)
+	{
+		v = vld1q_u8((const uint8_t*)c);
+		m = vorrq_u8(
+			vorrq_u8(
+				vorrq_u8(vceqq_u8(v, vdupq_n_u8('\0')), vceqq_u8(v, vdupq_n_u8('\t'))),
+				vorrq_u8(vceqq_u8(v, vdupq_n_u8('\n')), vceqq_u8(v, vdupq_n_u8('\v')))),
+			vorrq_u8(
+				vorrq_u8(vceqq_u8(v, vdupq_n_u8(' ')),  vceqq_u8(v, vdupq_n_u8('"'))),
+				vorrq_u8(vceqq_u8(v, vdupq_n_u8('\'')),
+				         vorrq_u8(vceqq_u8(v, vdupq_n_u8('(')), vceqq_u8(v, vdupq_n_u8(')'))))));
+
+		/* narrow each byte of the comparison into 4 bits to get a scalar mask */
+
+		mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(m), 4)), 0);
+		if (mask)
+		{
+			return c - str + __builtin_ctzll(mask) / 4;
+		}
+	}
+}
+
+#endif
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static size_t
+word_scalar(const char *str)
+{
+	size_t n = 0;
+
+	while (!(classes[(unsigned char)str[n]] & CLASS_STOP))
+	{
+		n++;
+	}
+
+	return n;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+#if defined(__SSE2__)
+
+static size_t
+word_sse2(const char *str)
+{
+	const char *c = str;
+	__m128i v;
+	__m128i m;
+	uint32_t mask;
+
+	/* vector loads are aligned so that they never cross into a page the string does not reach */
+
+	for (; !ALIGNED(c, 16); c++)
+	{
+		if (classes[(unsigned char)*c] & CLASS_STOP)
+		{
+			return c - str;
+		}
+	}
+
+	for (;; c += 16)
+	{
+		v = _mm_load_si128((const __m128i*)c);
+		m = _mm_or_si128(
+			_mm_or_si128(
+				_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\0')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+				_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\v')))),
+			_mm_or_si128(
+				_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),  _mm_cmpeq_epi8(v, _mm_set1_epi8('"'))),
+				_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\'')),
+				             _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('(')),
+				                          _mm_cmpeq_epi8(v, _mm_set1_epi8(')'))))));
+		if ((mask = _mm_movemask_epi8(m)))
+		{
+			return c - str + __builtin_ctz(mask);
+		}
+	}
+}
+
+#endif
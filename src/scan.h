@@ -0,0 +1,59 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+#pragma once
+
+#include <cassette/ccfg.h>
+#include <stdlib.h>
+
+/************************************************************************************************************/
+/* FUNCTIONS ************************************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * Counts the characters that separate words (spaces, tabs, parentheses) at the start of str.
+ */
+size_t
+scan_blanks(const char *str)
+CCFG_NONNULL(1)
+CCFG_HIDDEN
+CCFG_PURE;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Finds the first newline or the terminating null character of str.
+ */
+const char *
+scan_eol(const char *str)
+CCFG_NONNULL_RETURN
+CCFG_NONNULL(1)
+CCFG_HIDDEN
+CCFG_PURE;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Counts the characters at the start of str that can be copied into a word as they are, that is, anything
+ * else than a separator, a quote, a newline or the terminating null character.
+ */
+size_t
+scan_word(const char *str)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
@@ -20,12 +20,24 @@
 
 #include <cassette/ccfg.h>
 #include <cassette/cobj.h>
+#include <limits.h>
+#include <math.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 
+#include "cache.h"
 #include "context.h"
+#include "lazy.h"
+#include "loop.h"
+#include "numbers.h"
+#include "profile.h"
 #include "sequence.h"
 #include "source.h"
+#include "stats.h"
+#include "substitution.h"
+#include "taint.h"
 #include "util.h"
 
 /************************************************************************************************************/
@@ -38,7 +50,7 @@ static void combine_var      (struct context *, enum token)   CCFG_NONNULL(1);
 static void declare_enum     (struct context *)               CCFG_NONNULL(1);
 static void declare_resource (struct context *, const char *) CCFG_NONNULL(1);
 static void declare_variable (struct context *)               CCFG_NONNULL(1);
-static void include          (struct context *)               CCFG_NONNULL(1);
+static void include          (struct context *, bool)         CCFG_NONNULL(1);
 static void iterate          (struct context *)               CCFG_NONNULL(1);
 static void print            (struct context *)               CCFG_NONNULL(1);
 static void restrict_mode    (struct context *)               CCFG_NONNULL(1);
@@ -49,8 +61,13 @@ static void seed             (struct context *)               CCFG_NONNULL(1);
 
 /* iteration sequence preprocessing */
 
-static void   preproc_iter_new  (struct context *, bool *)         CCFG_NONNULL(1);
-static size_t preproc_iter_nest (struct context *, size_t, bool *) CCFG_NONNULL(1);
+static void preproc_iter (struct context *, bool *) CCFG_NONNULL(1);
+
+/* lazy evaluation */
+
+static bool defer_values   (struct context *, size_t *, bool *) CCFG_NONNULL(1, 2, 3);
+static void defer_word     (struct context *, const char *)     CCFG_NONNULL(1, 2);
+static bool is_deferrable  (const struct context *)             CCFG_NONNULL(1) CCFG_PURE;
 
 /************************************************************************************************************/
 /* PRIVATE **************************************************************************************************/
@@ -60,7 +77,8 @@ void
 sequence_parse(struct context *ctx)
 {
 	enum token type;
-	char token[TOKEN_MAX_LEN];
+	struct token_view token;
+	uint64_t taint_mask = 0;
 
 	if (ctx->depth >= CONTEXT_MAX_DEPTH)
 	{
@@ -69,7 +87,19 @@ sequence_parse(struct context *ctx)
 	
 	ctx->depth++;
 
-	if ((type = context_get_token(ctx, token, NULL)) != TOKEN_SECTION_BEGIN && ctx->skip_sequences)
+	if (ctx->profile)
+	{
+		profile_enter(ctx->profile, ctx->file_path, context_line(ctx));
+	}
+
+	if (ctx->taint)
+	{
+		taint_mask = taint_enter(ctx->taint);
+	}
+
+	token_view_init(&token);
+
+	if ((type = context_get_token(ctx, &token, NULL)) != TOKEN_SECTION_BEGIN && ctx->skip_sequences)
 	{
 		type = TOKEN_INVALID;
 	}
@@ -103,7 +133,11 @@ sequence_parse(struct context *ctx)
 			break;
 
 		case TOKEN_INCLUDE:
-			include(ctx);
+			include(ctx, false);
+			break;
+
+		case TOKEN_INCLUDE_PARALLEL:
+			include(ctx, true);
 			break;
 
 		case TOKEN_FOR_BEGIN:
@@ -127,16 +161,101 @@ sequence_parse(struct context *ctx)
 
 		case TOKEN_STRING:
 		case TOKEN_NUMBER:
+		case TOKEN_COLOR:
 		default:
-			declare_resource(ctx, token);
+			declare_resource(ctx, token.chars);
 			break;
 	}
 
 	context_goto_eol(ctx);
 
+	token_view_free(&token);
+
+	if (ctx->taint)
+	{
+		taint_leave(ctx->taint, taint_mask);
+	}
+
+	if (ctx->profile)
+	{
+		profile_leave(ctx->profile);
+	}
+
 	ctx->depth--;
 }
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+size_t
+sequence_parse_values(struct context *ctx)
+{
+	enum token type;
+	struct token_view value;
+	double d;
+	size_t n = 0;
+
+	token_view_init(&value);
+
+	/* math results are kept as they were computed, and only formatted for their string representation */
+
+	cbook_prepare_new_group(ctx->sequences);
+	while ((type = context_get_token(ctx, &value, &d)) != TOKEN_INVALID)
+	{
+		switch (type)
+		{
+			case TOKEN_NUMBER:
+			case TOKEN_COLOR:
+				substitution_format(ctx, &value, type, d);
+				numbers_push(ctx->numbers, d);
+				break;
+
+			default:
+				numbers_push_str(ctx->numbers, value.chars);
+				break;
+		}
+		cbook_write(ctx->sequences, value.chars);
+		n++;
+	}
+
+	if (n == 0)
+	{
+		cbook_undo_new_group(ctx->sequences);
+	}
+
+	token_view_free(&value);
+
+	return n;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+size_t
+sequence_parse_variable(struct context *ctx)
+{
+	struct token_view value;
+	size_t n = 0;
+
+	token_view_init(&value);
+
+	/* values injected from the variable book have to be copied first */
+
+	cbook_prepare_new_group(ctx->vars);
+	while (context_get_token(ctx, &value, NULL) != TOKEN_INVALID && token_view_own(&value))
+	{
+		cbook_write(ctx->vars, value.chars);
+		n++;
+	}
+
+	if (n == 0)
+	{
+		cbook_undo_new_group(ctx->vars);
+	}
+
+	token_view_free(&value);
+
+	return n;
+}
+
 /************************************************************************************************************/
 /* STATIC ***************************************************************************************************/
 /************************************************************************************************************/
@@ -144,10 +263,10 @@ sequence_parse(struct context *ctx)
 static void
 combine_var(struct context *ctx, enum token type)
 {
-	cstr *val;
-	char name[TOKEN_MAX_LEN];
-	char token_1[TOKEN_MAX_LEN];
-	char token_2[TOKEN_MAX_LEN];
+	cstr *val = ctx->scratch;
+	struct token_view name;
+	struct token_view token_1;
+	struct token_view token_2;
 	size_t i;
 	size_t j;
 
@@ -156,17 +275,32 @@ combine_var(struct context *ctx, enum token type)
 		return;
 	}
 
-	val = cstr_create();
+	token_view_init(&name);
+	token_view_init(&token_1);
+	token_view_init(&token_2);
 
-	/* get params */
+	/* get params, those still in use once the variable book is written to cannot be borrowed from it */
 
-	if (context_get_token(ctx, name,    NULL) == TOKEN_INVALID
-	 || context_get_token(ctx, token_1, NULL) == TOKEN_INVALID
-	 || context_get_token(ctx, token_2, NULL) == TOKEN_INVALID
-	 || !cdict_find(ctx->keys_vars, token_1, CONTEXT_DICT_VARIABLE, &i)
-	 || (type == TOKEN_VAR_MERGE && !cdict_find(ctx->keys_vars, token_2, CONTEXT_DICT_VARIABLE, &j)))
+	if (context_get_token(ctx, &name,    NULL) == TOKEN_INVALID
+	 || context_get_token(ctx, &token_1, NULL) == TOKEN_INVALID
+	 || context_get_token(ctx, &token_2, NULL) == TOKEN_INVALID
+	 || !token_view_own(&name)
+	 || !token_view_own(&token_2)
+	 || !cdict_find(ctx->keys_vars, token_1.chars, CONTEXT_DICT_VARIABLE, &i)
+	 || (type == TOKEN_VAR_MERGE && !cdict_find(ctx->keys_vars, token_2.chars, CONTEXT_DICT_VARIABLE, &j)))
 	{
-		return;
+		goto end;
+	}
+
+	/* combined values are not tracked, tainted ones make the load structural */
+
+	if (ctx->taint)
+	{
+		taint_use(ctx->taint, i);
+		if (type == TOKEN_VAR_MERGE)
+		{
+			taint_use(ctx->taint, j);
+		}
 	}
 
 	/* generate new values and write them into the variable book */
@@ -179,11 +313,11 @@ combine_var(struct context *ctx, enum token type)
 		switch (type)
 		{
 			case TOKEN_VAR_APPEND:
-				cstr_append(val, token_2);
+				cstr_append(val, token_2.chars);
 				break;
 
 			case TOKEN_VAR_PREPEND:
-				cstr_prepend(val, token_2);
+				cstr_prepend(val, token_2.chars);
 				break;
 
 			case TOKEN_VAR_MERGE:
@@ -199,9 +333,14 @@ combine_var(struct context *ctx, enum token type)
 
 	/* update variable's reference in the variable dict */
 
-	cdict_write(ctx->keys_vars, name, CONTEXT_DICT_VARIABLE, cbook_groups_number(ctx->vars) - 1);
+	cdict_write(ctx->keys_vars, name.chars, CONTEXT_DICT_VARIABLE, cbook_groups_number(ctx->vars) - 1);
+	cache_record(ctx, CACHE_VARIABLE, "", name.chars, ctx->vars, cbook_groups_number(ctx->vars) - 1);
 
-	cstr_destroy(val);
+end:
+
+	token_view_free(&name);
+	token_view_free(&token_1);
+	token_view_free(&token_2);
 }
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
@@ -209,8 +348,8 @@ combine_var(struct context *ctx, enum token type)
 static void
 declare_enum(struct context *ctx)
 {
-	char name[TOKEN_MAX_LEN];
-	char token[TOKEN_MAX_LEN];
+	struct token_view name;
+	struct token_view token;
 	double min;
 	double max;
 	double steps;
@@ -223,19 +362,22 @@ declare_enum(struct context *ctx)
 		return;
 	}
 
+	token_view_init(&name);
+	token_view_init(&token);
+
 	/* get enum name and params, set defaults on missing params */
 
-	n += context_get_token        (ctx, name,  NULL)       != TOKEN_INVALID ? 1 : 0;
-	n += context_get_token_numeral(ctx, token, &min)       != TOKEN_INVALID ? 1 : 0;
-	n += context_get_token_numeral(ctx, token, &max)       != TOKEN_INVALID ? 1 : 0;
-	n += context_get_token_numeral(ctx, token, &steps)     != TOKEN_INVALID ? 1 : 0;
-	n += context_get_token_numeral(ctx, token, &precision) != TOKEN_INVALID ? 1 : 0;
+	n += context_get_token        (ctx, &name,  NULL)       != TOKEN_INVALID ? 1 : 0;
+	n += context_get_token_numeral(ctx, &token, &min)       != TOKEN_INVALID ? 1 : 0;
+	n += context_get_token_numeral(ctx, &token, &max)       != TOKEN_INVALID ? 1 : 0;
+	n += context_get_token_numeral(ctx, &token, &steps)     != TOKEN_INVALID ? 1 : 0;
+	n += context_get_token_numeral(ctx, &token, &precision) != TOKEN_INVALID ? 1 : 0;
 
 	switch (n)
 	{
 		case 0:
 		case 1:
-			return;
+			goto end;
 
 		case 2:
 			max = min;
@@ -254,9 +396,9 @@ declare_enum(struct context *ctx)
 			break;
 	}
 
-	if (steps < 1.0 || steps >= SIZE_MAX || precision < 0.0)
+	if (steps < 1.0 || steps >= SIZE_MAX || precision < 0.0 || !token_view_own(&name))
 	{
-		return;
+		goto end;
 	}
 
 	if (precision > 16.0)
@@ -270,13 +412,19 @@ declare_enum(struct context *ctx)
 	for (size_t i = 0; i <= steps; i++)
 	{
 		ratio = util_interpolate(min, max, i / steps);
-		snprintf(token, TOKEN_MAX_LEN, "%.*f", (int)precision, ratio);
-		cbook_write(ctx->vars, token);
+		token_view_printf(&token, "%.*f", (int)precision, ratio);
+		cbook_write(ctx->vars, token.chars);
 	}
 
 	/* update variable's reference in the variable dict */
 
-	cdict_write(ctx->keys_vars, name, CONTEXT_DICT_VARIABLE, cbook_groups_number(ctx->vars) - 1);	
+	cdict_write(ctx->keys_vars, name.chars, CONTEXT_DICT_VARIABLE, cbook_groups_number(ctx->vars) - 1);
+	cache_record(ctx, CACHE_VARIABLE, "", name.chars, ctx->vars, cbook_groups_number(ctx->vars) - 1);
+
+end:
+
+	token_view_free(&name);
+	token_view_free(&token);
 }
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
@@ -284,31 +432,57 @@ declare_enum(struct context *ctx)
 static void
 declare_resource(struct context *ctx, const char *namespace)
 {
-	char name[TOKEN_MAX_LEN];
-	char value[TOKEN_MAX_LEN];
+	struct token_view name;
+	size_t previous = SIZE_MAX;
 	size_t i;
 	size_t n = 0;
+	bool deferred = false;
+
+	token_view_init(&name);
+
+	/* filtered out namespaces are skipped before any of their values get evaluated */
+
+	if (ctx->keys_filters && !cdict_find(ctx->keys_filters, namespace, 0, NULL))
+	{
+		goto end;
+	}
 
 	/* get resource's name */
 
-	if (context_get_token(ctx, name, NULL) == TOKEN_INVALID)
+	if (context_get_token(ctx, &name, NULL) == TOKEN_INVALID)
 	{
-		return;
+		goto end;
 	}
 
-	/* write resource's values into the sequence book */
+	/* write resource's values into the sequence book, or aside as raw words in lazy mode */
 
-	cbook_prepare_new_group(ctx->sequences);
-	while (context_get_token(ctx, value, NULL) != TOKEN_INVALID)
+	if (ctx->taint)
 	{
-		cbook_write(ctx->sequences, value);
-		n++;
+		taint_start(ctx->taint);
+	}
+
+	if (!is_deferrable(ctx) || !defer_values(ctx, &n, &deferred))
+	{
+		n = sequence_parse_values(ctx);
+	}
+
+	if (ctx->taint)
+	{
+		taint_stop(ctx->taint, NULL, n > 0 ? cbook_groups_number(ctx->sequences) - 1 : SIZE_MAX, ctx->depth);
 	}
 
 	if (n == 0)
 	{
-		cbook_undo_new_group(ctx->sequences);
-		return;
+		goto end;
+	}
+
+	/* deferred values only get a placeholder */
+
+	if (deferred)
+	{
+		cbook_prepare_new_group(ctx->sequences);
+		cbook_write(ctx->sequences, "");
+		numbers_push(ctx->numbers, NAN);
 	}
 
 	/* find namespace reference in sequence dict. if not found, create it */
@@ -319,88 +493,252 @@ declare_resource(struct context *ctx, const char *namespace)
 		cdict_write(ctx->keys_sequences, namespace, 0, i);
 	}
 
+	/* deferred values may fall back to the definition they replace if they turn out empty */
+
+	if (deferred)
+	{
+		cdict_find(ctx->keys_sequences, name.chars, i, &previous);
+		lazy_push(ctx->lazy, cbook_groups_number(ctx->sequences) - 1, previous, ctx->depth);
+	}
+
 	/* update sequence's reference in the sequence dict         */
 	/* use the namespace's dict value as sequence group (i > 0) */
 
-	cdict_write(ctx->keys_sequences, name, i, cbook_groups_number(ctx->sequences) - 1);
+	cdict_write(ctx->keys_sequences, name.chars, i, cbook_groups_number(ctx->sequences) - 1);
+
+	/* keep the names along, in a group of the same index, so the resource can be frozen later on */
+
+	cbook_prepare_new_group(ctx->names);
+	cbook_write(ctx->names, namespace);
+	cbook_write(ctx->names, name.chars);
+
+	cache_record(ctx, CACHE_RESOURCE, namespace, name.chars, ctx->sequences, cbook_groups_number(ctx->sequences) - 1);
+
+end:
+
+	token_view_free(&name);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static bool
+defer_values(struct context *ctx, size_t *n, bool *deferred)
+{
+	struct context_position position;
+	struct token_view value;
+	enum token type;
+	size_t group;
+	bool ok = true;
+
+	token_view_init(&value);
+
+	context_tell(ctx, &position);
+
+	/* words are written as values for as long as none of them needs evaluating, they are then moved aside */
+	/* with the rest of the sequence                                                                       */
+
+	cbook_prepare_new_group(ctx->sequences);
+	while ((type = context_get_token_deferred(ctx, &value)) != TOKEN_INVALID)
+	{
+		switch (type)
+		{
+			case TOKEN_STRING:
+				break;
+
+			/* the outcome depends on when the sequence is evaluated, or the name of an injection does */
+
+			case TOKEN_EOF:
+			case TOKEN_TIMESTAMP:
+			case TOKEN_OP_RANDOM:
+			case TOKEN_VAR_INJECTION:
+			case TOKEN_ITER_INJECTION:
+			case TOKEN_PARAM_INJECTION:
+				ok = false;
+				goto end;
+
+			default:
+				if (!*deferred)
+				{
+					cbook_prepare_new_group(ctx->lazy->words);
+					group = cbook_groups_number(ctx->sequences) - 1;
+					for (size_t k = 0; k < *n; k++)
+					{
+						defer_word(ctx, cbook_word_in_group(ctx->sequences, group, k));
+					}
+					cbook_undo_new_group(ctx->sequences);
+					*deferred = true;
+				}
+				cbook_write(ctx->lazy->words, value.chars);
+				(*n)++;
+				continue;
+		}
+
+		if (*deferred)
+		{
+			defer_word(ctx, value.chars);
+		}
+		else
+		{
+			cbook_write(ctx->sequences, value.chars);
+		}
+		(*n)++;
+	}
+
+	/* the sequence turned out to hold plain strings only, they are written as they would have been */
+
+	if (!*deferred)
+	{
+		group = cbook_groups_number(ctx->sequences) - 1;
+		for (size_t k = 0; k < *n; k++)
+		{
+			numbers_push_str(ctx->numbers, cbook_word_in_group(ctx->sequences, group, k));
+		}
+	}
+
+end:
+
+	if (!ok)
+	{
+		cbook_undo_new_group(*deferred ? ctx->lazy->words : ctx->sequences);
+		context_seek(ctx, &position);
+		*deferred = false;
+		*n        = 0;
+	}
+	else if (*n == 0)
+	{
+		cbook_undo_new_group(ctx->sequences);
+	}
+
+	token_view_free(&value);
+
+	return ok;
 }
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 
+static void
+defer_word(struct context *ctx, const char *word)
+{
+	/* strings that would be read as tokens once evaluated are escaped */
+
+	STATS_ADD(ctx->stats, matches, 1);
+
+	if (token_match(word) != TOKEN_STRING)
+	{
+		cbook_write(ctx->lazy->words, "\\");
+	}
+
+	cbook_write(ctx->lazy->words, word);
+}
+
 static void
 declare_variable(struct context *ctx)
 {
-	char name[TOKEN_MAX_LEN];
-	char value[TOKEN_MAX_LEN];
-	size_t n = 0;
+	struct token_view name;
+	size_t n;
 
 	if (ctx->restricted)
 	{
 		return;
 	}
 
+	token_view_init(&name);
+
 	/* get variable's name */
 
-	if (context_get_token(ctx, name, NULL) == TOKEN_INVALID)
+	if (context_get_token(ctx, &name, NULL) == TOKEN_INVALID || !token_view_own(&name))
 	{
-		return;
+		goto end;
 	}
 
 	/* write variable's values into the variable book */
 
-	cbook_prepare_new_group(ctx->vars);
-	while (context_get_token(ctx, value, NULL) != TOKEN_INVALID)
+	if (ctx->taint)
 	{
-		cbook_write(ctx->vars, value);
-		n++;
+		taint_start(ctx->taint);
+	}
+
+	n = sequence_parse_variable(ctx);
+
+	if (ctx->taint)
+	{
+		taint_stop(ctx->taint, ctx->vars, n > 0 ? cbook_groups_number(ctx->vars) - 1 : SIZE_MAX, ctx->depth);
 	}
 
 	if (n == 0)
 	{
-		cbook_undo_new_group(ctx->vars);
-		return;
+		goto end;
 	}
 
 	/* update variable's reference in the variable dict */
 
-	cdict_write(ctx->keys_vars, name, CONTEXT_DICT_VARIABLE, cbook_groups_number(ctx->vars) - 1);
+	cdict_write(ctx->keys_vars, name.chars, CONTEXT_DICT_VARIABLE, cbook_groups_number(ctx->vars) - 1);
+	cache_record(ctx, CACHE_VARIABLE, "", name.chars, ctx->vars, cbook_groups_number(ctx->vars) - 1);
+
+end:
+
+	token_view_free(&name);
 }
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 
 static void
-include(struct context *ctx)
+include(struct context *ctx, bool parallel)
 {
-	char token[TOKEN_MAX_LEN];
-	cstr *filename;
+	struct token_view token;
+	char filename[PATH_MAX];
+	cbook *paths = NULL;
 
 	if (ctx->restricted || ctx->file_inode == 0)
 	{
 		return;
 	}
 
-	filename = cstr_create();
+	token_view_init(&token);
+
+	/* children can include files too, so the path is built on the stack rather than in the scratch string */
+	/* for the same reason, absolute paths are copied out of the variable book children may write to       */
+	/* parallel children are only parsed once all of their paths are known                                */
+
+	if (parallel && ctx->pool)
+	{
+		paths = cbook_create();
+	}
 
-	while (context_get_token(ctx, token, NULL) != TOKEN_INVALID)
+	while (context_get_token(ctx, &token, NULL) != TOKEN_INVALID)
 	{
-		if (token[0] != '/')
+		if (token.chars[0] != '/')
 		{
-			if (ctx->buffer)
+			if (!ctx->buffer || snprintf(filename, PATH_MAX, "%s/%s", ctx->file_dir, token.chars) >= PATH_MAX)
 			{
-				cstr_clear(filename);
-				cstr_append(filename, ctx->file_dir);
-				cstr_append(filename, "/");
-				cstr_append(filename, token);
-				source_parse_child(ctx, cstr_chars(filename));
+				continue;
+			}
+			if (paths)
+			{
+				cbook_write(paths, filename);
+			}
+			else
+			{
+				source_parse_child(ctx, filename);
 			}
 		}
-		else
+		else if (paths)
+		{
+			cbook_write(paths, token.chars);
+		}
+		else if (token_view_own(&token))
 		{	
-			source_parse_child(ctx, token);
+			source_parse_child(ctx, token.chars);
 		}
 	}
 
-	cstr_destroy(filename);
+	if (paths)
+	{
+		source_parse_children(ctx, paths);
+		cbook_destroy(paths);
+	}
+
+	token_view_free(&token);
 }
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
@@ -408,8 +746,8 @@ include(struct context *ctx)
 static void
 iterate(struct context *ctx)
 {
-	char name[TOKEN_MAX_LEN];
-	char token[TOKEN_MAX_LEN];
+	struct token_view name;
+	struct token_view token;
 	size_t group_start;
 	size_t group_end;
 	size_t i;
@@ -422,22 +760,33 @@ iterate(struct context *ctx)
 		return;
 	}
 
-	/* get iteration params and detect if it's nested */
+	token_view_init(&name);
+	token_view_init(&token);
 
-	if (context_get_token(ctx, token,  NULL) == TOKEN_INVALID
-	 || !cdict_find(ctx->keys_vars, token, CONTEXT_DICT_VARIABLE, &i))
+	/* get iteration params and detect if it's nested                                        */
+	/* the iterator's name is kept while sequences write variables, so it cannot be borrowed */
+
+	if (context_get_token(ctx, &token, NULL) == TOKEN_INVALID
+	 || !cdict_find(ctx->keys_vars, token.chars, CONTEXT_DICT_VARIABLE, &i))
 	{
-		return;
+		goto end;
 	}
 
-	if (context_get_token(ctx, name, NULL) == TOKEN_INVALID)
+	if (context_get_token(ctx, &name, NULL) == TOKEN_INVALID)
 	{
-		snprintf(name, TOKEN_MAX_LEN, "%s", token);
+		token_view_borrow(&name, token.chars);
 	}
 	
-	if (cdict_find(ctx->keys_vars, name, CONTEXT_DICT_ITERATION, &j))
+	if (!token_view_own(&name) || cdict_find(ctx->keys_vars, name.chars, CONTEXT_DICT_ITERATION, &j))
 	{
-		return;
+		goto end;
+	}
+
+	/* the number of iterations cannot depend on params */
+
+	if (ctx->taint)
+	{
+		taint_use(ctx->taint, i);
 	}
 
 	nested = cbook_length(ctx->iteration);
@@ -449,13 +798,15 @@ iterate(struct context *ctx)
 	if (nested)
 	{
 		group_start = ctx->it_group + 1;
-		group_end   = preproc_iter_nest(ctx, group_start, &fail);
+		group_end   = loop_block_end(ctx->loop, ctx->it_group);
+		fail        = group_end == SIZE_MAX;
 	}
 	else
 	{
-		preproc_iter_new(ctx, &fail);
+		preproc_iter(ctx, &fail);
 		group_start = 0;
 		group_end   = cbook_groups_number(ctx->iteration);
+		STATS_PEAK(ctx->stats, peak_iteration, cbook_words_number(ctx->iteration));
 	}
 
 	if (fail)
@@ -467,7 +818,8 @@ iterate(struct context *ctx)
 
 	for (size_t k = 0; k < cbook_group_length(ctx->vars, i); k++)
 	{
-		cdict_write(ctx->keys_vars, name, CONTEXT_DICT_ITERATION, cbook_word_index(ctx->vars, i, k));
+		STATS_ADD(ctx->stats, iterations, 1);
+		cdict_write(ctx->keys_vars, name.chars, CONTEXT_DICT_ITERATION, cbook_word_index(ctx->vars, i, k));
 		for (ctx->it_group = group_start; ctx->it_group < group_end; ctx->it_group++)
 		{
 			ctx->it_i = 0;
@@ -477,75 +829,61 @@ iterate(struct context *ctx)
 
 	/* restore iterator state */
 
-	cdict_erase(ctx->keys_vars, name, CONTEXT_DICT_ITERATION);
+	cdict_erase(ctx->keys_vars, name.chars, CONTEXT_DICT_ITERATION);
 
 skip:
 
 	if (!nested)
 	{
 		cbook_clear(ctx->iteration);
+		loop_clear(ctx->loop);
 	}
+
+end:
+
+	token_view_free(&name);
+	token_view_free(&token);
 }
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 
-static size_t
-preproc_iter_nest(struct context *ctx, size_t start_group, bool *fail)
+static bool
+is_deferrable(const struct context *ctx)
 {
-	char token[TOKEN_MAX_LEN];
-	size_t n = 0;
-	size_t i;
-
-	for (i = start_group; i < cbook_groups_number(ctx->iteration); i++)
-	{
-		ctx->it_group = i;
-		ctx->it_i     = 0;
-		context_get_token_raw(ctx, token);
-
-		/* look for matching TOKEN_FOR_END */
-
-		switch (token_match(ctx->tokens, token))
-		{
-			case TOKEN_FOR_BEGIN:
-				n++;
-				break;
-
-			case TOKEN_FOR_END:
-				if (n == 0)
-				{
-					return i;
-				}
-				n--;
-				break;
+	/* children recorded into the cache are written out as is, since their output gets replayed as is, */
+	/* and so are tracked values, since the words they were evaluated from get written down instead     */
 
-			default:
-				break;
-		}
-	}
-
-	*fail = true;
-
-	return i;
+	return ctx->lazy
+	    && !ctx->restricted
+	    && !ctx->taint
+	    && !(ctx->cache && ctx->cache->recording > 0);
 }
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 
 static void
-preproc_iter_new(struct context *ctx, bool *fail)
+preproc_iter(struct context *ctx, bool *fail)
 {
-	char token[TOKEN_MAX_LEN];
+	enum token type;
+	struct token_view token;
+	size_t line = 0;
 	size_t n = 0;
 
+	token_view_init(&token);
+
 	context_goto_eol(ctx);
 
 	while (!ctx->eof_reached)
 	{
 		ctx->eol_reached = false;
-		context_get_token_raw(ctx, token);
+		line = ctx->profile ? context_line(ctx) : 0;
+		context_get_token_raw(ctx, &token);
 
 		/* look for matching TOKEN_FOR_END */
 
-		switch (token_match(ctx->tokens, token))
+		STATS_ADD(ctx->stats, matches, 1);
+
+		switch ((type = token_match(token.chars)))
 		{
 			case TOKEN_FOR_BEGIN:
 				n++;
@@ -555,7 +893,7 @@ preproc_iter_new(struct context *ctx, bool *fail)
 				if (n == 0)
 				{
 					context_goto_eol(ctx);
-					return;
+					goto end;
 				}
 				n--;
 				break;
@@ -568,17 +906,29 @@ preproc_iter_new(struct context *ctx, bool *fail)
 				break;
 		}
 
-		/* write down sequences that will be iterated */
+		/* write down sequences that will be iterated, words are only matched against tokens once */
 
 		cbook_prepare_new_group(ctx->iteration);
-		cbook_write(ctx->iteration, token);
-		while (context_get_token_raw(ctx, token) != TOKEN_INVALID)
+		cbook_write(ctx->iteration, token.chars);
+		loop_push_group(ctx->loop, type, line);
+		loop_push_word(ctx->loop, type);
+		while (context_get_token_raw(ctx, &token) != TOKEN_INVALID)
 		{
-			cbook_write(ctx->iteration, token);
+			cbook_write(ctx->iteration, token.chars);
+			loop_push_word(ctx->loop, token_match(token.chars));
+			STATS_ADD(ctx->stats, matches, 1);
 		}
 	}
 
 	*fail = true;
+
+end:
+
+	loop_seal(ctx->loop);
+
+	*fail = *fail || ctx->loop->err;
+
+	token_view_free(&token);
 }
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
@@ -586,19 +936,27 @@ preproc_iter_new(struct context *ctx, bool *fail)
 static void
 print(struct context *ctx)
 {
-	char token[TOKEN_MAX_LEN];
+	struct token_view token;
 	
 	if (ctx->restricted)
 	{
 		return;
 	}
 
-	while (context_get_token(ctx, token, NULL) != TOKEN_INVALID)
+	token_view_init(&token);
+
+	while (context_get_token(ctx, &token, NULL) != TOKEN_INVALID)
 	{
-		fprintf(stderr, "%s,\t", token);
+		fprintf(stderr, "%s,\t", token.chars);
 	}
 
+	token_view_free(&token);
+
 	fprintf(stderr, "\n");
+
+	/* output is a side effect, a file that prints has to be parsed again on every load */
+
+	cache_taint(ctx);
 }
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
@@ -614,17 +972,22 @@ restrict_mode(struct context *ctx)
 static void
 section_add(struct context *ctx)
 {
-	char token[TOKEN_MAX_LEN];
+	struct token_view token;
 
 	if (ctx->restricted)
 	{
 		return;
 	}
 
-	while (context_get_token(ctx, token, NULL) != TOKEN_INVALID)
+	token_view_init(&token);
+
+	while (context_get_token(ctx, &token, NULL) != TOKEN_INVALID)
 	{
-		cdict_write(ctx->keys_vars, token, CONTEXT_DICT_SECTION, 0);
+		cdict_write(ctx->keys_vars, token.chars, CONTEXT_DICT_SECTION, 0);
+		cache_record(ctx, CACHE_SECTION_ADD, "", token.chars, NULL, 0);
 	}
+
+	token_view_free(&token);
 }
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
@@ -632,23 +995,27 @@ section_add(struct context *ctx)
 static void
 section_begin(struct context *ctx)
 {
-	char token[TOKEN_MAX_LEN];
+	struct token_view token;
 
 	if (ctx->restricted)
 	{
 		return;
 	}
 
-	while (context_get_token(ctx, token, NULL) != TOKEN_INVALID)
+	token_view_init(&token);
+
+	ctx->skip_sequences = false;
+
+	while (context_get_token(ctx, &token, NULL) != TOKEN_INVALID)
 	{
-		if (!cdict_find(ctx->keys_vars, token, CONTEXT_DICT_SECTION, NULL))
+		if (!cdict_find(ctx->keys_vars, token.chars, CONTEXT_DICT_SECTION, NULL))
 		{
 			ctx->skip_sequences = true;
-			return;
+			break;
 		}
 	}
-	
-	ctx->skip_sequences = false;
+
+	token_view_free(&token);
 }
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
@@ -656,17 +1023,22 @@ section_begin(struct context *ctx)
 static void
 section_del(struct context *ctx)
 {
-	char token[TOKEN_MAX_LEN];
+	struct token_view token;
 
 	if (ctx->restricted)
 	{
 		return;
 	}
 
-	while (context_get_token(ctx, token, NULL) != TOKEN_INVALID)
+	token_view_init(&token);
+
+	while (context_get_token(ctx, &token, NULL) != TOKEN_INVALID)
 	{
-		cdict_erase(ctx->keys_vars, token, CONTEXT_DICT_SECTION);
+		cdict_erase(ctx->keys_vars, token.chars, CONTEXT_DICT_SECTION);
+		cache_record(ctx, CACHE_SECTION_DEL, "", token.chars, NULL, 0);
 	}
+
+	token_view_free(&token);
 }
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
@@ -674,7 +1046,7 @@ section_del(struct context *ctx)
 static void
 seed(struct context *ctx)
 {
-	char token[TOKEN_MAX_LEN];
+	struct token_view token;
 	double d;
 	
 	if (ctx->restricted)
@@ -682,8 +1054,12 @@ seed(struct context *ctx)
 		return;
 	}
 
-	if (context_get_token_numeral(ctx, token, &d) != TOKEN_INVALID)
+	token_view_init(&token);
+
+	if (context_get_token_numeral(ctx, &token, &d) != TOKEN_INVALID)
 	{
 		ctx->rand = crand_seed(d);
 	}
+
+	token_view_free(&token);
 }
@@ -30,3 +30,25 @@ void
 sequence_parse(struct context *ctx)
 CCFG_NONNULL(1)
 CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Evaluates the rest of the sequence as resource values, written into a new group of the sequence book, and
+ * returns how many were written. If there are none, no group is added.
+ */
+size_t
+sequence_parse_values(struct context *ctx)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Same as sequence_parse_values(), but the values are written into a new group of the variable book, as they
+ * are for a variable declaration, without their numerical form.
+ */
+size_t
+sequence_parse_variable(struct context *ctx)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
@@ -0,0 +1,78 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#include <cassette/ccfg.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "share.h"
+
+/************************************************************************************************************/
+/* PRIVATE **************************************************************************************************/
+/************************************************************************************************************/
+
+struct share *
+share_acquire(struct share *share)
+{
+	atomic_fetch_add_explicit(&share->refs, 1, memory_order_relaxed);
+
+	return share;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+struct share *
+share_create(void)
+{
+	struct share *share;
+
+	if (!(share = malloc(sizeof(struct share))))
+	{
+		return NULL;
+	}
+
+	atomic_init(&share->refs, 1);
+
+	return share;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+bool
+share_is_owned(struct share *share)
+{
+	return !share || atomic_load_explicit(&share->refs, memory_order_acquire) == 1;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+bool
+share_release(struct share *share)
+{
+	if (share && atomic_fetch_sub_explicit(&share->refs, 1, memory_order_acq_rel) > 1)
+	{
+		return false;
+	}
+
+	free(share);
+
+	return true;
+}
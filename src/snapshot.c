@@ -0,0 +1,302 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#include <cassette/ccfg.h>
+#include <cassette/cobj.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "main.h"
+#include "snapshot.h"
+#include "source.h"
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+static cbook *copy_sequences(const ccfg *) CCFG_NONNULL_RETURN CCFG_NONNULL(1);
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+ccfg_snapshot ccfg_snapshot_placeholder_instance =
+{
+	.sequences      = CBOOK_PLACEHOLDER,
+	.keys_sequences = CDICT_PLACEHOLDER,
+	.refs           = 0,
+};
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+ccfg_slot ccfg_slot_placeholder_instance =
+{
+	.snapshot   = CCFG_SNAPSHOT_PLACEHOLDER,
+	.readers    = {0, 0},
+	.epoch      = 0,
+	.publishing = ATOMIC_FLAG_INIT,
+};
+
+/************************************************************************************************************/
+/* PUBLIC ***************************************************************************************************/
+/************************************************************************************************************/
+
+bool
+ccfg_cursor_iterate(ccfg_cursor *cursor)
+{
+	if (cursor->it >= cbook_group_length(cursor->snapshot->sequences, cursor->group))
+	{
+		return false;
+	}
+
+	cursor->it++;
+
+	return true;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+const char *
+ccfg_cursor_resource(const ccfg_cursor *cursor)
+{
+	return cbook_word_in_group(cursor->snapshot->sequences, cursor->group, cursor->it - 1);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+size_t
+ccfg_cursor_resource_length(const ccfg_cursor *cursor)
+{
+	return cbook_group_length(cursor->snapshot->sequences, cursor->group);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+ccfg_snapshot *
+ccfg_slot_acquire(ccfg_slot *slot)
+{
+	ccfg_snapshot *snapshot;
+	size_t epoch;
+
+	if (slot == CCFG_SLOT_PLACEHOLDER)
+	{
+		return CCFG_SNAPSHOT_PLACEHOLDER;
+	}
+
+	epoch = atomic_load(&slot->epoch) & 1;
+
+	atomic_fetch_add(slot->readers + epoch, 1);
+	snapshot = ccfg_snapshot_acquire(atomic_load(&slot->snapshot));
+	atomic_fetch_sub(slot->readers + epoch, 1);
+
+	return snapshot;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+ccfg_slot *
+ccfg_slot_create(void)
+{
+	ccfg_slot *slot;
+
+	if (!(slot = malloc(sizeof(ccfg_slot))))
+	{
+		return CCFG_SLOT_PLACEHOLDER;
+	}
+
+	atomic_init(&slot->snapshot,   CCFG_SNAPSHOT_PLACEHOLDER);
+	atomic_init(slot->readers + 0, 0);
+	atomic_init(slot->readers + 1, 0);
+	atomic_init(&slot->epoch,      0);
+	atomic_flag_clear(&slot->publishing);
+
+	return slot;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+ccfg_slot_destroy(ccfg_slot *slot)
+{
+	if (slot == CCFG_SLOT_PLACEHOLDER)
+	{
+		return;
+	}
+
+	ccfg_snapshot_release(atomic_load(&slot->snapshot));
+
+	free(slot);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+ccfg_slot_publish(ccfg_slot *slot, ccfg_snapshot *snapshot)
+{
+	ccfg_snapshot *old;
+	size_t epoch;
+
+	if (slot == CCFG_SLOT_PLACEHOLDER)
+	{
+		return;
+	}
+
+	while (atomic_flag_test_and_set(&slot->publishing))
+	{
+		sched_yield();
+	}
+
+	/* readers that loaded the old pointer did so while announced on the current epoch's counter */
+
+	old   = atomic_exchange(&slot->snapshot, ccfg_snapshot_acquire(snapshot));
+	epoch = atomic_fetch_add(&slot->epoch, 1) & 1;
+
+	while (atomic_load(slot->readers + epoch) > 0)
+	{
+		sched_yield();
+	}
+
+	ccfg_snapshot_release(old);
+
+	atomic_flag_clear(&slot->publishing);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+ccfg_snapshot *
+ccfg_snapshot_acquire(ccfg_snapshot *snapshot)
+{
+	if (snapshot != CCFG_SNAPSHOT_PLACEHOLDER)
+	{
+		atomic_fetch_add_explicit(&snapshot->refs, 1, memory_order_relaxed);
+	}
+
+	return snapshot;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+ccfg_snapshot *
+ccfg_snapshot_create(ccfg *cfg)
+{
+	ccfg_snapshot *snapshot;
+
+	if (cfg->err)
+	{
+		return CCFG_SNAPSHOT_PLACEHOLDER;
+	}
+
+	/* snapshots only hold the sequence book, so deferred resources have to be evaluated into it */
+
+	source_settle(cfg);
+
+	if (cfg->err || !(snapshot = malloc(sizeof(ccfg_snapshot))))
+	{
+		return CCFG_SNAPSHOT_PLACEHOLDER;
+	}
+
+	snapshot->sequences      = copy_sequences(cfg);
+	snapshot->keys_sequences = cdict_clone(cfg->keys_sequences);
+
+	atomic_init(&snapshot->refs, 1);
+
+	if (cbook_error(snapshot->sequences) || cdict_error(snapshot->keys_sequences))
+	{
+		ccfg_snapshot_release(snapshot);
+		return CCFG_SNAPSHOT_PLACEHOLDER;
+	}
+
+	return snapshot;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+ccfg_snapshot_fetch(const ccfg_snapshot *snapshot, ccfg_cursor *cursor, const char *namespace,
+                    const char *property)
+{
+	size_t i;
+
+	cursor->snapshot = snapshot;
+	cursor->group    = SIZE_MAX;
+	cursor->it       = SIZE_MAX;
+
+	if (cdict_find(snapshot->keys_sequences, namespace, 0, &i)
+	 && cdict_find(snapshot->keys_sequences, property,  i, &cursor->group))
+	{
+		cursor->it = 0;
+	}
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+ccfg_snapshot_release(ccfg_snapshot *snapshot)
+{
+	if (snapshot == CCFG_SNAPSHOT_PLACEHOLDER
+	 || atomic_fetch_sub_explicit(&snapshot->refs, 1, memory_order_acq_rel) > 1)
+	{
+		return;
+	}
+
+	cbook_destroy(snapshot->sequences);
+	cdict_destroy(snapshot->keys_sequences);
+
+	free(snapshot);
+}
+
+/************************************************************************************************************/
+/* STATIC ***************************************************************************************************/
+/************************************************************************************************************/
+
+static cbook *
+copy_sequences(const ccfg *cfg)
+{
+	const cbook *src;
+	cbook *sequences;
+	size_t overlay;
+	size_t group;
+
+	if (cfg->taint.results_n == 0)
+	{
+		return cbook_clone(cfg->sequences);
+	}
+
+	/* a tenant's sequence book is shared, and the values its params changed are written in their place */
+
+	sequences = cbook_create();
+
+	for (size_t g = 0; g < cbook_groups_number(cfg->sequences); g++)
+	{
+		overlay = taint_overlay(&cfg->taint, g);
+		src     = overlay != SIZE_MAX ? cfg->taint.values : cfg->sequences;
+		group   = overlay != SIZE_MAX ? overlay : g;
+		cbook_prepare_new_group(sequences);
+		for (size_t i = 0; i < cbook_group_length(src, group); i++)
+		{
+			cbook_write(sequences, cbook_word_in_group(src, group, i));
+		}
+	}
+
+	return sequences;
+}
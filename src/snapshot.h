@@ -0,0 +1,56 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#pragma once
+
+#include <cassette/cobj.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+struct ccfg_snapshot
+{
+	cbook *sequences;
+	cdict *keys_sequences;
+	atomic_size_t refs;
+};
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * Readers announce themselves on one of the two counters, picked by the parity of the epoch, before loading
+ * the snapshot pointer. After swapping the pointer, a publisher flips the epoch and waits for the counter of
+ * the previous epoch to drop to zero, at which point no reader can still be about to acquire the replaced
+ * snapshot. New readers use the other counter meanwhile, so a steady flow of readers cannot stall the
+ * publisher.
+ */
+struct ccfg_slot
+{
+	_Atomic(ccfg_snapshot *) snapshot;
+	atomic_size_t readers[2];
+	atomic_size_t epoch;
+	atomic_flag publishing;
+};
@@ -32,65 +32,404 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include "cache.h"
 #include "context.h"
+#include "feed.h"
+#include "lazy.h"
+#include "loop.h"
 #include "main.h"
+#include "memo.h"
+#include "numbers.h"
+#include "pool.h"
 #include "sequence.h"
 #include "source.h"
+#include "stats.h"
+#include "stream.h"
+#include "taint.h"
 #include "token.h"
+#include "trace.h"
 
 /************************************************************************************************************/
 /************************************************************************************************************/
 /************************************************************************************************************/
 
-static bool has_err    (struct context *)                                             CCFG_NONNULL(1);
-static bool map_source (struct context *, const struct context *, const char *, bool) CCFG_NONNULL(1, 3);
-static void parse      (struct context *)                                             CCFG_NONNULL(1);
+/**
+ * Child file of an INCLUDE_PARALLEL sequence. Children that do nothing but declare resources get parsed by
+ * the pool workers into books of their own, which are merged back into the parent's in declaration order.
+ */
+struct child
+{
+	const char *path;
+	struct context ctx;
+	struct stat fs;
+	struct stream *compiled;
+	cbook *sequences;
+	cbook *names;
+	cdict *keys_sequences;
+	struct numbers numbers;
+	struct cache cache;
+	struct stats stats;
+	bool mapped;
+	bool isolated;
+	bool cached;
+	bool parsed;
+};
+
+/**
+ * Children of a single INCLUDE_PARALLEL sequence, as handed to the pool jobs. Parse jobs are run on a range
+ * of consecutive children that starts at first.
+ */
+struct batch
+{
+	struct context *parent;
+	struct child *children;
+	size_t first;
+};
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+static void finish      (struct context *)                                             CCFG_NONNULL(1);
+static bool has_err     (struct context *)                                             CCFG_NONNULL(1);
+static void inherit     (struct context *, struct context *)                           CCFG_NONNULL(1, 2);
+static void init_root   (struct context *, ccfg *)                                     CCFG_NONNULL(1, 2);
+static bool is_isolated (const struct stream *)                                        CCFG_NONNULL(1);
+static void job_map     (void *, size_t)                                               CCFG_NONNULL(1);
+static void job_parse   (void *, size_t)                                               CCFG_NONNULL(1);
+static bool map_source  (struct context *, const struct context *, const char *, bool) CCFG_NONNULL(1, 3);
+static void merge       (struct context *, const struct child *)                       CCFG_NONNULL(1, 2);
+static void parse       (struct context *)                                             CCFG_NONNULL(1);
+static void parse_feed  (struct feed *, bool)                                          CCFG_NONNULL(1);
+static bool parse_taint (ccfg *, size_t)                                               CCFG_NONNULL(1);
 
 /************************************************************************************************************/
 /* PRIVATE **************************************************************************************************/
 /************************************************************************************************************/
 
+void
+source_feed(ccfg *cfg, const char *data, size_t n)
+{
+	struct feed *feed = cfg->feed;
+
+	feed_push(feed, data, n);
+
+	if (feed->complete > 0)
+	{
+		parse_feed(feed, feed->over);
+	}
+
+	if (feed->err || has_err(&feed->ctx))
+	{
+		cfg->err = CERR_MEMORY;
+	}
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+source_feed_begin(ccfg *cfg)
+{
+	struct feed *feed;
+
+	if (!(feed = feed_create()))
+	{
+		cfg->err = CERR_MEMORY;
+		return;
+	}
+
+	/* same setup as an internal source, with a buffer that gets moved around between parses */
+
+	feed->ctx.streams     = &cfg->streams;
+	feed->ctx.trace       = &cfg->trace;
+	feed->ctx.stats       = &cfg->stats;
+	feed->ctx.file_inode  = 0;
+	feed->ctx.file_size   = 0;
+	feed->ctx.file_dir[0] = '\0';
+	feed->ctx.file_path   = "<stream>";
+	feed->ctx.file_start  = feed->buffer;
+	feed->ctx.line_start  = feed->buffer;
+	feed->ctx.line        = 1;
+	feed->ctx.buffer      = feed->buffer;
+	feed->ctx.stream      = NULL;
+	feed->ctx.word        = 0;
+
+	init_root(&feed->ctx, cfg);
+
+	feed->ctx.cache = NULL;
+
+	cfg->feed = feed;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+source_feed_end(ccfg *cfg, bool parse_tail)
+{
+	struct feed *feed = cfg->feed;
+
+	/* a source that does not end with a newline still ends its last sequence */
+
+	if (parse_tail && !feed->over)
+	{
+		feed->complete = feed->buffer_n;
+		parse_feed(feed, true);
+	}
+
+	if (parse_tail && has_err(&feed->ctx))
+	{
+		cfg->err = CERR_MEMORY;
+	}
+
+	finish(&feed->ctx);
+	feed_destroy(feed);
+
+	cfg->feed = NULL;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
 void
 source_parse_child(struct context *ctx_parent, const char *source)
 {
 	struct context ctx;
+	struct cache_mark mark;
 	size_t var_i;
 	size_t var_group;
+
+	ctx.streams = ctx_parent->streams;
+	ctx.trace   = ctx_parent->trace;
+	ctx.stats   = ctx_parent->stats;
 	
-	if (ctx_parent->depth >= CONTEXT_MAX_DEPTH || !map_source(&ctx, ctx_parent, source, false))
+	if (ctx_parent->depth >= CONTEXT_MAX_DEPTH)
+	{
+		STATS_ADD(ctx.stats, includes_rejected, 1);
+		return;
+	}
+
+	/* splice the output of the previous load if neither the child nor its input state changed */
+
+	cache_begin(ctx_parent, &mark);
+
+	if (cache_replay(ctx_parent, source, &mark))
 	{
+		STATS_ADD(ctx.stats, includes, 1);
+		cache_end(ctx_parent, source, &mark);
+		return;
+	}
+
+	if (!map_source(&ctx, ctx_parent, source, false))
+	{
+		cache_end(ctx_parent, source, &mark);
 		return;
 	}
 
 	var_i     = ctx_parent->var_i;
 	var_group = ctx_parent->var_group;
 
-	ctx.eol_reached    = false;
-	ctx.eof_reached    = false;
-	ctx.skip_sequences = false;
-	ctx.depth          = ctx_parent->depth + 1;
-	ctx.it_i           = SIZE_MAX;
-	ctx.it_group       = SIZE_MAX;
-	ctx.var_i          = SIZE_MAX;
-	ctx.var_group      = SIZE_MAX;
-	ctx.params         = ctx_parent->params;
-	ctx.sequences      = ctx_parent->sequences;
-	ctx.vars           = ctx_parent->vars;
-	ctx.iteration      = ctx_parent->iteration;
-	ctx.keys_params    = ctx_parent->keys_params;
-	ctx.keys_sequences = ctx_parent->keys_sequences;
-	ctx.keys_vars      = ctx_parent->keys_vars;
-	ctx.tokens         = ctx_parent->tokens;
-	ctx.restricted     = ctx_parent->restricted;
-	ctx.parent         = ctx_parent;
-	ctx.rand           = ctx_parent->rand;
-
+	inherit(&ctx, ctx_parent);
 	parse(&ctx);
 
 	ctx.var_i     = var_i;
 	ctx.var_group = var_group;
 
 	munmap((void*)ctx.buffer, ctx.file_size);
+
+	cache_end(ctx_parent, source, &mark);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+source_parse_children(struct context *ctx_parent, const cbook *paths)
+{
+	struct batch batch;
+	struct child *child;
+	struct stream *stream;
+	size_t n = cbook_words_number(paths);
+	size_t i;
+	size_t j;
+
+	batch.parent   = ctx_parent;
+	batch.children = NULL;
+	batch.first    = 0;
+
+	/* tracked loads record the words read by the sequences in order, which workers would interleave */
+
+	if (!ctx_parent->pool
+	 || ctx_parent->taint
+	 || ctx_parent->depth >= CONTEXT_MAX_DEPTH
+	 || n < 2
+	 || !(batch.children = malloc(n * sizeof(struct child))))
+	{
+		for (i = 0; i < n; i++)
+		{
+			source_parse_child(ctx_parent, cbook_word(paths, i));
+		}
+		return;
+	}
+
+	for (i = 0; i < n; i++)
+	{
+		child = batch.children + i;
+		child->path            = cbook_word(paths, i);
+		child->ctx.stream      = NULL;
+		child->compiled        = NULL;
+		child->sequences       = NULL;
+		child->names           = NULL;
+		child->keys_sequences  = NULL;
+		child->cache.active    = false;
+		child->cache.volatiles = 0;
+		child->mapped          = false;
+		child->isolated        = false;
+		child->cached          = false;
+		child->parsed          = false;
+		numbers_init(&child->numbers);
+		stats_init(&child->stats);
+	}
+
+	/* map and compile every child at once, streams compiled by the workers are kept aside until now */
+	/* because the shared list is only ever modified by this thread                                 */
+
+	pool_run(ctx_parent->pool, job_map, &batch, n);
+
+	for (i = 0; i < n; i++)
+	{
+		child = batch.children + i;
+
+		if (child->compiled && (stream = stream_find(*ctx_parent->streams, &child->fs)))
+		{
+			stream_destroy_all(&child->compiled);
+			child->ctx.stream = stream;
+		}
+		else if (child->compiled)
+		{
+			child->compiled->next = *ctx_parent->streams;
+			*ctx_parent->streams  = child->compiled;
+			child->compiled       = NULL;
+		}
+
+		if (child->ctx.stream)
+		{
+			child->ctx.stream->used = true;
+		}
+
+		/* replaying a stream fills in its skip offsets, so a given file is only parsed by one worker */
+
+		for (j = 0; j < i && child->isolated; j++)
+		{
+			child->isolated = !batch.children[j].isolated || batch.children[j].ctx.stream != child->ctx.stream;
+		}
+	}
+
+	/* Consecutive isolated children are parsed together, the others are parsed the usual way in between. */
+	/* Isolated children do not change the state the next ones get evaluated under, so the cache entries  */
+	/* of a whole run can be looked up before any of them is merged.                                       */
+
+	for (i = 0; i < n;)
+	{
+		if (!batch.children[i].isolated)
+		{
+			source_parse_child(ctx_parent, batch.children[i].path);
+			i++;
+			continue;
+		}
+
+		for (j = i; j < n && batch.children[j].isolated; j++)
+		{
+			batch.children[j].cached = cache_probe(ctx_parent, batch.children[j].path);
+		}
+
+		batch.first = i;
+		pool_run(ctx_parent->pool, job_parse, &batch, j - i);
+
+		for (; i < j; i++)
+		{
+			merge(ctx_parent, batch.children + i);
+		}
+	}
+
+	/* cleanup */
+
+	for (i = 0; i < n; i++)
+	{
+		child = batch.children + i;
+		if (child->mapped)
+		{
+			munmap((void*)child->ctx.buffer, child->ctx.file_size);
+		}
+		if (child->sequences)
+		{
+			cbook_destroy(child->sequences);
+			cbook_destroy(child->names);
+			cdict_destroy(child->keys_sequences);
+		}
+		stream_destroy_all(&child->compiled);
+		numbers_free(&child->numbers);
+		stats_free(&child->stats);
+	}
+
+	free(batch.children);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+source_parse_deferred(ccfg *cfg, size_t group)
+{
+	struct context ctx;
+	struct lazy_entry *entry;
+
+	if (!(entry = lazy_entry(&cfg->lazy, group)) || entry->values != LAZY_PENDING)
+	{
+		return;
+	}
+
+	init_root(&ctx, cfg);
+
+	/* raw words are read back as if they were injected from a variable, with no source left behind them */
+
+	ctx.eol_reached = true;
+	ctx.buffer      = "";
+	ctx.stream      = NULL;
+	ctx.streams     = NULL;
+	ctx.word        = 0;
+	ctx.trace       = &cfg->trace;
+	ctx.file_inode  = 0;
+	ctx.file_size   = 0;
+	ctx.file_dir[0] = '\0';
+	ctx.file_path   = "";
+	ctx.file_start  = ctx.buffer;
+	ctx.line_start  = ctx.buffer;
+	ctx.line        = 0;
+	ctx.depth       = entry->depth;
+	ctx.var_i       = 0;
+	ctx.var_group   = entry->words;
+	ctx.vars        = cfg->lazy.words;
+	ctx.sequences   = cfg->lazy.values;
+	ctx.numbers     = &cfg->lazy.numbers;
+	ctx.cache       = NULL;
+	ctx.lazy        = NULL;
+	ctx.pool        = NULL;
+	ctx.profile     = NULL;
+	ctx.taint       = NULL;
+	ctx.restricted  = false;
+
+	if (sequence_parse_values(&ctx) > 0)
+	{
+		entry->values = cbook_groups_number(cfg->lazy.values) - 1;
+	}
+	else
+	{
+		entry->values = LAZY_EMPTY;
+	}
+
+	cfg->lazy.pending--;
+
+	if (cbook_error(cfg->lazy.values) || cfg->lazy.numbers.err || cstr_error(cfg->scratch))
+	{
+		cfg->err = CERR_MEMORY;
+	}
 }
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
@@ -100,30 +439,18 @@ source_parse_root(ccfg *cfg, const char *source, bool internal)
 {
 	struct context ctx;
 
+	ctx.streams = &cfg->streams;
+	ctx.trace   = &cfg->trace;
+	ctx.stats   = &cfg->stats;
+
 	if (!map_source(&ctx, NULL, source, internal))
 	{
 		return;
 	}
 
-	ctx.eol_reached    = false;
-	ctx.eof_reached    = false;
-	ctx.skip_sequences = false;
-	ctx.depth          = 0;
-	ctx.it_i           = SIZE_MAX;
-	ctx.it_group       = SIZE_MAX;
-	ctx.var_i          = SIZE_MAX;
-	ctx.var_group      = SIZE_MAX;
-	ctx.params         = cfg->params;
-	ctx.sequences      = cfg->sequences;
-	ctx.vars           = cbook_create();
-	ctx.iteration      = cbook_create();
-	ctx.keys_params    = cfg->keys_params;
-	ctx.keys_sequences = cfg->keys_sequences;
-	ctx.keys_vars      = cdict_create();
-	ctx.tokens         = cfg->tokens;
-	ctx.restricted     = cfg->restricted || getenv("CCFG_RESTRICT");
-	ctx.parent         = NULL;
-	ctx.rand           = crand_seed(0);
+	init_root(&ctx, cfg);
+
+	ctx.cache = internal ? NULL : &cfg->cache;
 
 	parse(&ctx);
 
@@ -137,19 +464,317 @@ source_parse_root(ccfg *cfg, const char *source, bool internal)
 		munmap((void*)ctx.buffer, ctx.file_size);
 	}
 
-	cbook_destroy(ctx.iteration);
-	cbook_destroy(ctx.vars);
-	cdict_destroy(ctx.keys_vars);
+	finish(&ctx);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+bool
+source_reevaluate(ccfg *cfg, uint64_t changes, bool settle)
+{
+	struct taint *taint = &cfg->taint;
+
+	/* variables come before the resources and variables that inject them, in declaration order */
+
+	for (size_t i = 0; i < taint->entries_n && !cfg->err; i++)
+	{
+		if ((taint->entries[i].mask & changes) && !parse_taint(cfg, i))
+		{
+			return false;
+		}
+	}
+
+	if (!cfg->err && settle)
+	{
+		taint_settle(taint, &cfg->sequences, &cfg->numbers);
+	}
+
+	if (taint->err)
+	{
+		cfg->err = CERR_MEMORY;
+	}
+
+	return true;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+source_settle(ccfg *cfg)
+{
+	for (size_t g = 0; g < cfg->lazy.entries_n && cfg->lazy.pending > 0; g++)
+	{
+		source_parse_deferred(cfg, g);
+	}
+
+	if (!cfg->err)
+	{
+		lazy_settle(&cfg->lazy, &cfg->sequences, &cfg->numbers, cfg->keys_sequences, cfg->names);
+	}
+
+	if (cfg->lazy.err)
+	{
+		cfg->err = CERR_MEMORY;
+	}
 }
 
 /************************************************************************************************************/
 /* STATIC ***************************************************************************************************/
 /************************************************************************************************************/
 
+static void
+finish(struct context *ctx)
+{
+	STATS_PEAK(ctx->stats, peak_vars,      cbook_words_number(ctx->vars));
+	STATS_PEAK(ctx->stats, peak_sequences, cbook_words_number(ctx->sequences));
+
+	/* the parser state is kept allocated for the next load */
+
+	cbook_clear(ctx->iteration);
+	cbook_clear(ctx->vars);
+	loop_clear(ctx->loop);
+	cdict_clear(ctx->keys_vars);
+	cstr_clear(ctx->scratch);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
 static bool
 has_err(struct context *ctx)
 {
-	return cbook_error(ctx->iteration) || cbook_error(ctx->vars) || cdict_error(ctx->keys_vars);
+	return cbook_error(ctx->iteration)
+	    || ctx->loop->err
+	    || cbook_error(ctx->vars)
+	    || cdict_error(ctx->keys_vars)
+	    || cstr_error(ctx->scratch)
+	    || (ctx->lazy && ctx->lazy->err)
+	    || (ctx->taint && ctx->taint->err);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+inherit(struct context *ctx, struct context *ctx_parent)
+{
+	ctx->eol_reached    = false;
+	ctx->eof_reached    = false;
+	ctx->eof_requested  = false;
+	ctx->skip_sequences = false;
+	ctx->depth          = ctx_parent->depth + 1;
+	ctx->it_i           = SIZE_MAX;
+	ctx->it_group       = SIZE_MAX;
+	ctx->var_i          = SIZE_MAX;
+	ctx->var_group      = SIZE_MAX;
+	ctx->params         = ctx_parent->params;
+	ctx->sequences      = ctx_parent->sequences;
+	ctx->names          = ctx_parent->names;
+	ctx->numbers        = ctx_parent->numbers;
+	ctx->vars           = ctx_parent->vars;
+	ctx->iteration      = ctx_parent->iteration;
+	ctx->loop           = ctx_parent->loop;
+	ctx->keys_filters   = ctx_parent->keys_filters;
+	ctx->keys_params    = ctx_parent->keys_params;
+	ctx->keys_sequences = ctx_parent->keys_sequences;
+	ctx->keys_vars      = ctx_parent->keys_vars;
+	ctx->scratch        = ctx_parent->scratch;
+	ctx->restricted     = ctx_parent->restricted;
+	ctx->parent         = ctx_parent;
+	ctx->cache          = ctx_parent->cache;
+	ctx->memo           = ctx_parent->memo;
+	ctx->lazy           = ctx_parent->lazy;
+	ctx->pool           = ctx_parent->pool;
+	ctx->stats          = ctx_parent->stats;
+	ctx->profile        = ctx_parent->profile;
+	ctx->taint          = ctx_parent->taint;
+	ctx->rand           = ctx_parent->rand;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+init_root(struct context *ctx, ccfg *cfg)
+{
+	ctx->eol_reached    = false;
+	ctx->eof_reached    = false;
+	ctx->eof_requested  = false;
+	ctx->skip_sequences = false;
+	ctx->depth          = 0;
+	ctx->it_i           = SIZE_MAX;
+	ctx->it_group       = SIZE_MAX;
+	ctx->var_i          = SIZE_MAX;
+	ctx->var_group      = SIZE_MAX;
+	ctx->params         = cfg->params;
+	ctx->sequences      = cfg->sequences;
+	ctx->names          = cfg->names;
+	ctx->numbers        = &cfg->numbers;
+	ctx->vars           = cfg->vars;
+	ctx->iteration      = cfg->iteration;
+	ctx->loop           = &cfg->loop;
+	ctx->keys_filters   = cbook_words_number(cfg->filters) > 0 ? cfg->keys_filters : NULL;
+	ctx->keys_params    = cfg->keys_params;
+	ctx->keys_sequences = cfg->keys_sequences;
+	ctx->keys_vars      = cfg->keys_vars;
+	ctx->scratch        = cfg->scratch;
+	ctx->restricted     = cfg->restricted || getenv("CCFG_RESTRICT");
+	ctx->parent         = NULL;
+	ctx->cache          = &cfg->cache;
+	ctx->memo           = &cfg->memo;
+	ctx->lazy           = cfg->lazy.enabled ? &cfg->lazy : NULL;
+	ctx->pool           = cfg->pool.threads_max > 0 ? &cfg->pool : NULL;
+	ctx->stats          = &cfg->stats;
+	ctx->profile        = cfg->profile.enabled ? &cfg->profile : NULL;
+	ctx->taint          = cfg->taint.enabled ? &cfg->taint : NULL;
+	ctx->rand           = crand_seed(0);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static bool
+is_isolated(const struct stream *stream)
+{
+	const char *word;
+
+	/* Only plain resource definitions and section starts are let through, anything else that leads a */
+	/* line may write to the variables, sections, random generator or trace shared with the parent.   */
+	/* Newlines within quoted words would make the stream get lexed again while it gets replayed.     */
+
+	for (size_t i = 0; i < stream->lines_n; i++)
+	{
+		switch (stream->words[stream->lines[i].word].type)
+		{
+			case TOKEN_INVALID:
+			case TOKEN_STRING:
+			case TOKEN_NUMBER:
+			case TOKEN_COLOR:
+			case TOKEN_EOF:
+			case TOKEN_COMMENT:
+			case TOKEN_SECTION_BEGIN:
+			case TOKEN_RESTRICT:
+				break;
+
+			default:
+				return false;
+		}
+	}
+
+	for (size_t i = 0; i < cbook_words_number(stream->chars); i++)
+	{
+		word = cbook_word(stream->chars, i);
+		if (strchr(word, '\n'))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+job_map(void *data, size_t i)
+{
+	struct batch *batch = data;
+	struct child *child = batch->children + i;
+	const struct context *c;
+	int fd;
+
+	/* failures are left to source_parse_child(), which retries and traces them the usual way */
+
+	if ((fd = open(child->path, O_RDONLY)) == -1)
+	{
+		return;
+	}
+
+	if (fstat(fd, &child->fs) == -1)
+	{
+		close(fd);
+		return;
+	}
+
+	for (c = batch->parent; c; c = c->parent)
+	{
+		if (child->fs.st_ino == c->file_inode)
+		{
+			close(fd);
+			return;
+		}
+	}
+
+	child->ctx.buffer = mmap(0, child->fs.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (child->ctx.buffer == MAP_FAILED)
+	{
+		return;
+	}
+
+	/* the shared stream list is only read from here */
+
+	inherit(&child->ctx, batch->parent);
+
+	child->ctx.file_size  = child->fs.st_size;
+	child->ctx.file_inode = child->fs.st_ino;
+	child->ctx.word       = 0;
+	child->ctx.streams    = NULL;
+	child->ctx.trace      = NULL;
+	child->ctx.stats      = &child->stats;
+	child->ctx.profile    = NULL;
+	child->ctx.taint      = NULL;
+	child->ctx.file_path  = child->path;
+	child->ctx.file_start = child->ctx.buffer;
+	child->ctx.line_start = child->ctx.buffer;
+	child->ctx.line       = 1;
+	child->ctx.stream     = stream_find(*batch->parent->streams, &child->fs);
+	snprintf(child->ctx.file_dir, PATH_MAX, "%s", child->path);
+	dirname(child->ctx.file_dir);
+
+	if (!child->ctx.stream)
+	{
+		child->ctx.stream = stream_get(&child->compiled, &child->fs, child->ctx.buffer);
+	}
+
+	child->mapped   = true;
+	child->isolated = child->ctx.stream && is_isolated(child->ctx.stream);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+job_parse(void *data, size_t i)
+{
+	struct batch *batch = data;
+	struct child *child = batch->children + batch->first + i;
+
+	if (child->cached)
+	{
+		return;
+	}
+
+	/* the inactive cache only counts the volatile values, so that the merged output can be tainted */
+	/* the memo is left to the loading thread, workers evaluate every operation                     */
+
+	child->sequences      = cbook_create();
+	child->names          = cbook_create();
+	child->keys_sequences = cdict_create();
+
+	child->ctx.sequences      = child->sequences;
+	child->ctx.names          = child->names;
+	child->ctx.keys_sequences = child->keys_sequences;
+	child->ctx.numbers        = &child->numbers;
+	child->ctx.cache          = &child->cache;
+	child->ctx.memo           = NULL;
+	child->ctx.lazy           = NULL;
+
+	STATS_ADD(child->ctx.stats, includes, 1);
+	STATS_FILE(child->ctx.stats, child->path, child->ctx.buffer, child->ctx.file_size);
+
+	parse(&child->ctx);
+
+	child->parsed = !cbook_error(child->sequences)
+	             && !cbook_error(child->names)
+	             && !cdict_error(child->keys_sequences)
+	             && !child->numbers.err;
 }
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
@@ -157,6 +782,7 @@ has_err(struct context *ctx)
 static bool
 map_source(struct context *ctx, const struct context *ctx_parent, const char *source, bool internal)
 {
+	const struct context *c;
 	struct stat fs;
 	int fd;
 
@@ -167,7 +793,12 @@ map_source(struct context *ctx, const struct context *ctx_parent, const char *so
 		ctx->file_inode  = 0;
 		ctx->file_size   = 0;
 		ctx->file_dir[0] = '\0';
+		ctx->file_path   = "<internal>";
+		ctx->file_start  = source;
+		ctx->line_start  = source;
+		ctx->line        = 1;
 		ctx->buffer      = source;
+		ctx->stream      = NULL;
 		return true;
 	}
 
@@ -183,22 +814,33 @@ map_source(struct context *ctx, const struct context *ctx_parent, const char *so
 		goto fail_stat;
 	}
 
-	while (ctx_parent)
+	trace_push(ctx->trace, source, &fs);
+
+	for (c = ctx_parent; c; c = c->parent)
 	{
-		if (fs.st_ino == ctx_parent->file_inode)
+		if (fs.st_ino == c->file_inode)
 		{
 			goto fail_loop;
 		}
-		ctx_parent = ctx_parent->parent;
 	}
 
+	STATS_ADD(ctx->stats, includes, ctx_parent ? 1 : 0);
+
 	if ((ctx->buffer = mmap(0, fs.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED)
 	{
 		goto fail_map;
 	}
 
+	STATS_FILE(ctx->stats, source, ctx->buffer, fs.st_size);
+
 	ctx->file_size  = fs.st_size;
 	ctx->file_inode = fs.st_ino;
+	ctx->file_path  = source;
+	ctx->file_start = ctx->buffer;
+	ctx->line_start = ctx->buffer;
+	ctx->line       = 1;
+	ctx->stream     = stream_get(ctx->streams, &fs, ctx->buffer);
+	ctx->word       = 0;
 	snprintf(ctx->file_dir, PATH_MAX, "%s", source);
 	dirname(ctx->file_dir);
 	close(fd);
@@ -207,16 +849,79 @@ map_source(struct context *ctx, const struct context *ctx_parent, const char *so
 
 	/* errors */
 
-fail_map:
 fail_loop:
+	STATS_ADD(ctx->stats, includes_rejected, 1);
+fail_map:
+	close(fd);
+	return false;
+
 fail_stat:
 	close(fd);
 fail_open:
+	trace_push(ctx->trace, source, NULL);
 	return false;
 }
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 
+static void
+merge(struct context *ctx, const struct child *child)
+{
+	struct cache_mark mark;
+	const char *namespace;
+	const char *name;
+	size_t group;
+	size_t i;
+
+	/* cached children and the ones that failed to parse go the usual way */
+
+	if (!child->parsed)
+	{
+		source_parse_child(ctx, child->path);
+		return;
+	}
+
+	STATS_MERGE(ctx->stats, &child->stats);
+
+	cache_begin(ctx, &mark);
+	trace_push(ctx->trace, child->path, &child->fs);
+
+	/* same writes as declare_resource(), with the numbers carried over as they were computed */
+
+	for (size_t g = 0; g < cbook_groups_number(child->names); g++)
+	{
+		namespace = cbook_word_in_group(child->names, g, 0);
+		name      = cbook_word_in_group(child->names, g, 1);
+
+		cbook_prepare_new_group(ctx->sequences);
+		for (size_t k = 0; k < cbook_group_length(child->sequences, g); k++)
+		{
+			cbook_write(ctx->sequences, cbook_word_in_group(child->sequences, g, k));
+			numbers_push(ctx->numbers, numbers_get(&child->numbers, cbook_word_index(child->sequences, g, k)));
+		}
+		if (!cdict_find(ctx->keys_sequences, namespace, 0, &i))
+		{
+			i = cbook_groups_number(ctx->sequences);
+			cdict_write(ctx->keys_sequences, namespace, 0, i);
+		}
+		group = cbook_groups_number(ctx->sequences) - 1;
+		cdict_write(ctx->keys_sequences, name, i, group);
+		cbook_prepare_new_group(ctx->names);
+		cbook_write(ctx->names, namespace);
+		cbook_write(ctx->names, name);
+		cache_record(ctx, CACHE_RESOURCE, namespace, name, ctx->sequences, group);
+	}
+
+	if (child->cache.volatiles > 0)
+	{
+		cache_taint(ctx);
+	}
+
+	cache_end(ctx, child->path, &mark);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
 static void
 parse(struct context *ctx)
 {
@@ -226,3 +931,102 @@ parse(struct context *ctx)
 		sequence_parse(ctx);
 	}
 }
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+parse_feed(struct feed *feed, bool last)
+{
+	struct context *ctx = &feed->ctx;
+	char c;
+
+	/* the complete part is read as a source of its own, cut short by a terminator put there for a while */
+
+	c = feed->buffer[feed->complete];
+	feed->buffer[feed->complete] = '\0';
+
+	ctx->buffer      = feed->buffer;
+	ctx->file_start  = feed->buffer;
+	ctx->line_start  = feed->buffer;
+	ctx->eof_reached = false;
+
+	/* unless it is the last one, a part ends where a sequence starts, which must not be read as an empty one */
+
+	while (!ctx->eof_reached && (last || *ctx->buffer != '\0'))
+	{
+		ctx->eol_reached = false;
+		sequence_parse(ctx);
+	}
+
+	/* lines are counted up to the cut, the next part will be read from the start of the buffer again */
+
+	if (ctx->profile)
+	{
+		context_line(ctx);
+	}
+
+	feed->buffer[feed->complete] = c;
+	feed->over = feed->over || ctx->eof_requested;
+
+	feed_consume(feed);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static bool
+parse_taint(ccfg *cfg, size_t i)
+{
+	struct context ctx;
+	struct taint_entry *entry = cfg->taint.entries + i;
+	size_t n;
+
+	init_root(&ctx, cfg);
+
+	/* the written down values are read back as a line of source, with the tainted variables they injected */
+
+	ctx.buffer      = cbook_word(cfg->taint.lines, entry->line);
+	ctx.stream      = NULL;
+	ctx.streams     = NULL;
+	ctx.word        = 0;
+	ctx.trace       = &cfg->trace;
+	ctx.file_inode  = 0;
+	ctx.file_size   = 0;
+	ctx.file_dir[0] = '\0';
+	ctx.file_path   = "";
+	ctx.file_start  = ctx.buffer;
+	ctx.line_start  = ctx.buffer;
+	ctx.line        = 0;
+	ctx.depth       = entry->depth;
+	ctx.vars        = cfg->taint.vars;
+	ctx.keys_vars   = cfg->taint.keys_vars;
+	ctx.sequences   = cfg->taint.values;
+	ctx.numbers     = &cfg->taint.numbers;
+	ctx.cache       = NULL;
+	ctx.lazy        = NULL;
+	ctx.pool        = NULL;
+	ctx.stats       = NULL;
+	ctx.profile     = NULL;
+	ctx.taint       = NULL;
+
+	n = entry->variable ? sequence_parse_variable(&ctx) : sequence_parse_values(&ctx);
+
+	if (n > 0 && entry->variable)
+	{
+		taint_rebind(&cfg->taint, i);
+	}
+	else if (n > 0)
+	{
+		taint_keep(&cfg->taint, i, cbook_groups_number(cfg->taint.values) - 1);
+	}
+
+	if (cbook_error(cfg->taint.vars)
+	 || cbook_error(cfg->taint.values)
+	 || cdict_error(cfg->taint.keys_vars)
+	 || cfg->taint.numbers.err
+	 || cstr_error(cfg->scratch))
+	{
+		cfg->err = CERR_MEMORY;
+	}
+
+	return n > 0;
+}
@@ -21,7 +21,9 @@
 #pragma once
 
 #include <cassette/ccfg.h>
+#include <cassette/cobj.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "context.h"
 #include "main.h"
@@ -30,6 +32,38 @@
 /************************************************************************************************************/
 /************************************************************************************************************/
 
+/**
+ * Parses the sequences completed by n more bytes of the source opened by source_feed_begin(), and keeps the
+ * unfinished tail for the next call.
+ */
+void
+source_feed(ccfg *cfg, const char *data, size_t n)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Opens a root source that gets handed over in chunks, see struct feed.
+ */
+void
+source_feed_begin(ccfg *cfg)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Closes the source opened by source_feed_begin(). If parse_tail is set, what is left of it gets parsed
+ * first, otherwise it is dropped along with it.
+ */
+void
+source_feed_end(ccfg *cfg, bool parse_tail)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
 void
 source_parse_child(struct context *ctx_parent, const char *source)
 CCFG_NONNULL(1, 2)
@@ -37,7 +71,52 @@ CCFG_HIDDEN;
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 
+/**
+ * Parses the children of an INCLUDE_PARALLEL sequence with the parser's thread pool. The output is the same
+ * as if they were passed to source_parse_child() one after another, in the order of paths.
+ */
+void
+source_parse_children(struct context *ctx_parent, const cbook *paths)
+CCFG_NONNULL(1, 2)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Evaluates the values of a resource that got deferred by the last load, if it was not evaluated yet.
+ */
+void
+source_parse_deferred(ccfg *cfg, size_t group)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
 void
 source_parse_root(ccfg *cfg, const char *source, bool internal)
 CCFG_NONNULL(1, 2)
 CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Evaluates again the tracked resources and variables of the last load that depend on the given changes, a
+ * mask of params as given by taint_changes(). If settle is set, the new values get written into the sequence
+ * book, otherwise they are left in the taint's values book, over a sequence book that may be shared. Returns
+ * false if any of them ended up without values, in which case the sources have to be loaded again.
+ */
+bool
+source_reevaluate(ccfg *cfg, uint64_t changes, bool settle)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Evaluates every resource still deferred by the last load, and writes all the evaluated values back into
+ * the sequence book, so that it can be read without going through the lazy data.
+ */
+void
+source_settle(ccfg *cfg)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
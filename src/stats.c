@@ -0,0 +1,185 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#include <cassette/ccfg.h>
+#include <cassette/cobj.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "stats.h"
+#include "util.h"
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+static void push (struct stats *, const char *, size_t, size_t) CCFG_NONNULL(1, 2);
+
+/************************************************************************************************************/
+/* PRIVATE **************************************************************************************************/
+/************************************************************************************************************/
+
+void
+stats_free(struct stats *stats)
+{
+	if (stats->paths)
+	{
+		cbook_destroy(stats->paths);
+	}
+
+	free(stats->files);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+stats_init(struct stats *stats)
+{
+	memset(&stats->counters, 0, sizeof(stats->counters));
+
+	stats->paths     = NULL;
+	stats->files     = NULL;
+	stats->files_n   = 0;
+	stats->files_cap = 0;
+	stats->clock     = 0;
+	stats->err       = false;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+stats_lap(struct stats *stats, uint64_t *phase)
+{
+	uint64_t t = util_clock();
+
+	*phase      += t - stats->clock;
+	stats->clock = t;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+stats_merge(struct stats *stats, const struct stats *src)
+{
+	const struct ccfg_stats *c = &src->counters;
+
+	for (size_t i = 0; i < src->files_n; i++)
+	{
+		push(stats, cbook_word(src->paths, i), src->files[i].bytes, src->files[i].lines);
+	}
+
+	stats->counters.includes          += c->includes;
+	stats->counters.includes_rejected += c->includes_rejected;
+	stats->counters.tokens            += c->tokens;
+	stats->counters.matches           += c->matches;
+	stats->counters.iterations        += c->iterations;
+	stats->counters.maths             += c->maths;
+	stats->counters.colors            += c->colors;
+	stats->counters.joins             += c->joins;
+	stats->counters.conditions        += c->conditions;
+	stats->counters.var_injections    += c->var_injections;
+	stats->counters.param_injections  += c->param_injections;
+	stats->counters.iter_injections   += c->iter_injections;
+
+	stats_peak(&stats->counters.peak_vars,      c->peak_vars);
+	stats_peak(&stats->counters.peak_iteration, c->peak_iteration);
+
+	stats->err |= src->err;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+stats_peak(size_t *peak, size_t n)
+{
+	if (n > *peak)
+	{
+		*peak = n;
+	}
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+stats_push_file(struct stats *stats, const char *path, const char *buffer, size_t size)
+{
+	const char *end = buffer + size;
+	size_t lines = size > 0 && end[-1] != '\n' ? 1 : 0;
+
+	while ((buffer = memchr(buffer, '\n', end - buffer)))
+	{
+		buffer++;
+		lines++;
+	}
+
+	push(stats, path, size, lines);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+stats_start(struct stats *stats)
+{
+	if (stats->paths)
+	{
+		cbook_clear(stats->paths);
+	}
+
+	memset(&stats->counters, 0, sizeof(stats->counters));
+
+	stats->files_n = 0;
+	stats->clock   = util_clock();
+	stats->err     = false;
+}
+
+/************************************************************************************************************/
+/* STATIC ***************************************************************************************************/
+/************************************************************************************************************/
+
+static void
+push(struct stats *stats, const char *path, size_t bytes, size_t lines)
+{
+	struct stats_file *tmp;
+
+	stats->counters.files++;
+	stats->counters.bytes += bytes;
+	stats->counters.lines += lines;
+
+	if (!stats->paths)
+	{
+		stats->paths = cbook_create();
+	}
+
+	if (!(tmp = util_reserve(stats->files, &stats->files_cap, stats->files_n + 1, sizeof(*tmp))))
+	{
+		stats->err = true;
+		return;
+	}
+
+	stats->files = tmp;
+
+	cbook_write(stats->paths, path);
+
+	stats->files[stats->files_n].bytes = bytes;
+	stats->files[stats->files_n].lines = lines;
+	stats->files_n++;
+}
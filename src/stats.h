@@ -0,0 +1,146 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#pragma once
+
+#include <cassette/ccfg.h>
+#include <cassette/cobj.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+/* Instrumentation points of the parser. Unless the library is built with CCFG_STATS defined they expand */
+/* to nothing, and their arguments are not evaluated. Stats pointers are NULL outside of loads.           */
+
+#if defined(CCFG_STATS)
+	#define STATS_ENABLED true
+	#define STATS_ADD(S, FIELD, N)   do { if (S) { (S)->counters.FIELD += (N); } } while (0)
+	#define STATS_PEAK(S, FIELD, N)  do { if (S) { stats_peak(&(S)->counters.FIELD, N); } } while (0)
+	#define STATS_FILE(S, P, B, N)   do { if (S) { stats_push_file(S, P, B, N); } } while (0)
+	#define STATS_MERGE(S, SRC)      do { if (S) { stats_merge(S, SRC); } } while (0)
+	#define STATS_START(S)           stats_start(S)
+	#define STATS_LAP(S, FIELD)      stats_lap(S, &(S)->counters.FIELD)
+#else
+	#define STATS_ENABLED false
+	#define STATS_ADD(S, FIELD, N)   ((void)0)
+	#define STATS_PEAK(S, FIELD, N)  ((void)0)
+	#define STATS_FILE(S, P, B, N)   ((void)0)
+	#define STATS_MERGE(S, SRC)      ((void)0)
+	#define STATS_START(S)           ((void)0)
+	#define STATS_LAP(S, FIELD)      ((void)0)
+#endif
+
+/************************************************************************************************************/
+/* TYPES ****************************************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * Size of a source file read during a load.
+ */
+struct stats_file
+{
+	size_t bytes;
+	size_t lines;
+};
+
+/**
+ * Counters of a load and the files it read, in the order they were read. The paths book is only allocated
+ * once a file gets pushed, so that the stats set up for the children parsed by the pool workers cost nothing
+ * when the library is built without instrumentation. The clock holds the time the current phase started at.
+ */
+struct stats
+{
+	struct ccfg_stats counters;
+	cbook *paths;
+	struct stats_file *files;
+	size_t files_n;
+	size_t files_cap;
+	uint64_t clock;
+	bool err;
+};
+
+/************************************************************************************************************/
+/* CONSTRUCTORS / DESTRUCTORS *******************************************************************************/
+/************************************************************************************************************/
+
+void
+stats_init(struct stats *stats)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+stats_free(struct stats *stats)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/************************************************************************************************************/
+/* PROCEDURES ***********************************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * Adds the time elapsed since the last call to stats_start() or stats_lap() to the given phase counter.
+ */
+void
+stats_lap(struct stats *stats, uint64_t *phase)
+CCFG_NONNULL(1, 2)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Adds the counters and files of a child that was parsed with stats of its own by a pool worker.
+ */
+void
+stats_merge(struct stats *stats, const struct stats *src)
+CCFG_NONNULL(1, 2)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+stats_peak(size_t *peak, size_t n)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Records a file that was read, its lines are counted from the given buffer.
+ */
+void
+stats_push_file(struct stats *stats, const char *path, const char *buffer, size_t size)
+CCFG_NONNULL(1, 2, 3)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Resets the counters and forgets the files read, then starts timing the first phase of a new load.
+ */
+void
+stats_start(struct stats *stats)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
@@ -0,0 +1,411 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#include <cassette/ccfg.h>
+#include <cassette/cobj.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "context.h"
+#include "stream.h"
+#include "token.h"
+#include "util.h"
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+static void   destroy      (struct stream *)                                   CCFG_NONNULL(1);
+static size_t find_line    (const struct stream *, size_t)                     CCFG_NONNULL(1);
+static size_t lex          (struct stream *, const char *, size_t)             CCFG_NONNULL(1, 2);
+static bool   push_line    (struct stream *, size_t, size_t)                   CCFG_NONNULL(1);
+static size_t push_word    (struct stream *, const char *, size_t, enum token) CCFG_NONNULL(1, 2);
+static void   resolve_ends (struct stream *, const char *, size_t, size_t)     CCFG_NONNULL(1, 2);
+
+/************************************************************************************************************/
+/* PRIVATE **************************************************************************************************/
+/************************************************************************************************************/
+
+void
+stream_clean(struct stream **list)
+{
+	struct stream *tmp;
+
+	while (*list)
+	{
+		if (!(*list)->used || (*list)->err)
+		{
+			tmp   = *list;
+			*list = tmp->next;
+			destroy(tmp);
+		}
+		else
+		{
+			(*list)->used = false;
+			list = &(*list)->next;
+		}
+	}
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+stream_destroy_all(struct stream **list)
+{
+	struct stream *tmp;
+
+	while (*list)
+	{
+		tmp   = *list;
+		*list = tmp->next;
+		destroy(tmp);
+	}
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+struct stream *
+stream_find(struct stream *list, const struct stat *fs)
+{
+	for (; list; list = list->next)
+	{
+		if (!list->err
+		 && list->file_device        == fs->st_dev
+		 && list->file_inode         == fs->st_ino
+		 && list->file_size          == fs->st_size
+		 && list->file_mtime.tv_sec  == fs->st_mtim.tv_sec
+		 && list->file_mtime.tv_nsec == fs->st_mtim.tv_nsec)
+		{
+			return list;
+		}
+	}
+
+	return NULL;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+struct stream *
+stream_get(struct stream **list, const struct stat *fs, const char *buffer)
+{
+	struct stream *stream;
+
+	/* look for an up-to-date compiled version of the source file */
+
+	if ((stream = stream_find(*list, fs)))
+	{
+		stream->used = true;
+		return stream;
+	}
+
+	/* if not found, compile the source */
+
+	if (!(stream = malloc(sizeof(struct stream))))
+	{
+		return NULL;
+	}
+
+	stream->file_device = fs->st_dev;
+	stream->file_inode  = fs->st_ino;
+	stream->file_size   = fs->st_size;
+	stream->file_mtime  = fs->st_mtim;
+	stream->words       = NULL;
+	stream->lines       = NULL;
+	stream->words_n     = 0;
+	stream->words_cap   = 0;
+	stream->lines_n     = 0;
+	stream->lines_cap   = 0;
+	stream->eof         = SIZE_MAX;
+	stream->chars       = cbook_create();
+	stream->keys_chars  = cdict_create();
+	stream->next        = *list;
+	stream->used        = true;
+	stream->err         = false;
+
+	if (lex(stream, buffer, 0) == SIZE_MAX)
+	{
+		destroy(stream);
+		return NULL;
+	}
+
+	*list = stream;
+
+	return stream;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+stream_keep(struct stream *list, const struct stat *fs)
+{
+	struct stream *stream;
+
+	if ((stream = stream_find(list, fs)))
+	{
+		stream->used = true;
+	}
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+size_t
+stream_skip(struct stream *stream, const char *buffer, size_t word)
+{
+	size_t i;
+
+	if (stream->words[word].skip != SIZE_MAX)
+	{
+		return stream->words[word].skip;
+	}
+
+	/* EOF reached before any newline */
+
+	if (stream->words[word].line_end == SIZE_MAX)
+	{
+		return stream->words[word].skip = stream->eof;
+	}
+
+	/* If the next line has not been compiled yet it means the newline was part of a quoted word. */
+	/* The source is then lexed again from there.                                                  */
+
+	if ((i = find_line(stream, stream->words[word].line_end + 1)) == SIZE_MAX
+	 && (i = lex(stream, buffer, stream->words[word].line_end + 1)) == SIZE_MAX)
+	{
+		return SIZE_MAX;
+	}
+
+	return stream->words[word].skip = i;
+}
+
+/************************************************************************************************************/
+/* STATIC ***************************************************************************************************/
+/************************************************************************************************************/
+
+static void
+destroy(struct stream *stream)
+{
+	cbook_destroy(stream->chars);
+	cdict_destroy(stream->keys_chars);
+
+	free(stream->words);
+	free(stream->lines);
+	free(stream);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static size_t
+find_line(const struct stream *stream, size_t offset)
+{
+	size_t a = 0;
+	size_t b = stream->lines_n;
+	size_t i;
+
+	while (a < b)
+	{
+		i = a + (b - a) / 2;
+		if (stream->lines[i].offset == offset)
+		{
+			return stream->lines[i].word;
+		}
+		else if (stream->lines[i].offset < offset)
+		{
+			a = i + 1;
+		}
+		else
+		{
+			b = i;
+		}
+	}
+
+	return SIZE_MAX;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static size_t
+lex(struct stream *stream, const char *buffer, size_t offset)
+{
+	struct context ctx;
+	struct token_view token;
+	size_t first;
+	size_t prev = SIZE_MAX;
+	size_t i;
+	bool line_start = true;
+
+	first = stream->words_n;
+
+	ctx.buffer      = buffer + offset;
+	ctx.eof_reached = false;
+
+	token_view_init(&token);
+
+	for (;;)
+	{
+		/* stop as soon as the lexer joins a line that has already been compiled */
+
+		if (line_start && (i = find_line(stream, offset)) != SIZE_MAX)
+		{
+			if (prev == SIZE_MAX)
+			{
+				token_view_free(&token);
+				return i;
+			}
+			stream->words[prev].next = i;
+			break;
+		}
+
+		/* read and save word */
+
+		ctx.eol_reached = false;
+		context_lex_word(&ctx, &token);
+
+		if ((i = push_word(stream, token.chars, offset, token_match(token.chars))) == SIZE_MAX
+		 || (line_start && !push_line(stream, offset, i)))
+		{
+			token_view_free(&token);
+			stream->err = true;
+			return SIZE_MAX;
+		}
+
+		if (prev != SIZE_MAX)
+		{
+			stream->words[prev].next = i;
+		}
+
+		stream->words[i].eol = ctx.eol_reached;
+		stream->words[i].eof = ctx.eof_reached;
+
+		offset     = ctx.buffer - buffer;
+		line_start = ctx.eol_reached;
+		prev       = i;
+
+		if (ctx.eof_reached)
+		{
+			stream->words[i].next = i;
+			stream->eof = i;
+			break;
+		}
+	}
+
+	token_view_free(&token);
+
+	resolve_ends(stream, buffer, first, offset);
+
+	return first;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static bool
+push_line(struct stream *stream, size_t offset, size_t word)
+{
+	struct stream_line *tmp;
+	size_t i;
+
+	if (!(tmp = util_reserve(stream->lines, &stream->lines_cap, stream->lines_n + 1, sizeof(*tmp))))
+	{
+		return false;
+	}
+
+	stream->lines = tmp;
+
+	/* keep lines sorted by offset, lines lexed after a quoted newline may come out of order */
+
+	for (i = stream->lines_n; i > 0 && stream->lines[i - 1].offset > offset; i--);
+
+	memmove(stream->lines + i + 1, stream->lines + i, (stream->lines_n - i) * sizeof(*tmp));
+
+	stream->lines[i].offset = offset;
+	stream->lines[i].word   = word;
+	stream->lines_n++;
+
+	return true;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static size_t
+push_word(struct stream *stream, const char *token, size_t offset, enum token type)
+{
+	struct stream_word *tmp;
+	size_t chars;
+
+	/* intern word */
+
+	if (!cdict_find(stream->keys_chars, token, 0, &chars))
+	{
+		chars = cbook_words_number(stream->chars);
+		cbook_write(stream->chars, token);
+		cdict_write(stream->keys_chars, token, 0, chars);
+		if (cbook_error(stream->chars) || cdict_error(stream->keys_chars))
+		{
+			return SIZE_MAX;
+		}
+	}
+
+	/* append word */
+
+	if (!(tmp = util_reserve(stream->words, &stream->words_cap, stream->words_n + 1, sizeof(*tmp))))
+	{
+		return SIZE_MAX;
+	}
+
+	stream->words = tmp;
+	stream->words[stream->words_n].chars    = chars;
+	stream->words[stream->words_n].start    = offset;
+	stream->words[stream->words_n].next     = SIZE_MAX;
+	stream->words[stream->words_n].skip     = SIZE_MAX;
+	stream->words[stream->words_n].line_end = SIZE_MAX;
+	stream->words[stream->words_n].type     = type;
+	stream->words[stream->words_n].eol      = false;
+	stream->words[stream->words_n].eof      = false;
+
+	return stream->words_n++;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+resolve_ends(struct stream *stream, const char *buffer, size_t first, size_t end)
+{
+	const char *c;
+	size_t line_end;
+
+	/* words of a lexing run are contiguous in the source, so they can be walked backwards to find the */
+	/* first newline that follows each one of them without scanning the same characters twice         */
+
+	line_end = stream->words[stream->words_n - 1].eof
+		? SIZE_MAX
+		: stream->words[stream->words[stream->words_n - 1].next].line_end;
+
+	for (size_t i = stream->words_n; i > first; i--)
+	{
+		if ((c = memchr(buffer + stream->words[i - 1].start, '\n', end - stream->words[i - 1].start)))
+		{
+			line_end = c - buffer;
+		}
+		stream->words[i - 1].line_end = line_end;
+		end = stream->words[i - 1].start;
+	}
+}
@@ -0,0 +1,141 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#pragma once
+
+#include <cassette/ccfg.h>
+#include <cassette/cobj.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+
+#include "token.h"
+
+/************************************************************************************************************/
+/* TYPES ****************************************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * Word as the lexer produced it when reading from a given source offset. Words are chained in the order in
+ * which they get read, so that a parser replaying the stream never has to go back to the source text.
+ */
+struct stream_word
+{
+	size_t chars;
+	size_t start;
+	size_t next;
+	size_t skip;
+	size_t line_end;
+	enum token type;
+	bool eol;
+	bool eof;
+};
+
+/**
+ * Offset at which a new line starts, along with the first word read from it.
+ */
+struct stream_line
+{
+	size_t offset;
+	size_t word;
+};
+
+/**
+ * Compiled form of a source file. Streams are kept in a linked list and looked up by the identity of the
+ * file they were compiled from.
+ */
+struct stream
+{
+	/* source identity */
+
+	dev_t file_device;
+	ino_t file_inode;
+	off_t file_size;
+	struct timespec file_mtime;
+
+	/* compiled data */
+
+	struct stream_word *words;
+	struct stream_line *lines;
+	size_t words_n;
+	size_t words_cap;
+	size_t lines_n;
+	size_t lines_cap;
+	size_t eof;
+	cbook *chars;
+	cdict *keys_chars;
+
+	/* cache state */
+
+	struct stream *next;
+	bool used;
+	bool err;
+};
+
+/************************************************************************************************************/
+/* CONSTRUCTORS / DESTRUCTORS *******************************************************************************/
+/************************************************************************************************************/
+
+void
+stream_destroy_all(struct stream **list)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/************************************************************************************************************/
+/* PROCEDURES ***********************************************************************************************/
+/************************************************************************************************************/
+
+void
+stream_clean(struct stream **list)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+struct stream *
+stream_get(struct stream **list, const struct stat *fs, const char *buffer)
+CCFG_NONNULL(1, 2, 3)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+stream_keep(struct stream *list, const struct stat *fs)
+CCFG_NONNULL(2)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+size_t
+stream_skip(struct stream *stream, const char *buffer, size_t word)
+CCFG_NONNULL(1, 2)
+CCFG_HIDDEN;
+
+/************************************************************************************************************/
+/* FUNCTIONS ************************************************************************************************/
+/************************************************************************************************************/
+
+struct stream *
+stream_find(struct stream *list, const struct stat *fs)
+CCFG_NONNULL(2)
+CCFG_HIDDEN
+CCFG_PURE;
@@ -23,12 +23,18 @@
 #include <float.h>
 #include <math.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
+#include "cache.h"
 #include "context.h"
+#include "memo.h"
+#include "profile.h"
+#include "stats.h"
 #include "substitution.h"
+#include "taint.h"
 #include "token.h"
 #include "util.h"
 
@@ -37,26 +43,25 @@
 /************************************************************************************************************/
 
 static enum token comment       (void);
-static enum token condition     (struct context *, char [static TOKEN_MAX_LEN], double *, enum token)         CCFG_NONNULL(1);
-static enum token eof           (struct context *)                                                            CCFG_NONNULL(1);
-static enum token escape        (struct context *, char [static TOKEN_MAX_LEN])                               CCFG_NONNULL(1);
-static enum token filler        (struct context *, char [static TOKEN_MAX_LEN], double *)                     CCFG_NONNULL(1);
-static enum token join          (struct context *, char [static TOKEN_MAX_LEN])                               CCFG_NONNULL(1);
-static enum token math          (struct context *, char [static TOKEN_MAX_LEN], double *, enum token, size_t) CCFG_NONNULL(1);
-static enum token math_cl       (struct context *, char [static TOKEN_MAX_LEN], double *, enum token, size_t) CCFG_NONNULL(1);
-static enum token param         (struct context *, char [static TOKEN_MAX_LEN])                               CCFG_NONNULL(1);
-static enum token variable      (struct context *, char [static TOKEN_MAX_LEN], double *)                     CCFG_NONNULL(1);
-static enum token variable_iter (struct context *, char [static TOKEN_MAX_LEN])                               CCFG_NONNULL(1);
+static enum token condition     (struct context *, struct token_view *, double *, enum token)         CCFG_NONNULL(1, 2);
+static enum token eof           (struct context *)                                                    CCFG_NONNULL(1);
+static enum token escape        (struct context *, struct token_view *)                               CCFG_NONNULL(1, 2);
+static enum token filler        (struct context *, struct token_view *, double *)                     CCFG_NONNULL(1, 2);
+static enum token inject        (struct context *, struct token_view *, enum token)                   CCFG_NONNULL(1, 2);
+static enum token join          (struct context *, struct token_view *)                               CCFG_NONNULL(1, 2);
+static enum token math          (struct context *, struct token_view *, double *, enum token, size_t) CCFG_NONNULL(1, 2);
+static enum token math_cl       (struct context *, struct token_view *, double *, enum token, size_t) CCFG_NONNULL(1, 2);
+static enum token param         (struct context *, struct token_view *)                               CCFG_NONNULL(1, 2);
+static enum token variable      (struct context *, struct token_view *, double *)                     CCFG_NONNULL(1, 2);
+static enum token variable_iter (struct context *, struct token_view *)                               CCFG_NONNULL(1, 2);
 
 /************************************************************************************************************/
 /* PRIVATE **************************************************************************************************/
 /************************************************************************************************************/
 
 enum token
-substitution_apply(struct context *ctx, char token[static TOKEN_MAX_LEN], double *math_result)
+substitution_apply(struct context *ctx, struct token_view *token, double *math_result, enum token type)
 {
-	enum token type;
-
 	if (ctx->depth >= CONTEXT_MAX_DEPTH)
 	{
 		return TOKEN_INVALID;
@@ -68,8 +73,15 @@ substitution_apply(struct context *ctx, char token[static TOKEN_MAX_LEN], double
 	}
 	
 	ctx->depth++;
+
+	/* substitutions proper go from JOIN to the color functions, escapes and fillers only pass words along */
+
+	if (ctx->profile && type >= TOKEN_JOIN && type <= TOKEN_CL_RGBA && type != TOKEN_ESCAPE)
+	{
+		profile_count(ctx->profile);
+	}
 	
-	switch (type = token_match(ctx->tokens, token))
+	switch (type)
 	{
 		case TOKEN_COMMENT:
 			type = comment();
@@ -88,18 +100,22 @@ substitution_apply(struct context *ctx, char token[static TOKEN_MAX_LEN], double
 			break;
 
 		case TOKEN_JOIN:
+			STATS_ADD(ctx->stats, joins, 1);
 			type = join(ctx, token);
 			break;
 
 		case TOKEN_VAR_INJECTION:
+			STATS_ADD(ctx->stats, var_injections, 1);
 			type = variable(ctx, token, math_result);
 			break;
 
 		case TOKEN_ITER_INJECTION:
+			STATS_ADD(ctx->stats, iter_injections, 1);
 			type = variable_iter(ctx, token);
 			break;
 
 		case TOKEN_PARAM_INJECTION:
+			STATS_ADD(ctx->stats, param_injections, 1);
 			type = param(ctx, token);
 			break;
 
@@ -110,6 +126,7 @@ substitution_apply(struct context *ctx, char token[static TOKEN_MAX_LEN], double
 		case TOKEN_IF_EQ:
 		case TOKEN_IF_EQ_NOT:
 		case TOKEN_IF_STR_EQ:
+			STATS_ADD(ctx->stats, conditions, 1);
 			type = condition(ctx, token, math_result, type);
 			break;
 
@@ -118,6 +135,7 @@ substitution_apply(struct context *ctx, char token[static TOKEN_MAX_LEN], double
 		case TOKEN_CONST_EULER:
 		case TOKEN_CONST_TRUE:
 		case TOKEN_CONST_FALSE:
+			STATS_ADD(ctx->stats, maths, 1);
 			type = math(ctx, token, math_result, type, 0);
 			break;
 
@@ -137,6 +155,7 @@ substitution_apply(struct context *ctx, char token[static TOKEN_MAX_LEN], double
 		case TOKEN_OP_SINH:
 		case TOKEN_OP_LN:
 		case TOKEN_OP_LOG:
+			STATS_ADD(ctx->stats, maths, 1);
 			type = math(ctx, token, math_result, type, 1);
 			break;
 
@@ -149,20 +168,24 @@ substitution_apply(struct context *ctx, char token[static TOKEN_MAX_LEN], double
 		case TOKEN_OP_BIGGEST:
 		case TOKEN_OP_SMALLEST:
 		case TOKEN_OP_RANDOM:
+			STATS_ADD(ctx->stats, maths, 1);
 			type = math(ctx, token, math_result, type, 2);
 			break;
 
 		case TOKEN_OP_LIMIT:
 		case TOKEN_OP_INTERPOLATE:
+			STATS_ADD(ctx->stats, maths, 1);
 			type = math(ctx, token, math_result, type, 3);
 			break;
 
 		case TOKEN_CL_RGB:
 		case TOKEN_CL_INTERPOLATE:
+			STATS_ADD(ctx->stats, colors, 1);
 			type = math_cl(ctx, token, math_result, type, 3);
 			break;
 
 		case TOKEN_CL_RGBA:
+			STATS_ADD(ctx->stats, colors, 1);
 			type = math_cl(ctx, token, math_result, type, 4);
 			break;
 
@@ -175,6 +198,76 @@ substitution_apply(struct context *ctx, char token[static TOKEN_MAX_LEN], double
 	return type;
 }
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+enum token
+substitution_defer(struct context *ctx, struct token_view *token, enum token type)
+{
+	if (ctx->depth >= CONTEXT_MAX_DEPTH)
+	{
+		return TOKEN_INVALID;
+	}
+
+	ctx->depth++;
+
+	switch (type)
+	{
+		case TOKEN_COMMENT:
+			type = comment();
+			break;
+
+		case TOKEN_ESCAPE:
+			type = escape(ctx, token);
+			break;
+
+		case TOKEN_VAR_INJECTION:
+		case TOKEN_ITER_INJECTION:
+		case TOKEN_PARAM_INJECTION:
+			type = inject(ctx, token, type);
+			break;
+
+		default:
+			break;
+	}
+
+	ctx->depth--;
+
+	return type;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+bool
+substitution_format(struct context *ctx, struct token_view *token, enum token type, double d)
+{
+	struct memo_slot *slot;
+	bool ok;
+
+	/* formatting a number costs a lot more than looking it up, and the same values keep coming back */
+
+	if (ctx->memo && (slot = memo_find(ctx->memo, type, &d, 1)) && slot->text_len > 0)
+	{
+		token_view_clear(token);
+		return token_view_append(token, slot->text, slot->text_len);
+	}
+
+	if (type == TOKEN_COLOR)
+	{
+		ok = token_view_printf(token, "%u", (uint32_t)d);
+	}
+	else
+	{
+		ok = token_view_printf(token, "%.8f", d);
+	}
+
+	if (ok && ctx->memo && (slot = memo_store(ctx->memo, type, &d, 1, d)))
+	{
+		memo_store_text(slot, token->chars, token->len);
+	}
+
+	return ok;
+}
+
 /************************************************************************************************************/
 /* STATIC ***************************************************************************************************/
 /************************************************************************************************************/
@@ -188,19 +281,22 @@ comment(void)
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 
 static enum token
-condition(struct context *ctx, char token[static TOKEN_MAX_LEN], double *math_result, enum token type)
+condition(struct context *ctx, struct token_view *token, double *math_result, enum token type)
 {
-	char token_2[TOKEN_MAX_LEN];
+	struct token_view token_2;
 	bool result;
 	double a;
 	double b;
 
+	token_view_init(&token_2);
+
 	/* get values to compare */
 
-	if (context_get_token_numeral(ctx, token,   &a) == TOKEN_INVALID
-	 || context_get_token_numeral(ctx, token_2, &b) == TOKEN_INVALID)
+	if (context_get_token_numeral(ctx, token,    &a) == TOKEN_INVALID
+	 || context_get_token_numeral(ctx, &token_2, &b) == TOKEN_INVALID)
 	{
-		return TOKEN_INVALID;	
+		type = TOKEN_INVALID;
+		goto end;
 	}
 	
 	/* execute comparison */
@@ -232,11 +328,12 @@ condition(struct context *ctx, char token[static TOKEN_MAX_LEN], double *math_re
 			break;
 
 		case TOKEN_IF_STR_EQ:
-			result = !strcmp(token, token_2);
+			result = !strcmp(token->chars, token_2.chars);
 			break;
 
 		default:
-			return TOKEN_INVALID;	
+			type = TOKEN_INVALID;
+			goto end;
 	}
 
 	/* get resulting token */
@@ -245,13 +342,18 @@ condition(struct context *ctx, char token[static TOKEN_MAX_LEN], double *math_re
 
 	if (result)
 	{
-		context_get_token(ctx, token_2, NULL);
-		return type;
+		context_get_token(ctx, &token_2, NULL);
 	}
 	else
 	{
-		return context_get_token(ctx, token, math_result);
+		type = context_get_token(ctx, token, math_result);
 	}
+
+end:
+
+	token_view_free(&token_2);
+
+	return type;
 }
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
@@ -259,8 +361,9 @@ condition(struct context *ctx, char token[static TOKEN_MAX_LEN], double *math_re
 static enum token
 eof(struct context *ctx)
 {
-	ctx->eof_reached = true;
-	ctx->eol_reached = true;
+	ctx->eof_reached   = true;
+	ctx->eol_reached   = true;
+	ctx->eof_requested = true;
 
 	return TOKEN_INVALID;
 }
@@ -268,7 +371,7 @@ eof(struct context *ctx)
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 
 static enum token
-escape(struct context *ctx, char token[TOKEN_MAX_LEN])
+escape(struct context *ctx, struct token_view *token)
 {
 	ctx->eol_reached = false;
 
@@ -278,7 +381,7 @@ escape(struct context *ctx, char token[TOKEN_MAX_LEN])
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 
 static enum token
-filler(struct context *ctx, char token[static TOKEN_MAX_LEN], double *math_result)
+filler(struct context *ctx, struct token_view *token, double *math_result)
 {
 	return context_get_token(ctx, token, math_result);
 }
@@ -286,28 +389,88 @@ filler(struct context *ctx, char token[static TOKEN_MAX_LEN], double *math_resul
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 
 static enum token
-join(struct context *ctx, char token[static TOKEN_MAX_LEN])
+inject(struct context *ctx, struct token_view *token, enum token type)
 {
-	char token_a[TOKEN_MAX_LEN];
-	char token_b[TOKEN_MAX_LEN];
+	size_t i;
 
-	if (context_get_token(ctx, token_a, NULL) == TOKEN_INVALID
-	 || context_get_token(ctx, token_b, NULL) == TOKEN_INVALID
-	 || snprintf(token, TOKEN_MAX_LEN, "%s%s", token_a, token_b) < 0)
+	if (context_get_token_raw(ctx, token) == TOKEN_INVALID)
 	{
 		return TOKEN_INVALID;
 	}
 
-	return TOKEN_STRING;
+	STATS_ADD(ctx->stats, matches, 1);
+
+	if (token_match(token->chars) != TOKEN_STRING)
+	{
+		return type;
+	}
+
+	/* same lookups as variable(), variable_iter() and param() */
+
+	switch (type)
+	{
+		case TOKEN_VAR_INJECTION:
+			if (!cdict_find(ctx->keys_vars, token->chars, CONTEXT_DICT_VARIABLE, &ctx->var_group))
+			{
+				return TOKEN_INVALID;
+			}
+			ctx->var_i = 0;
+			return context_get_token_deferred(ctx, token);
+
+		case TOKEN_ITER_INJECTION:
+			if (!cdict_find(ctx->keys_vars, token->chars, CONTEXT_DICT_ITERATION, &i))
+			{
+				return TOKEN_INVALID;
+			}
+			token_view_borrow(token, cbook_word(ctx->vars, i));
+			return TOKEN_STRING;
+
+		case TOKEN_PARAM_INJECTION:
+			if (!cdict_find(ctx->keys_params, token->chars, 0, &i))
+			{
+				return TOKEN_INVALID;
+			}
+			token_view_borrow(token, cbook_word(ctx->params, i));
+			return TOKEN_STRING;
+
+		default:
+			return TOKEN_INVALID;
+	}
 }
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 
 static enum token
-math(struct context *ctx, char token[static TOKEN_MAX_LEN], double *math_result, enum token type, size_t n)
+join(struct context *ctx, struct token_view *token)
 {
+	struct token_view token_b;
+	enum token type = TOKEN_STRING;
+
+	token_view_init(&token_b);
+
+	/* the first half is read straight into the result, so that only the second one has to be copied */
+
+	if (context_get_token(ctx, token,    NULL) == TOKEN_INVALID
+	 || context_get_token(ctx, &token_b, NULL) == TOKEN_INVALID
+	 || !token_view_append(token, token_b.chars, token_b.len))
+	{
+		type = TOKEN_INVALID;
+	}
+
+	token_view_free(&token_b);
+
+	return type;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static enum token
+math(struct context *ctx, struct token_view *token, double *math_result, enum token type, size_t n)
+{
+	const struct memo_slot *slot;
 	double result;
 	double d[3] = {0};
+	bool memoize;
 
 	/* get next few numeral tokens as math functions arguments */
 
@@ -319,6 +482,37 @@ math(struct context *ctx, char token[static TOKEN_MAX_LEN], double *math_result,
 		}
 	}
 
+	/* results of the costlier pure functions are kept for when the same arguments come back */
+
+	switch (type)
+	{
+		case TOKEN_OP_CBRT:
+		case TOKEN_OP_COS:
+		case TOKEN_OP_SIN:
+		case TOKEN_OP_TAN:
+		case TOKEN_OP_ACOS:
+		case TOKEN_OP_ASIN:
+		case TOKEN_OP_ATAN:
+		case TOKEN_OP_COSH:
+		case TOKEN_OP_SINH:
+		case TOKEN_OP_LN:
+		case TOKEN_OP_LOG:
+		case TOKEN_OP_MOD:
+		case TOKEN_OP_POW:
+			memoize = ctx->memo;
+			break;
+
+		default:
+			memoize = false;
+			break;
+	}
+
+	if (memoize && (slot = memo_find(ctx->memo, type, d, n)))
+	{
+		result = slot->result;
+		goto convert;
+	}
+
 	/* apply math operation */
 
 	switch (type)
@@ -327,6 +521,7 @@ math(struct context *ctx, char token[static TOKEN_MAX_LEN], double *math_result,
 
 		case TOKEN_TIMESTAMP:
 			result = time(NULL);
+			cache_taint(ctx);
 			break;
 
 		case TOKEN_CONST_PI:
@@ -465,15 +660,22 @@ math(struct context *ctx, char token[static TOKEN_MAX_LEN], double *math_result,
 			return TOKEN_INVALID;
 	}
 
+	if (memoize)
+	{
+		memo_store(ctx->memo, type, d, n, result);
+	}
+
+convert:
+
 	/* if needed convert back the result into a string */
 
 	if (math_result)
 	{
 		*math_result = result;
 	}
-	else
+	else if (!substitution_format(ctx, token, TOKEN_NUMBER, result))
 	{
-		snprintf(token, TOKEN_MAX_LEN, "%.8f", result);
+		return TOKEN_INVALID;
 	}
 
 	return TOKEN_NUMBER;
@@ -482,14 +684,16 @@ math(struct context *ctx, char token[static TOKEN_MAX_LEN], double *math_result,
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 
 static enum token
-math_cl(struct context *ctx, char token[static TOKEN_MAX_LEN], double *math_result, enum token type, size_t n)
+math_cl(struct context *ctx, struct token_view *token, double *math_result, enum token type, size_t n)
 {
+	const struct memo_slot *slot;
 	struct ccolor result;
 	struct ccolor cl[4] = {0};
 
 	double d[4] = {0};
+	double argb;
 
-	/* get next few numeral tokens as math functions arguments and convert them into colors */
+	/* get next few numeral tokens as math functions arguments */
 
 	for (size_t i = 0; i < n; i++)
 	{
@@ -497,10 +701,22 @@ math_cl(struct context *ctx, char token[static TOKEN_MAX_LEN], double *math_resu
 		{
 			return TOKEN_INVALID;
 		}
-		cl[i] = ccolor_from_argb_uint(d[i]);
 	}
 
-	/* apply math operation */
+	/* color operations are pure, their results are kept for when the same arguments come back */
+
+	if (ctx->memo && (slot = memo_find(ctx->memo, type, d, n)))
+	{
+		argb = slot->result;
+		goto convert;
+	}
+
+	/* convert the arguments into colors and apply math operation */
+
+	for (size_t i = 0; i < n; i++)
+	{
+		cl[i] = ccolor_from_argb_uint(d[i]);
+	}
 
 	switch (type)
 	{
@@ -526,34 +742,57 @@ math_cl(struct context *ctx, char token[static TOKEN_MAX_LEN], double *math_resu
 			return TOKEN_INVALID;
 	}
 
+	argb = ccolor_to_argb_uint(result);
+
+	if (ctx->memo)
+	{
+		memo_store(ctx->memo, type, d, n, argb);
+	}
+
+convert:
+
 	/* if needed convert back the result into a string */
 
 	if (math_result)
 	{
-		*math_result = ccolor_to_argb_uint(result);
+		*math_result = argb;
 	}
-	else
+	else if (!substitution_format(ctx, token, TOKEN_COLOR, argb))
 	{
-		snprintf(token, TOKEN_MAX_LEN, "%u", ccolor_to_argb_uint(result));
+		return TOKEN_INVALID;
 	}
 
-	return TOKEN_NUMBER;
+	return TOKEN_COLOR;
 }
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 
 static enum token
-param(struct context *ctx, char token[static TOKEN_MAX_LEN])
+param(struct context *ctx, struct token_view *token)
 {
 	size_t i; 
+	bool found;
 
-	if (context_get_token(ctx, token, NULL) == TOKEN_INVALID
-	 || !cdict_find(ctx->keys_params, token, 0, &i))
+	if (context_get_token(ctx, token, NULL) == TOKEN_INVALID)
+	{
+		return TOKEN_INVALID;
+	}
+
+	/* missing params are tracked too, since setting them would change the outcome */
+
+	found = cdict_find(ctx->keys_params, token->chars, 0, &i);
+
+	if (ctx->taint)
+	{
+		taint_param(ctx->taint, token->chars, found ? cbook_word(ctx->params, i) : NULL);
+	}
+
+	if (!found)
 	{
 		return TOKEN_INVALID;
 	}
 
-	snprintf(token, TOKEN_MAX_LEN, "%s", cbook_word(ctx->params, i));
+	token_view_borrow(token, cbook_word(ctx->params, i));
 	
 	return TOKEN_STRING;
 }
@@ -561,14 +800,21 @@ param(struct context *ctx, char token[static TOKEN_MAX_LEN])
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 
 static enum token
-variable(struct context *ctx, char token[static TOKEN_MAX_LEN], double *math_result)
+variable(struct context *ctx, struct token_view *token, double *math_result)
 {
+	size_t mark = ctx->taint ? taint_mark(ctx->taint) : 0;
+
 	if (context_get_token(ctx, token, NULL) == TOKEN_INVALID
-	 || !cdict_find(ctx->keys_vars, token, CONTEXT_DICT_VARIABLE, &ctx->var_group))
+	 || !cdict_find(ctx->keys_vars, token->chars, CONTEXT_DICT_VARIABLE, &ctx->var_group))
 	{
 		return TOKEN_INVALID;
 	}
 
+	if (ctx->taint)
+	{
+		taint_inject(ctx->taint, mark, ctx->var_group);
+	}
+
 	ctx->var_i = 0;
 
 	return context_get_token(ctx, token, math_result);
@@ -577,17 +823,23 @@ variable(struct context *ctx, char token[static TOKEN_MAX_LEN], double *math_res
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 
 static enum token
-variable_iter(struct context *ctx, char token[static TOKEN_MAX_LEN])
+variable_iter(struct context *ctx, struct token_view *token)
 {
+	size_t mark = ctx->taint ? taint_mark(ctx->taint) : 0;
 	size_t i;
 
 	if (context_get_token(ctx, token, NULL) == TOKEN_INVALID
-	 || !cdict_find(ctx->keys_vars, token, CONTEXT_DICT_ITERATION, &i))
+	 || !cdict_find(ctx->keys_vars, token->chars, CONTEXT_DICT_ITERATION, &i))
 	{
 		return TOKEN_INVALID;
 	}
 
-	snprintf(token, TOKEN_MAX_LEN, "%s", cbook_word(ctx->vars, i));
+	if (ctx->taint)
+	{
+		taint_iterate(ctx->taint, mark, cbook_word(ctx->vars, i));
+	}
+
+	token_view_borrow(token, cbook_word(ctx->vars, i));
 
 	return TOKEN_STRING;
 }
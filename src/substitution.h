@@ -21,6 +21,7 @@
 #pragma once
 
 #include <cassette/ccfg.h>
+#include <stdbool.h>
 
 #include "context.h"
 
@@ -29,5 +30,31 @@
 /************************************************************************************************************/
 
 enum token
-substitution_apply(struct context *ctx, char token[static TOKEN_MAX_LEN], double *math_result)
+substitution_apply(struct context *ctx, struct token_view *token, double *math_result, enum token type)
+CCFG_NONNULL(1, 2)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Counterpart of substitution_apply() for values whose evaluation gets deferred. Only the substitutions that
+ * depend on the parser state are applied: injections lead to the first word they inject, without it being
+ * evaluated, and injected or escaped words are returned as TOKEN_STRING. Any other token is returned as is,
+ * without reading further. Injections whose name is not a plain string are left as is too, since their name
+ * could only be told by evaluating it.
+ */
+enum token
+substitution_defer(struct context *ctx, struct token_view *token, enum token type)
+CCFG_NONNULL(1, 2)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Writes the string form of a number, or of a color if type is TOKEN_COLOR, into token. Returns false if
+ * memory could not be allocated.
+ */
+bool
+substitution_format(struct context *ctx, struct token_view *token, enum token type, double d)
+CCFG_NONNULL(1, 2)
 CCFG_HIDDEN;
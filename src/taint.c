@@ -0,0 +1,715 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+#include <cassette/ccfg.h>
+#include <cassette/cobj.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "context.h"
+#include "numbers.h"
+#include "taint.h"
+#include "token.h"
+#include "util.h"
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#define TAINT_KEY_LEN 24
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+static void append      (struct taint *, const char *)                                              CCFG_NONNULL(1, 2);
+static void copy_values (cbook *, struct numbers *, const cbook *, const struct numbers *, size_t) CCFG_NONNULL(1, 2, 3, 4);
+static void refer       (struct taint *, size_t)                                                    CCFG_NONNULL(1);
+static void roll_back   (struct taint *, size_t)                                                    CCFG_NONNULL(1);
+
+/************************************************************************************************************/
+/* PRIVATE **************************************************************************************************/
+/************************************************************************************************************/
+
+uint64_t
+taint_changes(struct taint *taint, const cbook *params, const cdict *keys_params)
+{
+	const char *name;
+	const char *value;
+	const char *value_prev;
+	cbook *params_new;
+	uint64_t mask = 0;
+	size_t i;
+
+	params_new = cbook_create();
+
+	/* groups are written again in the same order, so that the indexes of the params stay valid */
+
+	for (size_t g = 0; g < cbook_groups_number(taint->params); g++)
+	{
+		name       = cbook_word_in_group(taint->params, g, 0);
+		value_prev = cbook_group_length(taint->params, g) > 1 ? cbook_word_in_group(taint->params, g, 1) : NULL;
+		value      = cdict_find(keys_params, name, 0, &i) ? cbook_word(params, i) : NULL;
+
+		if (!value != !value_prev || (value && strcmp(value, value_prev)))
+		{
+			mask |= (uint64_t)1 << (g % 64);
+		}
+
+		cbook_prepare_new_group(params_new);
+		cbook_write(params_new, name);
+		if (value)
+		{
+			cbook_write(params_new, value);
+		}
+	}
+
+	if (cbook_error(params_new))
+	{
+		cbook_destroy(params_new);
+		taint->err = true;
+		return 0;
+	}
+
+	cbook_destroy(taint->params);
+
+	taint->params = params_new;
+
+	return mask;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+taint_clear(struct taint *taint)
+{
+	cbook_clear(taint->lines);
+	cbook_clear(taint->params);
+	cbook_clear(taint->vars);
+	cbook_clear(taint->values);
+	cdict_clear(taint->keys_params);
+	cdict_clear(taint->keys_vars);
+	numbers_clear(&taint->numbers);
+
+	taint->entries_n  = 0;
+	taint->groups_n   = 0;
+	taint->results_n  = 0;
+	taint->line_n     = 0;
+	taint->line_last  = 0;
+	taint->mask       = 0;
+	taint->held       = 0;
+	taint->recording  = false;
+	taint->skipped    = false;
+	taint->structural = false;
+	taint->valid      = false;
+	taint->err        = false;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+taint_copy(struct taint *taint, const struct taint *src)
+{
+	struct taint_entry *entries;
+	size_t *results;
+
+	taint_clear(taint);
+
+	/* groups only map the parser's variable book during the load, so there is nothing to copy from them */
+
+	if (src->entries_n > 0)
+	{
+		if (!(entries = util_reserve(taint->entries, &taint->entries_cap, src->entries_n, sizeof(*entries))))
+		{
+			taint->err = true;
+			return;
+		}
+		memcpy(entries, src->entries, src->entries_n * sizeof(*entries));
+		taint->entries = entries;
+	}
+
+	if (src->results_n > 0)
+	{
+		if (!(results = util_reserve(taint->results, &taint->results_cap, src->results_n, sizeof(*results))))
+		{
+			taint->err = true;
+			return;
+		}
+		memcpy(results, src->results, src->results_n * sizeof(*results));
+		taint->results = results;
+	}
+
+	cbook_destroy(taint->lines);
+	cbook_destroy(taint->params);
+	cbook_destroy(taint->vars);
+	cbook_destroy(taint->values);
+	cdict_destroy(taint->keys_params);
+	cdict_destroy(taint->keys_vars);
+
+	taint->lines       = cbook_clone(src->lines);
+	taint->params      = cbook_clone(src->params);
+	taint->vars        = cbook_clone(src->vars);
+	taint->values      = cbook_clone(src->values);
+	taint->keys_params = cdict_clone(src->keys_params);
+	taint->keys_vars   = cdict_clone(src->keys_vars);
+	taint->entries_n   = src->entries_n;
+	taint->results_n   = src->results_n;
+	taint->structural  = src->structural;
+	taint->valid       = src->valid;
+
+	numbers_copy(&taint->numbers, &src->numbers);
+
+	taint->err = cbook_error(taint->lines)
+	          || cbook_error(taint->params)
+	          || cbook_error(taint->vars)
+	          || cbook_error(taint->values)
+	          || cdict_error(taint->keys_params)
+	          || cdict_error(taint->keys_vars)
+	          || taint->numbers.err;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+uint64_t
+taint_enter(struct taint *taint)
+{
+	uint64_t mask = taint->mask;
+
+	taint->mask = 0;
+
+	return mask;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+taint_free(struct taint *taint)
+{
+	cbook_destroy(taint->lines);
+	cbook_destroy(taint->params);
+	cbook_destroy(taint->vars);
+	cbook_destroy(taint->values);
+	cdict_destroy(taint->keys_params);
+	cdict_destroy(taint->keys_vars);
+	numbers_free(&taint->numbers);
+	free(taint->entries);
+	free(taint->groups);
+	free(taint->results);
+	free(taint->line);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+taint_init(struct taint *taint)
+{
+	taint->lines       = cbook_create();
+	taint->params      = cbook_create();
+	taint->vars        = cbook_create();
+	taint->values      = cbook_create();
+	taint->keys_params = cdict_create();
+	taint->keys_vars   = cdict_create();
+	taint->entries     = NULL;
+	taint->groups      = NULL;
+	taint->results     = NULL;
+	taint->line        = NULL;
+	taint->entries_n   = 0;
+	taint->entries_cap = 0;
+	taint->groups_n    = 0;
+	taint->groups_cap  = 0;
+	taint->results_n   = 0;
+	taint->results_cap = 0;
+	taint->line_n      = 0;
+	taint->line_cap    = 0;
+	taint->line_last   = 0;
+	taint->mask        = 0;
+	taint->held        = 0;
+	taint->recording   = false;
+	taint->skipped     = false;
+	taint->structural  = false;
+	taint->valid       = false;
+	taint->enabled     = false;
+	taint->err         = false;
+
+	numbers_init(&taint->numbers);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+taint_inject(struct taint *taint, size_t mark, size_t group)
+{
+	const struct taint_group *tg = group < taint->groups_n ? taint->groups + group : NULL;
+	char key[TAINT_KEY_LEN];
+
+	if (tg)
+	{
+		taint->mask |= tg->mask;
+	}
+
+	if (!taint->recording)
+	{
+		return;
+	}
+
+	/* an injection token read from a tainted variable cannot be told apart from the reference to it */
+
+	if (mark == SIZE_MAX)
+	{
+		taint->structural = true;
+		return;
+	}
+
+	roll_back(taint, mark);
+
+	if (tg && tg->mask)
+	{
+		snprintf(key, TAINT_KEY_LEN, "%zu", tg->entry);
+		append(taint, "$");
+		append(taint, key);
+	}
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+taint_iterate(struct taint *taint, size_t mark, const char *value)
+{
+	if (!taint->recording)
+	{
+		return;
+	}
+
+	if (mark == SIZE_MAX)
+	{
+		taint->structural = true;
+		return;
+	}
+
+	/* iterator values are injected as plain strings, they are escaped if they would be read as tokens */
+
+	roll_back(taint, mark);
+
+	if (token_match(value) != TOKEN_STRING)
+	{
+		append(taint, "\\");
+	}
+
+	append(taint, value);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+taint_keep(struct taint *taint, size_t entry, size_t values)
+{
+	size_t *tmp;
+	size_t i;
+
+	/* entries get evaluated again in declaration order, so they are usually appended */
+
+	if (taint->entries[entry].result != SIZE_MAX)
+	{
+		taint->entries[entry].result = values;
+		return;
+	}
+
+	if (!(tmp = util_reserve(taint->results, &taint->results_cap, taint->results_n + 1, sizeof(*tmp))))
+	{
+		taint->err = true;
+		return;
+	}
+
+	taint->results = tmp;
+
+	for (i = taint->results_n; i > 0 && taint->entries[tmp[i - 1]].values > taint->entries[entry].values; i--)
+	{
+		tmp[i] = tmp[i - 1];
+	}
+
+	tmp[i] = entry;
+
+	taint->entries[entry].result = values;
+	taint->results_n++;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+taint_leave(struct taint *taint, uint64_t mask)
+{
+	if (taint->mask)
+	{
+		taint->structural = true;
+	}
+
+	taint->mask = mask;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+size_t
+taint_mark(const struct taint *taint)
+{
+	return taint->skipped ? SIZE_MAX : taint->line_last;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+size_t
+taint_overlay(const struct taint *taint, size_t group)
+{
+	const struct taint_entry *entry;
+	size_t low  = 0;
+	size_t high = taint->results_n;
+	size_t mid;
+
+	while (low < high)
+	{
+		mid   = low + (high - low) / 2;
+		entry = taint->entries + taint->results[mid];
+		if (entry->values == group)
+		{
+			return entry->result;
+		}
+		if (entry->values < group)
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid;
+		}
+	}
+
+	return SIZE_MAX;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+taint_param(struct taint *taint, const char *name, const char *value)
+{
+	size_t i;
+
+	if (!cdict_find(taint->keys_params, name, 0, &i))
+	{
+		i = cbook_groups_number(taint->params);
+		cbook_prepare_new_group(taint->params);
+		cbook_write(taint->params, name);
+		if (value)
+		{
+			cbook_write(taint->params, value);
+		}
+		cdict_write(taint->keys_params, name, 0, i);
+	}
+
+	taint->mask |= (uint64_t)1 << (i % 64);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+taint_read(struct taint *taint, const char *word, size_t group)
+{
+	if (!taint->recording)
+	{
+		return;
+	}
+
+	taint->line_last = taint->line_n;
+	taint->skipped   = group < taint->groups_n && taint->groups[group].mask;
+
+	if (!taint->skipped)
+	{
+		append(taint, word);
+	}
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+taint_rebind(struct taint *taint, size_t entry)
+{
+	taint->entries[entry].values = cbook_groups_number(taint->vars) - 1;
+
+	refer(taint, entry);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+taint_settle(struct taint *taint, cbook **sequences, struct numbers *numbers)
+{
+	struct taint_entry *entry;
+	struct numbers numbers_new;
+	cbook *sequences_new;
+	cbook *vars_new;
+	size_t e = 0;
+
+	sequences_new = cbook_create();
+	vars_new      = cbook_create();
+	numbers_init(&numbers_new);
+
+	/* resources were declared in order, so their entries are walked along with the sequence groups */
+
+	for (size_t g = 0; g < cbook_groups_number(*sequences); g++)
+	{
+		while (e < taint->entries_n && (taint->entries[e].variable || taint->entries[e].values < g))
+		{
+			e++;
+		}
+		cbook_prepare_new_group(sequences_new);
+		if (e < taint->entries_n && taint->entries[e].values == g && taint->entries[e].result != SIZE_MAX)
+		{
+			copy_values(sequences_new, &numbers_new, taint->values, &taint->numbers, taint->entries[e].result);
+		}
+		else
+		{
+			copy_values(sequences_new, &numbers_new, *sequences, numbers, g);
+		}
+	}
+
+	/* only the last values of each variable are kept */
+
+	for (size_t i = 0; i < taint->entries_n; i++)
+	{
+		entry = taint->entries + i;
+		if (entry->variable)
+		{
+			cbook_prepare_new_group(vars_new);
+			for (size_t k = 0; k < cbook_group_length(taint->vars, entry->values); k++)
+			{
+				cbook_write(vars_new, cbook_word_in_group(taint->vars, entry->values, k));
+			}
+			entry->values = cbook_groups_number(vars_new) - 1;
+		}
+		entry->result = SIZE_MAX;
+	}
+
+	if (cbook_error(sequences_new) || cbook_error(vars_new) || numbers_new.err)
+	{
+		cbook_destroy(sequences_new);
+		cbook_destroy(vars_new);
+		numbers_free(&numbers_new);
+		taint->err = true;
+		return;
+	}
+
+	cbook_destroy(*sequences);
+	cbook_destroy(taint->vars);
+	numbers_free(numbers);
+
+	*sequences  = sequences_new;
+	*numbers    = numbers_new;
+	taint->vars = vars_new;
+
+	for (size_t i = 0; i < taint->entries_n; i++)
+	{
+		if (taint->entries[i].variable)
+		{
+			refer(taint, i);
+		}
+	}
+
+	cbook_clear(taint->values);
+	numbers_clear(&taint->numbers);
+
+	taint->results_n = 0;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+taint_start(struct taint *taint)
+{
+	taint->held      = taint->mask;
+	taint->mask      = 0;
+	taint->line_n    = 0;
+	taint->line_last = 0;
+	taint->skipped   = false;
+	taint->recording = true;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+taint_stop(struct taint *taint, const cbook *vars, size_t group, size_t depth)
+{
+	struct taint_entry *entry;
+	struct taint_entry *tmp;
+	struct taint_group *tmp_groups;
+	uint64_t mask = taint->mask;
+
+	taint->recording = false;
+	taint->mask      = taint->held;
+
+	if (mask == 0)
+	{
+		return;
+	}
+
+	if (group == SIZE_MAX)
+	{
+		taint->structural = true;
+		return;
+	}
+
+	if (!(tmp = util_reserve(taint->entries, &taint->entries_cap, taint->entries_n + 1, sizeof(*tmp))))
+	{
+		taint->err = true;
+		return;
+	}
+
+	taint->entries = tmp;
+
+	entry = taint->entries + taint->entries_n;
+	entry->line     = cbook_words_number(taint->lines);
+	entry->values   = group;
+	entry->result   = SIZE_MAX;
+	entry->depth    = depth;
+	entry->mask     = mask;
+	entry->variable = vars != NULL;
+
+	cbook_write(taint->lines, taint->line_n > 0 ? taint->line : "");
+
+	/* variables get referred to by their entry, and their values are copied out of the parser's book */
+
+	if (vars)
+	{
+		if (!(tmp_groups = util_reserve(taint->groups, &taint->groups_cap, group + 1, sizeof(*tmp_groups))))
+		{
+			taint->err = true;
+			return;
+		}
+		taint->groups = tmp_groups;
+		for (; taint->groups_n <= group; taint->groups_n++)
+		{
+			taint->groups[taint->groups_n].mask  = 0;
+			taint->groups[taint->groups_n].entry = SIZE_MAX;
+		}
+		taint->groups[group].mask  = mask;
+		taint->groups[group].entry = taint->entries_n;
+
+		cbook_prepare_new_group(taint->vars);
+		for (size_t k = 0; k < cbook_group_length(vars, group); k++)
+		{
+			cbook_write(taint->vars, cbook_word_in_group(vars, group, k));
+		}
+		entry->values = cbook_groups_number(taint->vars) - 1;
+		refer(taint, taint->entries_n);
+	}
+
+	taint->entries_n++;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+taint_use(struct taint *taint, size_t group)
+{
+	if (group < taint->groups_n)
+	{
+		taint->mask |= taint->groups[group].mask;
+	}
+}
+
+/************************************************************************************************************/
+/* STATIC ***************************************************************************************************/
+/************************************************************************************************************/
+
+static void
+append(struct taint *taint, const char *word)
+{
+	char *tmp;
+	size_t len = strlen(word);
+
+	/* each word is double quoted, and its double quotes are written single quoted in between */
+
+	if (len > (SIZE_MAX - taint->line_n - 4) / 5
+	 || !(tmp = util_reserve(taint->line, &taint->line_cap, taint->line_n + len * 5 + 4, 1)))
+	{
+		taint->err = true;
+		return;
+	}
+
+	taint->line = tmp;
+
+	if (taint->line_n > 0)
+	{
+		taint->line[taint->line_n++] = ' ';
+	}
+
+	taint->line[taint->line_n++] = '"';
+	for (size_t i = 0; i < len; i++)
+	{
+		if (word[i] == '"')
+		{
+			memcpy(taint->line + taint->line_n, "\"'\"'\"", 5);
+			taint->line_n += 5;
+		}
+		else
+		{
+			taint->line[taint->line_n++] = word[i];
+		}
+	}
+	taint->line[taint->line_n++] = '"';
+	taint->line[taint->line_n]   = '\0';
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+copy_values(cbook *book, struct numbers *numbers, const cbook *src, const struct numbers *src_numbers,
+            size_t group)
+{
+	for (size_t i = 0; i < cbook_group_length(src, group); i++)
+	{
+		cbook_write(book, cbook_word_in_group(src, group, i));
+		numbers_push(numbers, numbers_get(src_numbers, cbook_word_index(src, group, i)));
+	}
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+refer(struct taint *taint, size_t entry)
+{
+	char key[TAINT_KEY_LEN];
+
+	snprintf(key, TAINT_KEY_LEN, "%zu", entry);
+
+	cdict_write(taint->keys_vars, key, CONTEXT_DICT_VARIABLE, taint->entries[entry].values);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+roll_back(struct taint *taint, size_t mark)
+{
+	taint->line_n = mark;
+
+	if (taint->line)
+	{
+		taint->line[mark] = '\0';
+	}
+}
@@ -0,0 +1,312 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+#pragma once
+
+#include <cassette/ccfg.h>
+#include <cassette/cobj.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "numbers.h"
+
+/************************************************************************************************************/
+/* TYPES ****************************************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * Resource or variable whose values were read from at least one param, directly or through other tainted
+ * variables. The values are written down again as a line of source, in which the tainted variables that were
+ * injected are referred to by the index of their own entry, so that they can be evaluated once more without
+ * the rest of the sources. Values is the sequence group of a resource, or the group of the taint's variable
+ * book holding the current values of a variable. The mask has one bit per param read, picked by the index of
+ * the param modulo 64. Result is the group of the values book the resource got evaluated to again, if any.
+ */
+struct taint_entry
+{
+	size_t line;
+	size_t values;
+	size_t result;
+	size_t depth;
+	uint64_t mask;
+	bool variable;
+};
+
+/**
+ * Params a group of the parser's variable book was read from, and the entry its values were kept as, if any.
+ */
+struct taint_group
+{
+	uint64_t mask;
+	size_t entry;
+};
+
+/**
+ * Dependencies of resources over params, gathered during a load. Params that were read are kept as groups of
+ * their name followed by the value they had, if any, and are looked up by name. Groups follow the ones of the
+ * parser's variable book, and are only used during the load.
+ *
+ * A load is structural once a param got read by anything else than the values of a resource or of a
+ * variable, such as a resource name, a section or an iteration. Params then decide which sequences get
+ * evaluated, and only loading the sources again can account for a change.
+ *
+ * Results lists the entries of the resources evaluated again but not settled yet, by increasing sequence
+ * group, so that their values can be looked up over a sequence book shared with other configs.
+ */
+struct taint
+{
+	cbook *lines;
+	cbook *params;
+	cbook *vars;
+	cbook *values;
+	cdict *keys_params;
+	cdict *keys_vars;
+	struct numbers numbers;
+	struct taint_entry *entries;
+	struct taint_group *groups;
+	size_t *results;
+	char *line;
+	size_t entries_n;
+	size_t entries_cap;
+	size_t groups_n;
+	size_t groups_cap;
+	size_t results_n;
+	size_t results_cap;
+	size_t line_n;
+	size_t line_cap;
+	size_t line_last;
+	uint64_t mask;
+	uint64_t held;
+	bool recording;
+	bool skipped;
+	bool structural;
+	bool valid;
+	bool enabled;
+	bool err;
+};
+
+/************************************************************************************************************/
+/* CONSTRUCTORS / DESTRUCTORS *******************************************************************************/
+/************************************************************************************************************/
+
+void
+taint_init(struct taint *taint)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+taint_free(struct taint *taint)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/************************************************************************************************************/
+/* PROCEDURES ***********************************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * Gets the mask of the params whose value changed since the load, or since the last call, and takes note of
+ * their new value.
+ */
+uint64_t
+taint_changes(struct taint *taint, const cbook *params, const cdict *keys_params)
+CCFG_NONNULL(1, 2, 3)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Drops every dependency. Whether tracking is enabled is kept.
+ */
+void
+taint_clear(struct taint *taint)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Replaces the dependencies with a copy of the ones of src, whose params can then be changed and evaluated
+ * again without affecting src. Whether tracking is enabled is kept.
+ */
+void
+taint_copy(struct taint *taint, const struct taint *src)
+CCFG_NONNULL(1, 2)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Starts a new sequence, and returns the params read so far by the sequence it is run from, which are to be
+ * handed back to taint_leave().
+ */
+uint64_t
+taint_enter(struct taint *taint)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Takes note that a variable of the parser's variable book was injected. Mark is the value given by
+ * taint_mark() right after the injection token was read. Within values, the words read so far from the
+ * injection get replaced by a reference to the variable if it is tainted, and are dropped otherwise, since
+ * its values get written down as they are read.
+ */
+void
+taint_inject(struct taint *taint, size_t mark, size_t group)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Same as taint_inject(), but for an iterator, whose value gets written down instead.
+ */
+void
+taint_iterate(struct taint *taint, size_t mark, const char *value)
+CCFG_NONNULL(1, 3)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Takes note that the resource of an entry got evaluated again to the given group of the values book.
+ */
+void
+taint_keep(struct taint *taint, size_t entry, size_t values)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Ends the sequence started by the last call to taint_enter(). Params read outside of values make the load
+ * structural.
+ */
+void
+taint_leave(struct taint *taint, uint64_t mask)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Takes note that a param was read, value is NULL if it was not set.
+ */
+void
+taint_param(struct taint *taint, const char *name, const char *value)
+CCFG_NONNULL(1, 2)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Writes down a word read by the parser, if values are being recorded. Group is the group of the parser's
+ * variable book the word was read from, or SIZE_MAX if it comes from a source. Words of tainted variables
+ * are skipped, since they are already referred to.
+ */
+void
+taint_read(struct taint *taint, const char *word, size_t group)
+CCFG_NONNULL(1, 2)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Points the references to the entry of a variable to the last group of the variable book, which holds its
+ * values evaluated once more.
+ */
+void
+taint_rebind(struct taint *taint, size_t entry)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Rebuilds the sequence book with the values of every resource evaluated again since the last call, and
+ * compacts the variable book. Sequence groups keep the same indexes.
+ */
+void
+taint_settle(struct taint *taint, cbook **sequences, struct numbers *numbers)
+CCFG_NONNULL(1, 2, 3)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Starts recording the values of a resource or variable.
+ */
+void
+taint_start(struct taint *taint)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Stops recording values, and keeps them as an entry if they were read from a param. Vars is the parser's
+ * variable book if the values are the ones of a variable, NULL if they are the ones of a resource. Group is
+ * the group the values were written to, or SIZE_MAX if there were none, at which point a param decided
+ * whether the resource or variable exists, and the load becomes structural. Depth is the one the values got
+ * evaluated at.
+ */
+void
+taint_stop(struct taint *taint, const cbook *vars, size_t group, size_t depth)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Takes note that a group of the parser's variable book was read outside of values, such as by an iteration.
+ */
+void
+taint_use(struct taint *taint, size_t group)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/************************************************************************************************************/
+/* FUNCTIONS ************************************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * Gets the position taint_inject() and taint_iterate() roll the recorded values back to. Returns SIZE_MAX if
+ * the last word read was skipped.
+ */
+size_t
+taint_mark(const struct taint *taint)
+CCFG_NONNULL(1)
+CCFG_HIDDEN
+CCFG_PURE;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Gets the group of the values book the resource of a sequence group got evaluated again to, or SIZE_MAX if
+ * its values in the sequence book still stand.
+ */
+size_t
+taint_overlay(const struct taint *taint, size_t group)
+CCFG_NONNULL(1)
+CCFG_HIDDEN
+CCFG_PURE;
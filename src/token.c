@@ -18,8 +18,14 @@
 /************************************************************************************************************/
 /************************************************************************************************************/
 
-#include <cassette/cobj.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "token.h"
 
@@ -27,6 +33,12 @@
 /************************************************************************************************************/
 /************************************************************************************************************/
 
+#define MAP_N (sizeof(map) / sizeof(struct slot))
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
 struct slot
 {
 	const char *key;
@@ -37,121 +49,331 @@ struct slot
 /************************************************************************************************************/
 /************************************************************************************************************/
 
+static void   index_build (void);
+static char * reserve     (struct token_view *, size_t) CCFG_NONNULL(1);
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
 static const struct slot map[] =
 {
 	/* substitution tokens */
 
-	{ "EOF",           TOKEN_EOF              },
-	{ "",              TOKEN_INVALID          },
-	{ "//",            TOKEN_COMMENT          },
-	{ "EOS",           TOKEN_COMMENT          },
-	{ "=",             TOKEN_FILLER           },
-	{ ":=",            TOKEN_FILLER           },
-	{ "JOIN",          TOKEN_JOIN             },
-	{ "\\",            TOKEN_ESCAPE           },
-	{ "$",             TOKEN_VAR_INJECTION    },
-	{ "%",             TOKEN_ITER_INJECTION   },
-	{ "$$",            TOKEN_PARAM_INJECTION  },
-	{ "VAR",           TOKEN_VAR_INJECTION    },
-	{ "ITER",          TOKEN_ITER_INJECTION   },
-	{ "PARAM",         TOKEN_PARAM_INJECTION  },
-
-	{ "<",             TOKEN_IF_LESS          },
-	{ "<=",            TOKEN_IF_LESS_EQ       },
-	{ ">",             TOKEN_IF_MORE          },
-	{ ">=",            TOKEN_IF_MORE_EQ       },
-	{ "==",            TOKEN_IF_EQ            },
-	{ "!=",            TOKEN_IF_EQ_NOT        },
-	{ "STREQ",         TOKEN_IF_STR_EQ        },
-
-	{ "TIME",          TOKEN_TIMESTAMP        },
-
-	{ "PI",            TOKEN_CONST_PI         },
-	{ "E",             TOKEN_CONST_EULER      },
-	{ "TRUE",          TOKEN_CONST_TRUE       },
-	{ "FALSE",         TOKEN_CONST_FALSE      },
-
-	{ "SQRT",          TOKEN_OP_SQRT          },
-	{ "CBRT",          TOKEN_OP_CBRT          },
-	{ "ABS",           TOKEN_OP_ABS           },
-	{ "CEIL",          TOKEN_OP_CEILING       },
-	{ "FLOOR",         TOKEN_OP_FLOOR         },
-	{ "ROUND",         TOKEN_OP_ROUND         },
-	{ "COS",           TOKEN_OP_COS           },
-	{ "SIN",           TOKEN_OP_SIN           },
-	{ "TAN",           TOKEN_OP_TAN           },
-	{ "ACOS",          TOKEN_OP_ACOS          },
-	{ "ASIN",          TOKEN_OP_ASIN          },
-	{ "ATAN",          TOKEN_OP_ATAN          },
-	{ "COSH",          TOKEN_OP_COSH          },
-	{ "SINH",          TOKEN_OP_SINH          },
-	{ "LN",            TOKEN_OP_LN            },
-	{ "LOG",           TOKEN_OP_LOG           },
-	{ "+",             TOKEN_OP_ADD           },
-	{ "-",             TOKEN_OP_SUBSTRACT     },
-	{ "*",             TOKEN_OP_MULTIPLY      },
-	{ "/",             TOKEN_OP_DIVIDE        },
-	{ "MOD",           TOKEN_OP_MOD           },
-	{ "POW",           TOKEN_OP_POW           },
-	{ "BIG",           TOKEN_OP_BIGGEST       },
-	{ "SMALL",         TOKEN_OP_SMALLEST      },
-	{ "RAND",          TOKEN_OP_RANDOM        },
-	{ "ITRPL",         TOKEN_OP_INTERPOLATE   },
-	{ "LIMIT",         TOKEN_OP_LIMIT         },
-
-	{ "CITRPL",        TOKEN_CL_INTERPOLATE   },
-	{ "RGB",           TOKEN_CL_RGB           },
-	{ "RGBA",          TOKEN_CL_RGBA          },
+	{ "EOF",              TOKEN_EOF              },
+	{ "",                 TOKEN_INVALID          },
+	{ "//",               TOKEN_COMMENT          },
+	{ "EOS",              TOKEN_COMMENT          },
+	{ "=",                TOKEN_FILLER           },
+	{ ":=",               TOKEN_FILLER           },
+	{ "JOIN",             TOKEN_JOIN             },
+	{ "\\",               TOKEN_ESCAPE           },
+	{ "$",                TOKEN_VAR_INJECTION    },
+	{ "%",                TOKEN_ITER_INJECTION   },
+	{ "$$",               TOKEN_PARAM_INJECTION  },
+	{ "VAR",              TOKEN_VAR_INJECTION    },
+	{ "ITER",             TOKEN_ITER_INJECTION   },
+	{ "PARAM",            TOKEN_PARAM_INJECTION  },
+
+	{ "<",                TOKEN_IF_LESS          },
+	{ "<=",               TOKEN_IF_LESS_EQ       },
+	{ ">",                TOKEN_IF_MORE          },
+	{ ">=",               TOKEN_IF_MORE_EQ       },
+	{ "==",               TOKEN_IF_EQ            },
+	{ "!=",               TOKEN_IF_EQ_NOT        },
+	{ "STREQ",            TOKEN_IF_STR_EQ        },
+
+	{ "TIME",             TOKEN_TIMESTAMP        },
+
+	{ "PI",               TOKEN_CONST_PI         },
+	{ "E",                TOKEN_CONST_EULER      },
+	{ "TRUE",             TOKEN_CONST_TRUE       },
+	{ "FALSE",            TOKEN_CONST_FALSE      },
+
+	{ "SQRT",             TOKEN_OP_SQRT          },
+	{ "CBRT",             TOKEN_OP_CBRT          },
+	{ "ABS",              TOKEN_OP_ABS           },
+	{ "CEIL",             TOKEN_OP_CEILING       },
+	{ "FLOOR",            TOKEN_OP_FLOOR         },
+	{ "ROUND",            TOKEN_OP_ROUND         },
+	{ "COS",              TOKEN_OP_COS           },
+	{ "SIN",              TOKEN_OP_SIN           },
+	{ "TAN",              TOKEN_OP_TAN           },
+	{ "ACOS",             TOKEN_OP_ACOS          },
+	{ "ASIN",             TOKEN_OP_ASIN          },
+	{ "ATAN",             TOKEN_OP_ATAN          },
+	{ "COSH",             TOKEN_OP_COSH          },
+	{ "SINH",             TOKEN_OP_SINH          },
+	{ "LN",               TOKEN_OP_LN            },
+	{ "LOG",              TOKEN_OP_LOG           },
+	{ "+",                TOKEN_OP_ADD           },
+	{ "-",                TOKEN_OP_SUBSTRACT     },
+	{ "*",                TOKEN_OP_MULTIPLY      },
+	{ "/",                TOKEN_OP_DIVIDE        },
+	{ "MOD",              TOKEN_OP_MOD           },
+	{ "POW",              TOKEN_OP_POW           },
+	{ "BIG",              TOKEN_OP_BIGGEST       },
+	{ "SMALL",            TOKEN_OP_SMALLEST      },
+	{ "RAND",             TOKEN_OP_RANDOM        },
+	{ "ITRPL",            TOKEN_OP_INTERPOLATE   },
+	{ "LIMIT",            TOKEN_OP_LIMIT         },
+
+	{ "CITRPL",           TOKEN_CL_INTERPOLATE   },
+	{ "RGB",              TOKEN_CL_RGB           },
+	{ "RGBA",             TOKEN_CL_RGBA          },
 
 	/* lead tokens */
 
-	{ "LET",           TOKEN_VAR_DECLARATION  },
-	{ "LET_APPEND",    TOKEN_VAR_APPEND       },
-	{ "LET_PREPEND",   TOKEN_VAR_PREPEND      },
-	{ "LET_MERGE",     TOKEN_VAR_MERGE        },
-	{ "LET_ENUM",      TOKEN_ENUM_DECLARATION },
-	{ "SECTION",       TOKEN_SECTION_BEGIN    },
-	{ "SECTION_ADD",   TOKEN_SECTION_ADD      },
-	{ "SECTION_DEL",   TOKEN_SECTION_DEL      },
-	{ "INCLUDE",       TOKEN_INCLUDE          },
-	{ "SEED",          TOKEN_SEED             },
-	{ "DEBUG_PRINT",   TOKEN_PRINT            },
-	{ "FOR_EACH",      TOKEN_FOR_BEGIN        },
-	{ "FOR_END",       TOKEN_FOR_END          },
-	{ "RESTRICT",      TOKEN_RESTRICT         },
+	{ "LET",              TOKEN_VAR_DECLARATION  },
+	{ "LET_APPEND",       TOKEN_VAR_APPEND       },
+	{ "LET_PREPEND",      TOKEN_VAR_PREPEND      },
+	{ "LET_MERGE",        TOKEN_VAR_MERGE        },
+	{ "LET_ENUM",         TOKEN_ENUM_DECLARATION },
+	{ "SECTION",          TOKEN_SECTION_BEGIN    },
+	{ "SECTION_ADD",      TOKEN_SECTION_ADD      },
+	{ "SECTION_DEL",      TOKEN_SECTION_DEL      },
+	{ "INCLUDE",          TOKEN_INCLUDE          },
+	{ "INCLUDE_PARALLEL", TOKEN_INCLUDE_PARALLEL },
+	{ "SEED",             TOKEN_SEED             },
+	{ "DEBUG_PRINT",      TOKEN_PRINT            },
+	{ "FOR_EACH",         TOKEN_FOR_BEGIN        },
+	{ "FOR_END",          TOKEN_FOR_END          },
+	{ "RESTRICT",         TOKEN_RESTRICT         },
 };
 
+/* keyword index built once for the whole process, map entries are looked up by length and first character */
+/* and chained together when they share both, each link being the map index + 1 (0 ends a chain)          */
+
+static pthread_once_t index_once = PTHREAD_ONCE_INIT;
+static uint8_t index_heads[TOKEN_KEY_MAX_LEN + 1][UCHAR_MAX + 1];
+static uint8_t index_next[MAP_N];
+
 /************************************************************************************************************/
 /* PRIVATE **************************************************************************************************/
 /************************************************************************************************************/
 
-cdict *
-token_dict_create(void)
+void
+token_view_init(struct token_view *view)
+{
+	view->heap     = NULL;
+	view->heap_cap = 0;
+
+	token_view_clear(view);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+token_view_free(struct token_view *view)
+{
+	free(view->heap);
+
+	view->heap     = NULL;
+	view->heap_cap = 0;
+
+	token_view_clear(view);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+bool
+token_view_append(struct token_view *view, const char *str, size_t n)
+{
+	char *tmp;
+
+	if (view->len >= TOKEN_MAX_LEN - 1)
+	{
+		n = 0;
+	}
+	else if (n > TOKEN_MAX_LEN - 1 - view->len)
+	{
+		n = TOKEN_MAX_LEN - 1 - view->len;
+	}
+
+	if (!(tmp = reserve(view, view->len + n)))
+	{
+		return false;
+	}
+
+	memcpy(tmp + view->len, str, n);
+	view->len += n;
+	tmp[view->len] = '\0';
+
+	return true;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+token_view_borrow(struct token_view *view, const char *str)
+{
+	view->chars = str;
+	view->len   = strlen(str);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+token_view_clear(struct token_view *view)
+{
+	view->local[0] = '\0';
+	view->chars    = view->local;
+	view->len      = 0;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+bool
+token_view_own(struct token_view *view)
 {
-	cdict *dict;
+	char *tmp;
 
-	dict = cdict_create();
+	if (!(tmp = reserve(view, view->len)))
+	{
+		return false;
+	}
+
+	tmp[view->len] = '\0';
+
+	return true;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+bool
+token_view_printf(struct token_view *view, const char *format, ...)
+{
+	va_list args;
+	char *tmp;
+	int n;
+
+	token_view_clear(view);
+
+	/* most formatted values are numbers, that fit in the local buffer on the first try */
+
+	va_start(args, format);
+	n = vsnprintf(view->local, TOKEN_LOCAL_LEN, format, args);
+	va_end(args);
+
+	if (n < 0)
+	{
+		token_view_clear(view);
+		return false;
+	}
+
+	if (n < TOKEN_LOCAL_LEN)
+	{
+		view->len = n;
+		return true;
+	}
+
+	if (n > TOKEN_MAX_LEN - 1)
+	{
+		n = TOKEN_MAX_LEN - 1;
+	}
 
-	cdict_prealloc(dict,   sizeof(map) / sizeof(struct slot));
-	for (size_t i = 0; i < sizeof(map) / sizeof(struct slot); i++)
+	if (!(tmp = reserve(view, n)))
 	{
-		cdict_write(dict, map[i].key, 0, map[i].type);
+		token_view_clear(view);
+		return false;
 	}
 
-	return dict;
+	va_start(args, format);
+	vsnprintf(tmp, n + 1, format, args);
+	va_end(args);
+
+	view->len = n;
+
+	return true;
 }
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 
 enum token
-token_match(cdict *token_dict, const char *token)
+token_match(const char *str)
 {
-	size_t id;
+	size_t n;
+	size_t i;
+
+	/* most words are plain values that can be discarded from their length or first character alone */
+
+	n = strnlen(str, TOKEN_KEY_MAX_LEN + 1);
+	if (n > TOKEN_KEY_MAX_LEN)
+	{
+		return TOKEN_STRING;
+	}
+
+	pthread_once(&index_once, index_build);
 
-	if (cdict_find(token_dict, token, 0, &id))
+	for (i = index_heads[n][(unsigned char)str[0]]; i > 0; i = index_next[i - 1])
 	{
-		return id;
+		if (!memcmp(map[i - 1].key, str, n))
+		{
+			return map[i - 1].type;
+		}
 	}
 
 	return TOKEN_STRING;
 }
+
+/************************************************************************************************************/
+/* STATIC ***************************************************************************************************/
+/************************************************************************************************************/
+
+static void
+index_build(void)
+{
+	size_t n;
+
+	/* entries are chained backwards so that chains follow the map order */
+
+	for (size_t i = MAP_N; i > 0; i--)
+	{
+		n = strlen(map[i - 1].key);
+		index_next[i - 1] = index_heads[n][(unsigned char)map[i - 1].key[0]];
+		index_heads[n][(unsigned char)map[i - 1].key[0]] = i;
+	}
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static char *
+reserve(struct token_view *view, size_t n)
+{
+	bool in_heap = view->heap && view->chars == view->heap;
+	char *tmp;
+	size_t cap;
+
+	/* text moves to the heap once it outgrows the local buffer, and stays there until the view is cleared */
+
+	if (!in_heap && n < TOKEN_LOCAL_LEN)
+	{
+		tmp = view->local;
+	}
+	else if (n < view->heap_cap)
+	{
+		tmp = view->heap;
+	}
+	else
+	{
+		for (cap = TOKEN_LOCAL_LEN * 2; cap <= n; cap *= 2);
+		if (!(tmp = realloc(view->heap, cap)))
+		{
+			return NULL;
+		}
+		view->heap     = tmp;
+		view->heap_cap = cap;
+		if (in_heap)
+		{
+			view->chars = tmp;
+		}
+	}
+
+	if (view->chars != tmp)
+	{
+		memmove(tmp, view->chars, view->len);
+		view->chars = tmp;
+	}
+
+	return tmp;
+}
@@ -21,8 +21,17 @@
 #pragma once
 
 #include <cassette/ccfg.h>
-#include <cassette/cobj.h>
 #include <limits.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+/************************************************************************************************************/
+/* GLOBALS **************************************************************************************************/
+/************************************************************************************************************/
+
+#define TOKEN_MAX_LEN     (1 << 20)
+#define TOKEN_LOCAL_LEN   256
+#define TOKEN_KEY_MAX_LEN 16
 
 /************************************************************************************************************/
 /* TYPES ****************************************************************************************************/
@@ -35,6 +44,7 @@ enum token
 	TOKEN_INVALID = 0,
 	TOKEN_STRING,
 	TOKEN_NUMBER,
+	TOKEN_COLOR,
 
 	/* substitution tokens */
 
@@ -100,6 +110,7 @@ enum token
 	TOKEN_SECTION_ADD,
 	TOKEN_SECTION_DEL,
 	TOKEN_INCLUDE,
+	TOKEN_INCLUDE_PARALLEL,
 	TOKEN_SEED,
 	TOKEN_PRINT,
 	TOKEN_FOR_BEGIN,
@@ -107,23 +118,91 @@ enum token
 	TOKEN_RESTRICT,
 };
 
+/**
+ * Token text. Words that reach the parser unchanged, from a compiled source, a variable, an iterator or a
+ * parameter, are borrowed from the book that holds them. Only the text that the lexer or a substitution
+ * produces gets copied, into the local buffer first, and onto the heap once it outgrows it.
+ */
+struct token_view
+{
+	const char *chars;
+	size_t len;
+	char *heap;
+	size_t heap_cap;
+	char local[TOKEN_LOCAL_LEN];
+};
+
 /************************************************************************************************************/
-/* GLOBALS **************************************************************************************************/
+/* CONSTRUCTORS / DESTRUCTORS *******************************************************************************/
 /************************************************************************************************************/
 
-#define TOKEN_MAX_LEN 256
+void
+token_view_init(struct token_view *view)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+token_view_free(struct token_view *view)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
 
 /************************************************************************************************************/
-/* CONSTRUCTORS / DESTRUCTORS *******************************************************************************/
+/* PROCEDURES ***********************************************************************************************/
 /************************************************************************************************************/
 
-cdict *
-token_dict_create(void);
+/**
+ * Appends n characters of str to the text, which gets copied into the view first if it was borrowed. Text
+ * longer than TOKEN_MAX_LEN - 1 is truncated. Returns false if memory could not be allocated.
+ */
+bool
+token_view_append(struct token_view *view, const char *str, size_t n)
+CCFG_NONNULL(1, 2)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Points the text to str without copying it. str has to outlive the view or the next change made to it.
+ */
+void
+token_view_borrow(struct token_view *view, const char *str)
+CCFG_NONNULL(1, 2)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+token_view_clear(struct token_view *view)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Copies borrowed text into the view, for when the book it comes from is about to be written to. Returns
+ * false if memory could not be allocated.
+ */
+bool
+token_view_own(struct token_view *view)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Replaces the text with a printf-style formatted string. Returns false if memory could not be allocated.
+ */
+bool
+token_view_printf(struct token_view *view, const char *format, ...)
+CCFG_NONNULL(1, 2)
+CCFG_HIDDEN;
 
 /************************************************************************************************************/
-/* FUNCTION *************************************************************************************************/
+/* FUNCTIONS ************************************************************************************************/
 /************************************************************************************************************/
 
 enum token
-token_match(cdict *token_dict, const char *str)
-CCFG_PURE;
+token_match(const char *str)
+CCFG_NONNULL(1);
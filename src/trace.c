@@ -0,0 +1,186 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#include <cassette/ccfg.h>
+#include <cassette/cobj.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "trace.h"
+#include "util.h"
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+static void fill (struct trace_file *, const struct stat *) CCFG_NONNULL(1);
+
+/************************************************************************************************************/
+/* PRIVATE **************************************************************************************************/
+/************************************************************************************************************/
+
+void
+trace_append(struct trace *trace, const struct trace *src, size_t from, size_t to)
+{
+	struct trace_file *tmp;
+
+	if (!(tmp = util_reserve(trace->files, &trace->files_cap, trace->files_n + to - from, sizeof(*tmp))))
+	{
+		trace->err = true;
+		return;
+	}
+
+	trace->files = tmp;
+
+	for (size_t i = from; i < to; i++)
+	{
+		cbook_write(trace->paths, cbook_word(src->paths, i));
+		trace->files[trace->files_n++] = src->files[i];
+	}
+
+	trace->err |= src->err;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+bool
+trace_changed(const struct trace *trace, const char *root, uint64_t hash)
+{
+	struct stat fs;
+
+	if (!trace->valid || trace->hash != hash || strcmp(cbook_word(trace->paths, 0), root))
+	{
+		return true;
+	}
+
+	for (size_t i = 0; i < trace->files_n; i++)
+	{
+		if (!trace_check(trace, i, &fs))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+bool
+trace_check(const struct trace *trace, size_t i, struct stat *fs)
+{
+	struct trace_file file;
+
+	fill(&file, stat(cbook_word(trace->paths, i), fs) == 0 ? fs : NULL);
+
+	return file.exists        == trace->files[i].exists
+	    && file.device        == trace->files[i].device
+	    && file.inode         == trace->files[i].inode
+	    && file.size          == trace->files[i].size
+	    && file.mtime.tv_sec  == trace->files[i].mtime.tv_sec
+	    && file.mtime.tv_nsec == trace->files[i].mtime.tv_nsec;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+trace_clear(struct trace *trace)
+{
+	cbook_clear(trace->paths);
+
+	trace->files_n = 0;
+	trace->hash    = 0;
+	trace->valid   = false;
+	trace->err     = false;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+trace_free(struct trace *trace)
+{
+	cbook_destroy(trace->paths);
+	free(trace->files);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+trace_init(struct trace *trace)
+{
+	trace->paths     = cbook_create();
+	trace->files     = NULL;
+	trace->files_n   = 0;
+	trace->files_cap = 0;
+	trace->hash      = 0;
+	trace->valid     = false;
+	trace->err       = false;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+trace_push(struct trace *trace, const char *path, const struct stat *fs)
+{
+	struct trace_file *tmp;
+
+	if (!(tmp = util_reserve(trace->files, &trace->files_cap, trace->files_n + 1, sizeof(*tmp))))
+	{
+		trace->err = true;
+		return;
+	}
+
+	trace->files = tmp;
+
+	cbook_write(trace->paths, path);
+	fill(trace->files + trace->files_n++, fs);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+trace_validate(struct trace *trace, uint64_t hash)
+{
+	trace->hash  = hash;
+	trace->valid = !trace->err && !cbook_error(trace->paths) && trace->files_n > 0;
+}
+
+/************************************************************************************************************/
+/* STATIC ***************************************************************************************************/
+/************************************************************************************************************/
+
+static void
+fill(struct trace_file *file, const struct stat *fs)
+{
+	if (!fs)
+	{
+		memset(file, 0, sizeof(*file));
+		return;
+	}
+
+	file->device = fs->st_dev;
+	file->inode  = fs->st_ino;
+	file->size   = fs->st_size;
+	file->mtime  = fs->st_mtim;
+	file->exists = true;
+}
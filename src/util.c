@@ -18,12 +18,48 @@
 /************************************************************************************************************/
 /************************************************************************************************************/
 
+#include <cassette/cobj.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
 #include "util.h"
 
 /************************************************************************************************************/
 /* PRIVATE **************************************************************************************************/
 /************************************************************************************************************/
 
+uint64_t
+util_clock(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+
+	return (uint64_t)t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+uint64_t
+util_hash(uint64_t hash, const void *data, size_t size)
+{
+	const unsigned char *bytes = data;
+
+	/* FNV-1a */
+
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
 double
 util_interpolate(double d_1, double d_2, double ratio)
 {
@@ -44,6 +80,38 @@ util_limit(double d, double lim_1, double lim_2)
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
 
+void *
+util_reserve(void *ptr, size_t *cap, size_t n, size_t size)
+{
+	size_t cap_new;
+
+	if (n <= *cap)
+	{
+		return ptr;
+	}
+
+	cap_new = *cap > 0 ? *cap : 8;
+	while (cap_new < n)
+	{
+		if (cap_new > SIZE_MAX / 2)
+		{
+			return NULL;
+		}
+		cap_new *= 2;
+	}
+
+	if (cap_new > SIZE_MAX / size || !(ptr = realloc(ptr, cap_new * size)))
+	{
+		return NULL;
+	}
+
+	*cap = cap_new;
+
+	return ptr;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
 void
 util_sort_pair(double *d_1, double *d_2)
 {
@@ -56,3 +124,16 @@ util_sort_pair(double *d_1, double *d_2)
 		*d_2 = tmp;
 	}
 }
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+double
+util_str_to_double(const char *str, bool *err)
+{
+	if (str[0] == '#')
+	{
+		return ccolor_to_argb_uint(ccolor_from_str(str, err));
+	}
+
+	return strtod(str, NULL);
+}
@@ -21,6 +21,9 @@
 #pragma once
 
 #include <cassette/ccfg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
 
 #if __GNUC__ > 4
 	#define CONST __attribute__((const))
@@ -28,10 +31,18 @@
 	#define CONST
 #endif
 
+#define UTIL_HASH_INIT 14695981039346656037ULL
+
 /************************************************************************************************************/
 /* PROCEDURES ***********************************************************************************************/
 /************************************************************************************************************/
 
+void *
+util_reserve(void *ptr, size_t *cap, size_t n, size_t size)
+CCFG_NONNULL(2);
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
 void
 util_sort_pair(double *d_1, double *d_2)
 CCFG_NONNULL(1, 2);
@@ -40,6 +51,22 @@ CCFG_NONNULL(1, 2);
 /* FUNCTIONS ************************************************************************************************/
 /************************************************************************************************************/
 
+/**
+ * Returns the time elapsed since an arbitrary point in the past, in nanoseconds, as given by the monotonic
+ * clock.
+ */
+uint64_t
+util_clock(void);
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+uint64_t
+util_hash(uint64_t hash, const void *data, size_t size)
+CCFG_NONNULL(2)
+CCFG_PURE;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
 double
 util_interpolate(double d_1, double d_2, double ratio)
 CONST;
@@ -49,3 +76,9 @@ CONST;
 double
 util_limit(double d, double lim_1, double lim_2)
 CONST;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+double
+util_str_to_double(const char *str, bool *err)
+CCFG_NONNULL(1, 2);
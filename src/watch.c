@@ -0,0 +1,271 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#include <cassette/ccfg.h>
+#include <cassette/cobj.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#endif
+
+#include "trace.h"
+#include "util.h"
+#include "watch.h"
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#if defined(__linux__)
+#define WATCH_MASK (IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_MOVED_FROM | \
+                    IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR)
+#endif
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+static void add    (struct watch *, const char *) CCFG_NONNULL(1, 2);
+static void forget (struct watch *)               CCFG_NONNULL(1);
+
+/************************************************************************************************************/
+/* PRIVATE **************************************************************************************************/
+/************************************************************************************************************/
+
+void
+watch_arm(struct watch *watch, const struct trace *trace, const cbook *sources)
+{
+	if (watch->fd < 0)
+	{
+		return;
+	}
+
+	forget(watch);
+
+	/* sources that could not be opened are watched too, so that a preferred one showing up gets noticed */
+
+	for (size_t i = 0; i < cbook_words_number(trace->paths); i++)
+	{
+		add(watch, cbook_word(trace->paths, i));
+	}
+
+	for (size_t i = 0; i < cbook_words_number(sources); i++)
+	{
+		add(watch, cbook_word(sources, i));
+	}
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+bool
+watch_drain(struct watch *watch)
+{
+#if defined(__linux__)
+
+	_Alignas(struct inotify_event) char buffer[4096];
+	const struct inotify_event *event;
+	ssize_t n;
+	ssize_t i;
+	bool changed = false;
+
+	if (watch->fd < 0)
+	{
+		return false;
+	}
+
+	/* all queued events are read at once, so that a burst of writes only leads to a single reload */
+
+	while ((n = read(watch->fd, buffer, sizeof(buffer))) > 0)
+	{
+		for (i = 0; i < n; i += sizeof(struct inotify_event) + event->len)
+		{
+			event = (const struct inotify_event*)(buffer + i);
+			if (event->mask & (IN_Q_OVERFLOW | IN_DELETE_SELF | IN_MOVE_SELF))
+			{
+				changed = true;
+			}
+			else if (event->len > 0 && cdict_find(watch->keys_names, event->name, 0, NULL))
+			{
+				changed = true;
+			}
+		}
+	}
+
+	return changed;
+
+#else
+
+	(void)watch;
+
+	return false;
+
+#endif
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+watch_free(struct watch *watch)
+{
+	if (watch->fd >= 0)
+	{
+		close(watch->fd);
+	}
+
+	free(watch->dirs);
+	cdict_destroy(watch->keys_names);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+watch_init(struct watch *watch)
+{
+	watch->fd         = -1;
+	watch->dirs       = NULL;
+	watch->dirs_n     = 0;
+	watch->dirs_cap   = 0;
+	watch->keys_names = cdict_create();
+	watch->err        = false;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+bool
+watch_open(struct watch *watch)
+{
+#if defined(__linux__)
+
+	if (watch->fd < 0)
+	{
+		watch->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	}
+
+	return watch->fd >= 0;
+
+#else
+
+	(void)watch;
+
+	return false;
+
+#endif
+}
+
+/************************************************************************************************************/
+/* STATIC ***************************************************************************************************/
+/************************************************************************************************************/
+
+static void
+add(struct watch *watch, const char *path)
+{
+#if defined(__linux__)
+
+	char dir[PATH_MAX];
+	const char *name;
+	size_t n;
+	int *tmp;
+	int wd;
+
+	if ((name = strrchr(path, '/')))
+	{
+		n = name - path;
+		name++;
+	}
+	else
+	{
+		n = 0;
+		name = path;
+	}
+
+	if (n >= PATH_MAX - 1 || name[0] == '\0')
+	{
+		return;
+	}
+
+	/* files at the root of the filesystem keep their leading slash as directory */
+
+	if (n == 0)
+	{
+		strcpy(dir, name == path ? "." : "/");
+	}
+	else
+	{
+		memcpy(dir, path, n);
+		dir[n] = '\0';
+	}
+
+	cdict_write(watch->keys_names, name, 0, 0);
+
+	/* a directory already being watched gives back the same descriptor, which only needs to be kept once */
+
+	if ((wd = inotify_add_watch(watch->fd, dir, WATCH_MASK)) < 0)
+	{
+		return;
+	}
+
+	for (size_t i = 0; i < watch->dirs_n; i++)
+	{
+		if (watch->dirs[i] == wd)
+		{
+			return;
+		}
+	}
+
+	if (!(tmp = util_reserve(watch->dirs, &watch->dirs_cap, watch->dirs_n + 1, sizeof(int))))
+	{
+		watch->err = true;
+		return;
+	}
+
+	watch->dirs = tmp;
+	watch->dirs[watch->dirs_n++] = wd;
+
+#else
+
+	(void)watch;
+	(void)path;
+
+#endif
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+forget(struct watch *watch)
+{
+#if defined(__linux__)
+
+	for (size_t i = 0; i < watch->dirs_n; i++)
+	{
+		inotify_rm_watch(watch->fd, watch->dirs[i]);
+	}
+
+#endif
+
+	watch->dirs_n = 0;
+
+	cdict_clear(watch->keys_names);
+}
@@ -0,0 +1,98 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#pragma once
+
+#include <cassette/ccfg.h>
+#include <cassette/cobj.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "trace.h"
+
+/************************************************************************************************************/
+/* TYPES ****************************************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * Change notifier over the files a load read from. The directories holding the files are watched rather
+ * than the files themselves, so that files replaced by a rename, or that did not exist yet, get noticed as
+ * well. Events are then filtered by the names of the traced files.
+ */
+struct watch
+{
+	int fd;
+	int *dirs;
+	size_t dirs_n;
+	size_t dirs_cap;
+	cdict *keys_names;
+	bool err;
+};
+
+/************************************************************************************************************/
+/* CONSTRUCTORS / DESTRUCTORS *******************************************************************************/
+/************************************************************************************************************/
+
+void
+watch_init(struct watch *watch)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void
+watch_free(struct watch *watch)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/************************************************************************************************************/
+/* PROCEDURES ***********************************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * Replaces the watched files with the ones of the given trace and the candidate sources. Does nothing until
+ * watch_open() succeeded.
+ */
+void
+watch_arm(struct watch *watch, const struct trace *trace, const cbook *sources)
+CCFG_NONNULL(1, 2, 3)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Reads every pending event without blocking. Returns true if at least one of them concerns a watched file,
+ * or if some events got lost.
+ */
+bool
+watch_drain(struct watch *watch)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+/**
+ * Creates the notification descriptor if it does not exist yet. Returns false if the platform does not
+ * support it.
+ */
+bool
+watch_open(struct watch *watch)
+CCFG_NONNULL(1)
+CCFG_HIDDEN;
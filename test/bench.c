@@ -0,0 +1,489 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#include <cassette/ccfg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#define KEY_LEN      64
+#define MIN_RUNS     3
+#define NAME_MAX_LEN 512
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+struct key
+{
+	char namespace[KEY_LEN];
+	char property[KEY_LEN];
+};
+
+struct scenario
+{
+	const char *name;
+	void (*generate)(FILE *, const char *);
+};
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+static void   bench          (const struct scenario *, const char *, double);
+static double elapsed        (const struct timespec *);
+static FILE * file_open      (const char *, const char *);
+static void   gen_flat       (FILE *, const char *);
+static void   gen_includes   (FILE *, const char *);
+static void   gen_includes_n (const char *, size_t, size_t, size_t *);
+static void   gen_loops      (FILE *, const char *);
+static void   gen_math       (FILE *, const char *);
+static void   gen_vars       (FILE *, const char *);
+static double measure_fetch  (ccfg *, double);
+static void   push_key       (const char *, const char *);
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+static const struct scenario scenarios[] =
+{
+	{ "flat",     gen_flat     },
+	{ "includes", gen_includes },
+	{ "loops",    gen_loops    },
+	{ "math",     gen_math     },
+	{ "vars",     gen_vars     },
+};
+
+static struct key *keys = NULL;
+static size_t keys_n = 0;
+static size_t keys_cap = 0;
+static size_t bytes = 0;
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * Throughput benchmark. Each scenario generates its own corpus into the given directory, then runs in a
+ * separate process so that its peak memory usage is measured independently from the other ones. Results are
+ * written to stdout as CSV, one line per scenario:
+ *
+ * scenario           : corpus name
+ * bytes              : total size of the files read by a single load
+ * loads_cold         : loads per second, with a new config instance created and destroyed for each load
+ * loads_warm         : loads per second, reloading the same config instance
+ * mib_warm           : source MiB per second processed by warm loads
+ * resources          : number of resources looked up in the fetch measurements
+ * ns_fetch           : nanoseconds per ccfg_fetch() and full ccfg_iterate() / ccfg_resource() loop
+ * ns_fetch_frozen    : same, after ccfg_freeze()
+ * peak_rss_kib       : peak resident memory of the scenario process
+ *
+ * Usage : bench DIRECTORY [SECONDS_PER_MEASUREMENT]
+ */
+
+/************************************************************************************************************/
+/* MAIN *****************************************************************************************************/
+/************************************************************************************************************/
+
+int
+main(int argc, char **argv)
+{
+	double duration = 1.0;
+	pid_t pid;
+	int status;
+
+	if (argc < 2)
+	{
+		fprintf(stderr, "usage : %s DIRECTORY [SECONDS_PER_MEASUREMENT]\n", argv[0]);
+		return 1;
+	}
+
+	if (argc > 2 && (duration = strtod(argv[2], NULL)) <= 0.0)
+	{
+		duration = 1.0;
+	}
+
+	mkdir(argv[1], 0755);
+
+	printf("scenario,bytes,loads_cold,loads_warm,mib_warm,resources,ns_fetch,ns_fetch_frozen,peak_rss_kib\n");
+	fflush(stdout);
+
+	for (size_t i = 0; i < sizeof(scenarios) / sizeof(struct scenario); i++)
+	{
+		if ((pid = fork()) < 0)
+		{
+			return 1;
+		}
+
+		if (pid == 0)
+		{
+			bench(scenarios + i, argv[1], duration);
+			fflush(stdout);
+			_exit(0);
+		}
+
+		if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status))
+		{
+			fprintf(stderr, "scenario %s failed\n", scenarios[i].name);
+		}
+	}
+
+	return 0;
+}
+
+/************************************************************************************************************/
+/* STATIC ***************************************************************************************************/
+/************************************************************************************************************/
+
+static void
+bench(const struct scenario *scenario, const char *dir, double duration)
+{
+	struct timespec t;
+	struct rusage usage;
+	char root[NAME_MAX_LEN];
+	ccfg *cfg;
+	FILE *f;
+	double cold;
+	double warm;
+	double fetch;
+	double fetch_frozen;
+	size_t runs;
+
+	/* corpus generation */
+
+	snprintf(root, NAME_MAX_LEN, "%s/%s.ccfg", dir, scenario->name);
+
+	if (!(f = file_open(root, "w")))
+	{
+		_exit(1);
+	}
+
+	scenario->generate(f, dir);
+	bytes += ftell(f);
+	fclose(f);
+
+	/* cold loads */
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	for (runs = 0; runs < MIN_RUNS || elapsed(&t) < duration; runs++)
+	{
+		cfg = ccfg_create();
+		ccfg_push_source(cfg, root);
+		ccfg_load(cfg);
+		ccfg_destroy(cfg);
+	}
+	cold = runs / elapsed(&t);
+
+	/* warm loads */
+
+	cfg = ccfg_create();
+	ccfg_push_source(cfg, root);
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	for (runs = 0; runs < MIN_RUNS || elapsed(&t) < duration; runs++)
+	{
+		ccfg_load(cfg);
+	}
+	warm = runs / elapsed(&t);
+
+	/* lookups */
+
+	if (ccfg_error(cfg))
+	{
+		_exit(1);
+	}
+
+	fetch = measure_fetch(cfg, duration);
+	ccfg_freeze(cfg);
+	fetch_frozen = measure_fetch(cfg, duration);
+
+	ccfg_destroy(cfg);
+
+	/* results */
+
+	getrusage(RUSAGE_SELF, &usage);
+
+	printf(
+		"%s,%zu,%.1f,%.1f,%.2f,%zu,%.1f,%.1f,%ld\n",
+		scenario->name,
+		bytes,
+		cold,
+		warm,
+		warm * bytes / (1024.0 * 1024.0),
+		keys_n,
+		fetch,
+		fetch_frozen,
+		usage.ru_maxrss);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static double
+elapsed(const struct timespec *start)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+
+	return (t.tv_sec - start->tv_sec) + (t.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static FILE *
+file_open(const char *name, const char *mode)
+{
+	FILE *f;
+
+	if (!(f = fopen(name, mode)))
+	{
+		fprintf(stderr, "could not open %s\n", name);
+	}
+
+	return f;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+gen_flat(FILE *f, const char *dir)
+{
+	char namespace[KEY_LEN];
+	char property[KEY_LEN];
+
+	(void)dir;
+
+	/* large file of plain resources with a few values each */
+
+	for (size_t i = 0; i < 500; i++)
+	{
+		snprintf(namespace, KEY_LEN, "widget_%zu", i);
+		for (size_t j = 0; j < 100; j++)
+		{
+			snprintf(property, KEY_LEN, "property_%zu", j);
+			fprintf(f, "%s %s value_%zu %zu %zu.5 #%06zx\n", namespace, property, j, i, j, i * j);
+			push_key(namespace, property);
+		}
+	}
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+gen_includes(FILE *f, const char *dir)
+{
+	char name[NAME_MAX_LEN];
+	size_t id = 0;
+
+	/* tree of files 6 levels deep, each file including 3 children */
+
+	snprintf(name, NAME_MAX_LEN, "%s/includes", dir);
+	mkdir(name, 0755);
+
+	fprintf(f, "INCLUDE includes/0.ccfg\n");
+
+	gen_includes_n(dir, 6, 3, &id);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+gen_includes_n(const char *dir, size_t depth, size_t fanout, size_t *id)
+{
+	char name[NAME_MAX_LEN];
+	char namespace[KEY_LEN];
+	char property[KEY_LEN];
+	size_t self = (*id)++;
+	FILE *f;
+
+	snprintf(name, NAME_MAX_LEN, "%s/includes/%zu.ccfg", dir, self);
+
+	if (!(f = file_open(name, "w")))
+	{
+		_exit(1);
+	}
+
+	snprintf(namespace, KEY_LEN, "file_%zu", self);
+
+	fprintf(f, "LET depth %zu\n", depth);
+	for (size_t i = 0; i < 20; i++)
+	{
+		snprintf(property, KEY_LEN, "property_%zu", i);
+		fprintf(f, "%s %s ($ depth) value_%zu\n", namespace, property, i);
+		push_key(namespace, property);
+	}
+
+	for (size_t i = 0; depth > 1 && i < fanout; i++)
+	{
+		fprintf(f, "INCLUDE %zu.ccfg\n", *id);
+		gen_includes_n(dir, depth - 1, fanout, id);
+	}
+
+	bytes += ftell(f);
+	fclose(f);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+gen_loops(FILE *f, const char *dir)
+{
+	char namespace[KEY_LEN];
+	char property[KEY_LEN];
+
+	(void)dir;
+
+	/* 3 nested iterations over 20 values each */
+
+	fprintf(f, "LET_ENUM a 0 19\n");
+	fprintf(f, "LET_ENUM b 0 19\n");
+	fprintf(f, "LET_ENUM c 0 19\n");
+	fprintf(f, "FOR_EACH a\n");
+	fprintf(f, "\tFOR_EACH b\n");
+	fprintf(f, "\t\tFOR_EACH c\n");
+	fprintf(f, "\t\t\t(JOIN loop_ (%% a)) (JOIN (%% b) (JOIN _ (%% c))) (* (%% b) (%% c)) (%% a)\n");
+	fprintf(f, "\t\tFOR_END\n");
+	fprintf(f, "\tFOR_END\n");
+	fprintf(f, "FOR_END\n");
+
+	for (size_t i = 0; i < 20; i++)
+	{
+		snprintf(namespace, KEY_LEN, "loop_%zu", i);
+		for (size_t j = 0; j < 400; j++)
+		{
+			snprintf(property, KEY_LEN, "%zu_%zu", j / 20, j % 20);
+			push_key(namespace, property);
+		}
+	}
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+gen_math(FILE *f, const char *dir)
+{
+	char property[KEY_LEN];
+
+	(void)dir;
+
+	/* nested arithmetic and color functions */
+
+	for (size_t i = 0; i < 10000; i++)
+	{
+		snprintf(property, KEY_LEN, "property_%zu", i);
+		fprintf(
+			f,
+			"math %s (+ %zu (* 2.5 (/ %zu 3))) (SQRT (POW %zu 2)) "
+			"(RGB (MOD %zu 256) 128 64) (CITRPL #000000 #ffff8000 0.%zu)\n",
+			property, i, i, i, i, i % 10);
+		push_key("math", property);
+	}
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+gen_vars(FILE *f, const char *dir)
+{
+	char property[KEY_LEN];
+
+	(void)dir;
+
+	/* many variables, each one injected into a resource */
+
+	for (size_t i = 0; i < 5000; i++)
+	{
+		fprintf(f, "LET var_%zu value_%zu %zu\n", i, i, i);
+	}
+
+	for (size_t i = 0; i < 5000; i++)
+	{
+		snprintf(property, KEY_LEN, "property_%zu", i);
+		fprintf(f, "vars %s ($ var_%zu) ($ var_%zu)\n", property, i, (i * 7) % 5000);
+		push_key("vars", property);
+	}
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static double
+measure_fetch(ccfg *cfg, double duration)
+{
+	struct timespec t;
+	size_t runs;
+	size_t sum = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	for (runs = 0; runs < MIN_RUNS || elapsed(&t) < duration; runs++)
+	{
+		for (size_t i = 0; i < keys_n; i++)
+		{
+			ccfg_fetch(cfg, keys[i].namespace, keys[i].property);
+			while (ccfg_iterate(cfg))
+			{
+				sum += ccfg_resource(cfg)[0];
+			}
+		}
+	}
+
+	/* keep the compiler from optimizing the reads away */
+
+	if (sum == 1)
+	{
+		fprintf(stderr, "\n");
+	}
+
+	return elapsed(&t) * 1e9 / (runs * (keys_n > 0 ? keys_n : 1));
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+push_key(const char *namespace, const char *property)
+{
+	struct key *tmp;
+
+	if (keys_n == keys_cap)
+	{
+		keys_cap = keys_cap > 0 ? keys_cap * 2 : 256;
+		if (!(tmp = realloc(keys, keys_cap * sizeof(struct key))))
+		{
+			_exit(1);
+		}
+		keys = tmp;
+	}
+
+	snprintf(keys[keys_n].namespace, KEY_LEN, "%s", namespace);
+	snprintf(keys[keys_n].property,  KEY_LEN, "%s", property);
+
+	keys_n++;
+}
@@ -0,0 +1,209 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#include <cassette/ccfg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+static bool compare   (ccfg *, void (*)(ccfg *, const char *, size_t, size_t), const char *, size_t, size_t);
+static void feed_cut  (ccfg *, const char *, size_t, size_t);
+static void feed_even (ccfg *, const char *, size_t, size_t);
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+/* words, quotes, comments, escapes and FOR_EACH blocks, the constructs the stream scanner has to follow */
+
+static const char *const sources[] =
+{
+	"LET colors #ff0000 #00ff00 #0000ff\n"
+	"LET_ENUM idx 0 2\n"
+	"LET names a b c\n"
+	"SECTION_ADD Main\n"
+	"SECTION Main\n"
+	"m v1 (+ 1 2) (* 3 4.5) (/ 1 3) (POW 2 10)\n"
+	"m v2 JOIN a JOIN b c \"quoted word\" 'single q' \"quoted ( ) word\" after\n"
+	"m v3 \\ JOIN a b\n"
+	"m v4 multi \\\n"
+	"   line \\\n"
+	"   seq\n"
+	"m v5 \\\n"
+	"FOR_EACH not a block\n"
+	"m v6 \\\n"
+	"// not a comment\n"
+	"m v7 a \\ \n"
+	"m v8 b \\ \\\n"
+	"m v9 c // comment \"with an open quote\n"
+	"m v10 $ colors \\\n"
+	"   (JOIN $ names) \\\n"
+	"   end\n"
+	"FOR_EACH idx i\n"
+	"	FOR_EACH names n\n"
+	"		(JOIN g (% i)) (% n) (* (% i) 2) $ colors\n"
+	"	FOR_END\n"
+	"	loop (% i) \"FOR_END\"\n"
+	"FOR_END\n"
+	"SECTION Other\n"
+	"m skipped 1 \\\n"
+	"m still_skipped 1\n"
+	"SECTION\n"
+	"m v11 (== 1 1 yes no) (STREQ a a same diff)\n"
+	"m v12 a EOS comment\n"
+	"m v13 EOF after\n"
+	"m v14 never\n",
+
+	/* newlines inside quotes, a failed sequence skips to them as to line ends */
+
+	"LET names a b c\n"
+	"m v1 JOIN a \"multi\n"
+	"line\" after\n"
+	"m v2 (% n) \"multi\n"
+	"line\" skipped\n"
+	"FOR_EACH names n\n"
+	"\tloop (% n) \"FOR_END\n"
+	"FOR_END\"\n"
+	"FOR_END\n"
+	"m v3 end\n",
+
+	/* escapes inside FOR_EACH blocks, iterated sequences then read on from the lines after the block */
+
+	"LET va a\n"
+	"FOR_EACH va i0\n"
+	"\tn1 p5 \\ JOIN // c\n"
+	"FOR_END\n"
+	"n2 p5  \\\n"
+	"x y z\n",
+
+	"LET va a\n"
+	"FOR_EACH va i0\n"
+	"\tn1 p1 x \\\n"
+	"\t  more\n"
+	"FOR_END\n"
+	"LET w b\n"
+	"n0 p3 $ w\n",
+};
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * Stream loading test. Each source above is handed over to ccfg_stream_feed() cut in two at every position,
+ * then in chunks of every size, and each result is compared with ccfg_load_internal() on the same source,
+ * through the changes reported by change tracking. Mismatches are written to stderr.
+ *
+ * Usage : chunks
+ */
+
+/************************************************************************************************************/
+/* MAIN *****************************************************************************************************/
+/************************************************************************************************************/
+
+int
+main(void)
+{
+	ccfg *cfg;
+	size_t fails = 0;
+
+	cfg = ccfg_create();
+	ccfg_set_change_tracking(cfg, true);
+
+	for (size_t j = 0; j < sizeof(sources) / sizeof(*sources); j++)
+	{
+		for (size_t i = 1; i < strlen(sources[j]); i++)
+		{
+			fails += !compare(cfg, feed_cut, "cut", j, i);
+		}
+
+		for (size_t i = 1; i <= strlen(sources[j]); i++)
+		{
+			fails += !compare(cfg, feed_even, "chunk", j, i);
+		}
+	}
+
+	if (ccfg_error(cfg))
+	{
+		fprintf(stderr, "config error %i\n", ccfg_error(cfg));
+		fails++;
+	}
+
+	ccfg_destroy(cfg);
+
+	printf("%zu stream loads differ from the internal load\n", fails);
+
+	return fails > 0;
+}
+
+/************************************************************************************************************/
+/* STATIC ***************************************************************************************************/
+/************************************************************************************************************/
+
+static bool
+compare(ccfg *cfg, void (*feed)(ccfg *, const char *, size_t, size_t), const char *mode, size_t j, size_t i)
+{
+	struct ccfg_change change;
+
+	/* the internal load is the reference the stream load gets compared to */
+
+	ccfg_load_internal(cfg, sources[j]);
+	feed(cfg, sources[j], i, strlen(sources[j]));
+
+	if (!ccfg_get_change(cfg, 0, &change))
+	{
+		return true;
+	}
+
+	fprintf(stderr, "source %zu, %s %zu : resource %s %s differs\n", j, mode, i, change.namespace, change.property);
+
+	return false;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+feed_cut(ccfg *cfg, const char *source, size_t i, size_t n)
+{
+	ccfg_stream_begin(cfg);
+	ccfg_stream_feed(cfg, source, i);
+	ccfg_stream_feed(cfg, source + i, n - i);
+	ccfg_stream_end(cfg);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static void
+feed_even(ccfg *cfg, const char *source, size_t size, size_t n)
+{
+	ccfg_stream_begin(cfg);
+
+	for (size_t i = 0; i < n; i += size)
+	{
+		ccfg_stream_feed(cfg, source + i, n - i < size ? n - i : size);
+	}
+
+	ccfg_stream_end(cfg);
+}
@@ -20,13 +20,33 @@
 
 #define _GNU_SOURCE
 
+#include "cache.c"
+#include "channel.c"
 #include "context.c"
+#include "diff.c"
+#include "feed.c"
+#include "freeze.c"
+#include "intern.c"
+#include "loop.c"
 #include "source.c"
 #include "main.c"
+#include "lazy.c"
+#include "memo.c"
+#include "numbers.c"
+#include "pool.c"
+#include "profile.c"
+#include "scan.c"
 #include "sequence.c"
+#include "share.c"
+#include "snapshot.c"
+#include "stats.c"
+#include "stream.c"
 #include "substitution.c"
+#include "taint.c"
 #include "token.c"
+#include "trace.c"
 #include "util.c"
+#include "watch.c"
 
 /************************************************************************************************************/
 /************************************************************************************************************/
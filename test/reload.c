@@ -0,0 +1,176 @@
+/**
+ * Copyright © 2024 Fraawlen <fraawlen@posteo.net>
+ *
+ * This file is part of the Cassette Configuration (CCFG) library.
+ *
+ * This library is free software; you can redistribute it and/or modify it either under the terms of the GNU
+ * Lesser General Public License as published by the Free Software Foundation; either version 2.1 of the
+ * License or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ * See the LGPL for the specific language governing rights and limitations.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+#include <cassette/ccfg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+static bool compare (ccfg *, const char *, size_t, const char *);
+static bool save    (const char *, const char *);
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+/* sources whose compiled stream has to be replayed the same way the raw source gets lexed */
+
+static const char *const sources[] =
+{
+	/* escaped newline at the end of an iteration body, in a file without a final newline */
+
+	"LET vc a b\n"
+	"FOR_EACH vc i0\n"
+	"\tn0 p1 0x1f \\\n"
+	"\t  more\n"
+	"FOR_END\n"
+	"x y z",
+
+	/* same, with a final newline and a line left for the escape to read */
+
+	"LET vc a b\n"
+	"FOR_EACH vc i0\n"
+	"\tn0 p1 0x1f \\\n"
+	"FOR_END\n"
+	"x y z\n"
+	"k l m\n",
+
+	/* escapes and quoted newlines outside of iterations */
+
+	"m v1 multi \\\n"
+	"   line \\\n"
+	"   seq\n"
+	"m v2 \"quoted\n"
+	"newline\" after\n"
+	"m v3 a \\ \\\n"
+	"m v4 end \\",
+};
+
+/************************************************************************************************************/
+/************************************************************************************************************/
+/************************************************************************************************************/
+
+/**
+ * Reload test. Each source above is written to a file, loaded twice with ccfg_load(), the second load
+ * replaying the token stream compiled by the first one, and both results are compared with
+ * ccfg_load_internal() on the same source, through the changes reported by change tracking. Mismatches are
+ * written to stderr.
+ *
+ * Usage : reload
+ */
+
+/************************************************************************************************************/
+/* MAIN *****************************************************************************************************/
+/************************************************************************************************************/
+
+int
+main(void)
+{
+	char path[] = "/tmp/ccfg-reload-XXXXXX";
+	ccfg *cfg;
+	size_t fails = 0;
+	int fd;
+
+	if ((fd = mkstemp(path)) < 0)
+	{
+		fprintf(stderr, "failed to create %s\n", path);
+		return 1;
+	}
+
+	close(fd);
+
+	cfg = ccfg_create();
+	ccfg_set_change_tracking(cfg, true);
+	ccfg_push_source(cfg, path);
+
+	for (size_t i = 0; i < sizeof(sources) / sizeof(*sources); i++)
+	{
+		if (!save(path, sources[i]))
+		{
+			fprintf(stderr, "failed to write %s\n", path);
+			fails++;
+			continue;
+		}
+
+		fails += !compare(cfg, sources[i], i, "first");
+		fails += !compare(cfg, sources[i], i, "second");
+	}
+
+	if (ccfg_error(cfg))
+	{
+		fprintf(stderr, "config error %i\n", ccfg_error(cfg));
+		fails++;
+	}
+
+	ccfg_destroy(cfg);
+	unlink(path);
+
+	printf("%zu file loads differ from the internal load\n", fails);
+
+	return fails > 0;
+}
+
+/************************************************************************************************************/
+/* STATIC ***************************************************************************************************/
+/************************************************************************************************************/
+
+static bool
+compare(ccfg *cfg, const char *source, size_t i, const char *load)
+{
+	struct ccfg_change change;
+
+	/* the internal load is the reference the file load gets compared to */
+
+	ccfg_load_internal(cfg, source);
+	ccfg_load(cfg);
+
+	if (!ccfg_get_change(cfg, 0, &change))
+	{
+		return true;
+	}
+
+	fprintf(stderr, "source %zu, %s load : resource %s %s differs\n", i, load, change.namespace, change.property);
+
+	return false;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+static bool
+save(const char *path, const char *source)
+{
+	FILE *f;
+	bool ok;
+
+	if (!(f = fopen(path, "w")))
+	{
+		return false;
+	}
+
+	ok = fputs(source, f) >= 0;
+
+	return fclose(f) == 0 && ok;
+}